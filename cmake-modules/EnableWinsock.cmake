@@ -13,13 +13,11 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-function(enable_portable_math target)
-    include(CheckFunctionExists)
-
-    check_function_exists(log2 HAS_LOG2)
-    check_function_exists(fmin HAS_FMIN)
-
-    if(NOT HAS_LOG2 OR NOT HAS_FMIN)
-        target_link_libraries(${target} PRIVATE m)
+function(enable_winsock target)
+    if(NOT WIN32)
+        return()
     endif()
+
+    # `htonl()`, `inet_ntoa()` & co. live in the Winsock library
+    target_link_libraries(${target} PRIVATE ws2_32)
 endfunction()
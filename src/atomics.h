@@ -0,0 +1,154 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MERGE_IP_ATOMICS_H
+#define MERGE_IP_ATOMICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #include <windows.h>
+#endif
+
+
+// The counters shared between threads. They're accessed only by the functions below,
+// so the code doesn't depend on <stdatomic.h>, which older MSVC versions lack.
+typedef volatile size_t AtomicSize;
+
+
+/**
+ * @brief Reads the counter, so the writes which precede the matching
+ *        `store_release()` in another thread are visible after it.
+ *
+ * @param counter A pointer to the counter.
+ * @return The value of the counter.
+ */
+static inline size_t load_acquire(const AtomicSize *counter) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+#elif defined(_WIN64)
+    return (size_t)_InterlockedCompareExchange64((volatile __int64 *)counter, 0, 0);
+#else
+    return (size_t)_InterlockedCompareExchange((volatile long *)counter, 0, 0);
+#endif
+}
+
+
+/**
+ * @brief Writes the counter after all the preceding writes of the thread.
+ *
+ * @param counter A pointer to the counter.
+ * @param value The new value.
+ */
+static inline void store_release(AtomicSize *counter, const size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(counter, value, __ATOMIC_RELEASE);
+#elif defined(_WIN64)
+    _InterlockedExchange64((volatile __int64 *)counter, (__int64)value);
+#else
+    _InterlockedExchange((volatile long *)counter, (long)value);
+#endif
+}
+
+
+
+/**
+ * @brief Reads the counter without ordering any other memory access.
+ *
+ * @param counter A pointer to the counter.
+ * @return The value of the counter.
+ */
+static inline size_t load_relaxed(const AtomicSize *counter) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+#else
+    return *counter;
+#endif
+}
+
+
+/**
+ * @brief Writes the counter without ordering any other memory access.
+ *
+ * @param counter A pointer to the counter.
+ * @param value The new value.
+ */
+static inline void store_relaxed(AtomicSize *counter, const size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+#else
+    *counter = value;
+#endif
+}
+
+
+/**
+ * @brief Replaces the counter if it still has the expected value.
+ *
+ * The operation is sequentially consistent.
+ *
+ * @param counter A pointer to the counter.
+ * @param expected The value the counter must have.
+ * @param value The new value.
+ * @return true if the counter is replaced; false otherwise.
+ */
+static inline bool compare_exchange(AtomicSize *counter, size_t expected, const size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_compare_exchange_n(counter, &expected, value, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+#elif defined(_WIN64)
+    return (size_t)_InterlockedCompareExchange64((volatile __int64 *)counter, (__int64)value, (__int64)expected)
+        == expected;
+#else
+    return (size_t)_InterlockedCompareExchange((volatile long *)counter, (long)value, (long)expected) == expected;
+#endif
+}
+
+
+/**
+ * @brief Adds the value to the counter.
+ *
+ * The operation is sequentially consistent.
+ *
+ * @param counter A pointer to the counter.
+ * @param value The value to add (it wraps around, so subtracting is adding `-value`).
+ * @return The value of the counter after the addition.
+ */
+static inline size_t add_and_fetch(AtomicSize *counter, const size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_add_fetch(counter, value, __ATOMIC_SEQ_CST);
+#elif defined(_WIN64)
+    return (size_t)_InterlockedExchangeAdd64((volatile __int64 *)counter, (__int64)value) + value;
+#else
+    return (size_t)_InterlockedExchangeAdd((volatile long *)counter, (long)value) + value;
+#endif
+}
+
+
+/**
+ * @brief Orders all the preceding memory accesses before all the following ones.
+ */
+static inline void full_fence(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+    MemoryBarrier();
+#endif
+}
+
+#endif //MERGE_IP_ATOMICS_H
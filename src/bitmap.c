@@ -0,0 +1,286 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bitmap.h"
+#include "bits.h"
+
+
+#define PAGE_OFFSET_MASK ((1u << BITMAP_PAGE_BITS) - 1)
+#define ALL_ONES 0xFFFFFFFF
+#define ALL_BITS (~(uint64_t)0)
+
+// the pages covered completely don't need a bitmap
+static uint64_t FULL_PAGE_MARKER;
+#define FULL_PAGE (&FULL_PAGE_MARKER)
+
+
+typedef struct {
+    uint64_t **pages; // NULL for the empty pages, FULL_PAGE for the full ones
+} Bitmap;
+
+
+static uint64_t *get_page(const Bitmap *bitmap, const uint32_t page) {
+    uint64_t *words = bitmap->pages[page];
+    if (!words) {
+        words = calloc(BITMAP_PAGE_WORDS, sizeof(uint64_t));
+        if (!words) {
+            perror("Failed to allocate bitmap page");
+            exit(EXIT_FAILURE);
+        }
+        bitmap->pages[page] = words;
+    }
+    return words;
+}
+
+
+// sets the bits [first, last] of the page
+static void fill_bits(uint64_t *words, const uint32_t first, const uint32_t last) {
+    const uint32_t first_word = first / 64;
+    const uint32_t last_word = last / 64;
+    const uint64_t first_mask = ALL_BITS << (first % 64);
+    const uint64_t last_mask = ALL_BITS >> (63 - last % 64);
+
+    if (first_word == last_word) {
+        words[first_word] |= first_mask & last_mask;
+        return;
+    }
+
+    words[first_word] |= first_mask;
+    for (uint32_t word = first_word + 1; word < last_word; word++) {
+        words[word] = ALL_BITS;
+    }
+    words[last_word] |= last_mask;
+}
+
+
+static void insert_range(const Bitmap *bitmap, const uint32_t min_ip, const uint32_t max_ip) {
+    const uint32_t first_page = min_ip >> BITMAP_PAGE_BITS;
+    const uint32_t last_page = max_ip >> BITMAP_PAGE_BITS;
+
+    for (uint32_t page = first_page; page <= last_page; page++) {
+        if (bitmap->pages[page] == FULL_PAGE) {
+            continue;
+        }
+
+        const uint32_t first = page == first_page ? min_ip & PAGE_OFFSET_MASK : 0;
+        const uint32_t last = page == last_page ? max_ip & PAGE_OFFSET_MASK : PAGE_OFFSET_MASK;
+
+        if (first == 0 && last == PAGE_OFFSET_MASK) {
+            free(bitmap->pages[page]);
+            bitmap->pages[page] = FULL_PAGE;
+        } else {
+            fill_bits(get_page(bitmap, page), first, last);
+        }
+    }
+}
+
+
+static void insert_host(const Bitmap *bitmap, const uint32_t host) {
+    const uint32_t page = host >> BITMAP_PAGE_BITS;
+    if (bitmap->pages[page] == FULL_PAGE) {
+        return;
+    }
+
+    const uint32_t offset = host & PAGE_OFFSET_MASK;
+    get_page(bitmap, page)[offset / 64] |= (uint64_t)1 << (offset % 64);
+}
+
+
+// The run of set bits being collected by the scan
+typedef struct {
+    bool open;
+    uint32_t first;
+    ipRangeList *result;
+} Run;
+
+
+static inline void open_run(Run *run, const uint32_t first) {
+    if (!run->open) {
+        run->open = true;
+        run->first = first;
+    }
+}
+
+
+static inline void close_run(Run *run, const uint32_t last) {
+    if (run->open) {
+        appendIpRange(run->result, &(ipRange){.min_ip = {run->first}, .max_ip = {last}});
+        run->open = false;
+    }
+}
+
+
+static void scan_page(const uint64_t *words, const uint32_t base, Run *run) {
+    for (uint32_t word = 0; word < BITMAP_PAGE_WORDS; word++) {
+        const uint64_t bits = words[word];
+        const uint32_t address = base + word * 64;
+
+        // most of the words are either empty or full
+        if (bits == 0) {
+            close_run(run, address - 1);
+            continue;
+        }
+        if (bits == ALL_BITS) {
+            open_run(run, address);
+            continue;
+        }
+
+        unsigned position = 0;
+        while (position < 64) {
+            if (run->open) {
+                const uint64_t zeros = ~bits & (ALL_BITS << position);
+                if (!zeros) {
+                    break;
+                }
+                position = count_trailing_zeros64(zeros);
+                close_run(run, address + position - 1);
+            } else {
+                const uint64_t ones = bits & (ALL_BITS << position);
+                if (!ones) {
+                    break;
+                }
+                position = count_trailing_zeros64(ones);
+                open_run(run, address + position);
+            }
+        }
+    }
+}
+
+
+static Bitmap fill_bitmap(const ipRangeList *cidr_list) {
+    const Bitmap bitmap = {.pages = calloc(BITMAP_PAGE_COUNT, sizeof(uint64_t *))};
+    if (!bitmap.pages) {
+        perror("Failed to allocate bitmap");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < cidr_list->length; i++) {
+        insert_range(&bitmap, cidr_list->cidrs[i].min_ip.s_addr, cidr_list->cidrs[i].max_ip.s_addr);
+    }
+    for (size_t i = 0; i < cidr_list->host_count; i++) {
+        insert_host(&bitmap, cidr_list->hosts[i]);
+    }
+
+    return bitmap;
+}
+
+
+// appends the runs of the bitmap to the list and releases the bitmap
+static void scan_bitmap(const Bitmap bitmap, ipRangeList *result) {
+    Run run = {.open = false, .first = 0, .result = result};
+    for (uint32_t page = 0; page < BITMAP_PAGE_COUNT; page++) {
+        const uint32_t base = page << BITMAP_PAGE_BITS;
+        uint64_t *words = bitmap.pages[page];
+
+        if (!words) {
+            close_run(&run, base - 1);
+        } else if (words == FULL_PAGE) {
+            open_run(&run, base);
+        } else {
+            scan_page(words, base, &run);
+            free(words);
+        }
+    }
+    close_run(&run, ALL_ONES);
+
+    free(bitmap.pages);
+}
+
+
+/**
+ * @brief Merges IP ranges by marking them in a bitmap of the whole IPv4 address space.
+ *
+ * The bitmap has two levels: a table of 65536 /16 pages, where a page is either
+ * empty, full, or an 8 KiB bitmap allocated on the first partial write. Ranges
+ * are inserted with word-wide fills, and the merged ranges are the runs of set
+ * bits, which are found with `ctz`. No sorting is involved, so the time is linear
+ * in the number of the ranges plus the number of the touched pages.
+ *
+ * The result is the same as the one of the sort-based merge.
+ *
+ * @param cidr_list The list of IP ranges and hosts to be merged.
+ * @return A new list of the merged ranges.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+ipRangeList *merge_with_bitmap(const ipRangeList *cidr_list) {
+    ipRangeList *result = getIpRangeList(0);
+    scan_bitmap(fill_bitmap(cidr_list), result);
+    return result;
+}
+
+
+/**
+ * @brief Merges IP ranges with the bitmap, replacing the content of the list.
+ *
+ * The arrays of the list are released as soon as the bitmap is filled, so the
+ * input and the bitmap are never held together with the result.
+ *
+ * @param cidr_list The list of IP ranges and hosts to be merged. On return, it
+ *                  holds the merged ranges and no hosts.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void merge_with_bitmap_in_place(ipRangeList *cidr_list) {
+    const Bitmap bitmap = fill_bitmap(cidr_list);
+
+    cidr_list->length = 0;
+    cidr_list->host_count = 0;
+    shrinkIpRangeListToFit(cidr_list);
+
+    scan_bitmap(bitmap, cidr_list);
+    shrinkIpRangeListToFit(cidr_list);
+}
+
+
+static inline void mark_page(uint64_t *seen, size_t *count, const uint32_t address) {
+    const uint32_t page = address >> BITMAP_PAGE_BITS;
+    const uint64_t bit = (uint64_t)1 << (page % 64);
+    *count += !(seen[page / 64] & bit);
+    seen[page / 64] |= bit;
+}
+
+
+/**
+ * @brief Counts the /16 pages of the bitmap which the list would allocate.
+ *
+ * Only the first and the last pages of the ranges are counted, since the pages
+ * in between are covered completely and need no memory.
+ *
+ * @param cidr_list The list of IP ranges and hosts.
+ * @return The number of the distinct pages (up to BITMAP_PAGE_COUNT).
+ */
+size_t count_bitmap_pages(const ipRangeList *cidr_list) {
+    uint64_t seen[BITMAP_PAGE_COUNT / 64] = {0};
+    size_t count = 0;
+
+    for (size_t i = 0; i < cidr_list->length; i++) {
+        mark_page(seen, &count, cidr_list->cidrs[i].min_ip.s_addr);
+        mark_page(seen, &count, cidr_list->cidrs[i].max_ip.s_addr);
+    }
+    for (size_t i = 0; i < cidr_list->host_count; i++) {
+        mark_page(seen, &count, cidr_list->hosts[i]);
+    }
+
+    return count;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_BITMAP_H
+#define MERGE_IP_BITMAP_H
+
+#include "ipRange.h"
+
+// the address space is split into /16 pages, each of them is a bitmap of 65536 addresses
+#define BITMAP_PAGE_BITS 16
+#define BITMAP_PAGE_COUNT (1 << (32 - BITMAP_PAGE_BITS))
+#define BITMAP_PAGE_WORDS ((1 << BITMAP_PAGE_BITS) / 64)
+
+
+/**
+ * @brief Merges IP ranges by marking them in a bitmap of the whole IPv4 address space.
+ *
+ * The bitmap has two levels: a table of 65536 /16 pages, where a page is either
+ * empty, full, or an 8 KiB bitmap allocated on the first partial write. Ranges
+ * are inserted with word-wide fills, and the merged ranges are the runs of set
+ * bits, which are found with `ctz`. No sorting is involved, so the time is linear
+ * in the number of the ranges plus the number of the touched pages.
+ *
+ * The result is the same as the one of the sort-based merge.
+ *
+ * @param cidr_list The list of IP ranges and hosts to be merged.
+ * @return A new list of the merged ranges.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+ipRangeList *merge_with_bitmap(const ipRangeList *cidr_list);
+
+
+/**
+ * @brief Merges IP ranges with the bitmap, replacing the content of the list.
+ *
+ * The arrays of the list are released as soon as the bitmap is filled, so the
+ * input and the bitmap are never held together with the result.
+ *
+ * @param cidr_list The list of IP ranges and hosts to be merged. On return, it
+ *                  holds the merged ranges and no hosts.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void merge_with_bitmap_in_place(ipRangeList *cidr_list);
+
+
+/**
+ * @brief Counts the /16 pages of the bitmap which the list would allocate.
+ *
+ * Only the first and the last pages of the ranges are counted, since the pages
+ * in between are covered completely and need no memory.
+ *
+ * @param cidr_list The list of IP ranges and hosts.
+ * @return The number of the distinct pages (up to BITMAP_PAGE_COUNT).
+ */
+size_t count_bitmap_pages(const ipRangeList *cidr_list);
+
+#endif //MERGE_IP_BITMAP_H
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_BITS_H
+#define MERGE_IP_BITS_H
+
+#include <stdint.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+
+/**
+ * @brief Counts the number of trailing zero bits in a 64-bit integer.
+ *
+ * @param x The integer value to be analyzed. Must not be zero.
+ * @return The index of the least significant set bit.
+ */
+static inline unsigned count_trailing_zeros64(const uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (unsigned)index;
+#else
+    unsigned count = 0;
+    uint64_t value = x;
+    while (!(value & 1)) {
+        value >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+
+/**
+ * @brief Counts the number of trailing zero bits in a 32-bit integer.
+ *
+ * @param x The integer value to be analyzed. Must not be zero.
+ * @return The index of the least significant set bit.
+ */
+static inline unsigned count_trailing_zeros32(const uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(x);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return (unsigned)index;
+#else
+    unsigned count = 0;
+    uint32_t value = x;
+    while (!(value & 1)) {
+        value >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+
+/**
+ * @brief Counts the number of leading zero bits in a 32-bit integer.
+ *
+ * @param x The integer value to be analyzed. Must not be zero.
+ * @return The number of zero bits above the most significant set bit.
+ */
+static inline unsigned count_leading_zeros32(const uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_clz(x);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, x);
+    return 31 - (unsigned)index;
+#else
+    unsigned count = 0;
+    uint32_t value = x;
+    while (!(value & 0x80000000u)) {
+        value <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+#endif //MERGE_IP_BITS_H
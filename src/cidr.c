@@ -0,0 +1,56 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bits.h"
+#include "cidr.h"
+
+
+#define IP_BITS 32
+#define ALL_ONES 0xFFFFFFFF
+
+
+/**
+ * @brief Splits the range of IP addresses into the minimal list of CIDR blocks.
+ *
+ * Every block is the largest aligned block which starts at the first address
+ * not covered yet and doesn't go beyond the end of the range.
+ *
+ * @param first The first address of the range in the host byte order.
+ * @param last The last address of the range in the host byte order (`first <= last`).
+ * @param blocks The array to store the blocks, it must hold `MAX_CIDRS_PER_RANGE` elements.
+ * @return The number of blocks stored in the array.
+ */
+size_t split_range_to_cidrs(uint32_t first, const uint32_t last, CidrBlock *blocks) {
+    size_t count = 0;
+
+    for (;;) {
+        // the block must be aligned to its size...
+        const unsigned alignment_bits = first == 0 ? IP_BITS : count_trailing_zeros32(first);
+        // ...and must fit into the rest of the range, whose size is `last - first + 1`
+        const uint32_t rest = last - first;
+        const unsigned size_bits = rest == ALL_ONES ? IP_BITS : IP_BITS - 1 - count_leading_zeros32(rest + 1);
+        const unsigned nbits = alignment_bits < size_bits ? alignment_bits : size_bits;
+
+        blocks[count++] = (CidrBlock){.network = first, .prefix = (uint8_t)(IP_BITS - nbits)};
+
+        // `1 << 32` is undefined, and the block may end at the last address
+        const uint32_t block_last = first + (nbits == IP_BITS ? ALL_ONES : ((uint32_t)1 << nbits) - 1);
+        if (block_last == last) {
+            return count;
+        }
+        first = block_last + 1;
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_CIDR_H
+#define MERGE_IP_CIDR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// the worst case is 0.0.0.1 - 255.255.255.254: 31 growing blocks followed by 31 shrinking ones
+#define MAX_CIDRS_PER_RANGE 62
+
+
+// A CIDR block: the network address in the host byte order and the length of its prefix
+typedef struct {
+    uint32_t network;
+    uint8_t prefix;
+} CidrBlock;
+
+
+/**
+ * @brief Splits the range of IP addresses into the minimal list of CIDR blocks.
+ *
+ * Every block is the largest aligned block which starts at the first address
+ * not covered yet and doesn't go beyond the end of the range.
+ *
+ * @param first The first address of the range in the host byte order.
+ * @param last The last address of the range in the host byte order (`first <= last`).
+ * @param blocks The array to store the blocks, it must hold `MAX_CIDRS_PER_RANGE` elements.
+ * @return The number of blocks stored in the array.
+ */
+size_t split_range_to_cidrs(uint32_t first, uint32_t last, CidrBlock *blocks);
+
+#endif //MERGE_IP_CIDR_H
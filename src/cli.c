@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -21,6 +23,48 @@
 #include "cli.h"
 
 #include "main.h"
+#include "parallel.h"
+#include "reader.h"
+
+
+#define MAX_THREADS 1024
+#define MIN_MAX_MEMORY (1024 * 1024)
+
+
+/**
+ * @brief Parses a size with an optional binary suffix.
+ *
+ * This function converts strings like "4096", "64K", "16M" or "1G" into
+ * the number of bytes.
+ *
+ * @param value The string to be parsed.
+ * @param size A pointer to store the parsed size.
+ * @return true if the string is a valid size; false otherwise.
+ */
+static bool parse_size(const char *value, size_t *size) {
+    char *end = NULL;
+    errno = 0;
+    const unsigned long long number = strtoull(value, &end, 10);
+    if (errno == ERANGE || end == value || *value == '-') {
+        return false;
+    }
+
+    unsigned shift = 0;
+    switch (*end) {
+        case '\0': break;
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
+        default: return false;
+    }
+
+    if (*end != '\0' || number > (SIZE_MAX >> shift)) {
+        return false;
+    }
+
+    *size = (size_t)number << shift;
+    return true;
+}
 
 /**
  * @brief Prints the usage message for the program.
@@ -33,15 +77,58 @@
  */
 void print_usage(const char *program_name) {
     printf(
-            "Usage: %s [-f filename | --file=filename] [-d | --debug] [-h | --help] "
-            "[-v | --version]\n"
+            "Usage: %s [-f filename | --file=filename] [-o filename | --output=filename] "
+            "[-b size | --buffer-size=size] [-j threads | --jobs=threads] "
+            "[-e engine | --engine=engine] [--online] [-m size | --max-memory=size] [--sorted] [--dedup] [--pin] [--io-uring] "
+            "[-d | --debug] [-h | --help] [-v | --version]\n"
             "\nThe program takes CIDRs from the input (stdin or given file), sorts them,\n"
             "removes duplicates, merges adjacent blocks into one continuous sequence and\n"
             "prints result\n"
             "\nOptions:\n"
             "  -f, --file=filename  Specifies the input file to read CIDR blocks from.\n"
-            "                       If not provided, the program reads from standard\n"
-            "                       input (stdin).\n"
+            "                       May be repeated to merge several files. If not\n"
+            "                       provided, the program reads from standard input\n"
+            "                       (stdin).\n"
+            "  -o, --output=filename\n"
+            "                       Specifies the output file. The file is replaced\n"
+            "                       atomically once the result is complete. If not\n"
+            "                       provided, the program writes to standard output.\n"
+            "  -b, --buffer-size=size\n"
+            "                       Sets the size of the buffer used to read the input\n"
+            "                       stream, e.g. 64K or 4M (from 1K to 16M). By default,\n"
+            "                       it's detected automatically.\n"
+            "  -j, --jobs=threads   Sets the number of threads used to process the input.\n"
+            "                       A stream (e.g. stdin) is read by one of them and\n"
+            "                       parsed by the others at the same time.\n"
+            "                       0 means \"one thread per CPU\", i.e. per CPU the\n"
+            "                       process may run on, within the CPU quota of its\n"
+            "                       cgroup (container). Default: 1.\n"
+            "  -e, --engine=engine  Sets the merge engine: \"qsort\" or \"radix\" sort the\n"
+            "                       ranges, \"bitmap\" marks them in a bitmap of the whole\n"
+            "                       IPv4 space, which is faster for huge dense inputs.\n"
+            "                       Default: auto, i.e. chosen by the size and the\n"
+            "                       density of the input.\n"
+            "  --online             Merges the input while it's being read, so the memory\n"
+            "                       is proportional to the size of the result rather than\n"
+            "                       to the size of the input. The input is parsed by a\n"
+            "                       single thread then.\n"
+            "  -m, --max-memory=size\n"
+            "                       Limits the memory taken by the parsed input, e.g.\n"
+            "                       512M (at least 1M). The merged ranges which don't fit\n"
+            "                       are spilled to temporary files in $TMPDIR and merged\n"
+            "                       at the end. The input is parsed by a single thread then.\n"
+            "  --sorted             Treats every input as already sorted (e.g. the output\n"
+            "                       of merge-ip) and merges them on the fly, so the memory\n"
+            "                       is proportional to the number of the inputs and the\n"
+            "                       output starts immediately. Fails on an unsorted input.\n"
+            "  --dedup              Drops the exact duplicates while the input is parsed,\n"
+            "                       so they take neither memory nor sorting time. Pays\n"
+            "                       off when most of the entries are repeated.\n"
+            "  --pin                Pins every thread to its own CPU (Linux only).\n"
+            "  --io-uring           Reads the input files by io_uring, keeping several\n"
+            "                       large reads in flight (Linux only), and parses them\n"
+            "                       by a single thread. Falls back to the usual reading\n"
+            "                       if io_uring is not available.\n"
             "  -d, --debug          Enables debug mode, printing additional debug\n"
             "                       information during execution.\n"
             "  -h, --help           Displays this help message and exits.\n"
@@ -51,18 +138,55 @@ void print_usage(const char *program_name) {
 }
 
 
+/**
+ * @brief Tells why the input files won't be read by io_uring despite --io-uring.
+ *
+ * @param options The parsed options.
+ * @return A constant C-string with the reason or NULL if the option takes effect.
+ */
+static const char *get_ignored_async_io_reason(const CommandLineOptions *options) {
+    if (!options->async_io) {
+        return NULL;
+    }
+    if (!options->file_count) {
+        return "for the standard input";
+    }
+    if (options->sorted) {
+        return "with --sorted";
+    }
+    // several threads parse the mapping faster than a single one parses the blocks as they come
+    if (options->threads > 1 && !options->online && !options->max_memory) {
+        return "with -j above 1 unless --online or -m is given";
+    }
+
+    return NULL;
+}
+
+
 /**
  * @brief Parses command line options passed to the program.
  *
  * This function processes arguments passed to the program and sets the
  * corresponding options in the CommandLineOptions structure. The function
- * handles three options:
+ * handles next options:
  * -h or --help: Displays the usage information and exits the program.
  * -d or --debug: Enables debug mode.
- * -f filename or --file=filename: Specifies the input file for the program.
+ * -f filename or --file=filename: Specifies an input file for the program (repeatable).
+ * -o filename or --output=filename: Specifies the output file for the program.
+ * -b size or --buffer-size=size: Specifies the size of the read buffer.
+ * -j threads or --jobs=threads: Specifies the number of threads (0 means all CPUs).
+ * -e engine or --engine=engine: Specifies the merge engine (auto, qsort, radix or bitmap).
+ * --online: Merges the input on the fly to bound the memory.
+ * -m size or --max-memory=size: Limits the memory of the parsed input, spilling the rest to disk.
+ * --sorted: Streams the sorted inputs through a k-way merge.
+ * --dedup: Drops the exact duplicates while parsing the input.
+ * --pin: Pins the threads to CPUs.
+ * --io-uring: Reads the input files by io_uring.
  *
  * If an unknown option or incorrect usage is detected, the function will
  * print an error message, display usage information, and exit the program.
+ * If --io-uring can't take effect with the other options (e.g. the files are
+ * parsed in parallel), the function warns about it on stderr.
  *
  * @param argc The count of command line arguments including the program name.
  * @param argv The array of command line arguments where argv[0] is the
@@ -70,7 +194,7 @@ void print_usage(const char *program_name) {
  * @return CommandLineOptions structure containing parsed options.
  */
 CommandLineOptions parse_command_line_options(int argc, char *argv[]) {
-    CommandLineOptions options = {false, false, NULL};
+    CommandLineOptions options = {false, false, NULL, 0, NULL, 0, 1, MERGE_ENGINE_AUTO, false, 0, false, false, false, false};
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
@@ -80,7 +204,56 @@ CommandLineOptions parse_command_line_options(int argc, char *argv[]) {
         } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--debug") == 0) {
             options.debug = true;
         } else if ((strcmp(argv[i], "-f") == 0 && i + 1 < argc) || strncmp(argv[i], "--file=", 7) == 0) {
-            options.file = (strcmp(argv[i], "-f") == 0) ? argv[++i] : argv[i] + 7;
+            // there can't be more files than arguments
+            if (!options.files && !(options.files = malloc((size_t)argc * sizeof(char *)))) {
+                perror("Failed to allocate file names");
+                exit(EXIT_FAILURE);
+            }
+            options.files[options.file_count++] = (strcmp(argv[i], "-f") == 0) ? argv[++i] : argv[i] + 7;
+        } else if ((strcmp(argv[i], "-o") == 0 && i + 1 < argc) || strncmp(argv[i], "--output=", 9) == 0) {
+            options.output = (strcmp(argv[i], "-o") == 0) ? argv[++i] : argv[i] + 9;
+        } else if ((strcmp(argv[i], "-b") == 0 && i + 1 < argc) || strncmp(argv[i], "--buffer-size=", 14) == 0) {
+            const char *value = (strcmp(argv[i], "-b") == 0) ? argv[++i] : argv[i] + 14;
+            if (!parse_size(value, &options.buffer_size)
+                    || options.buffer_size < MIN_READ_BUFFER_SIZE || options.buffer_size > MAX_READ_BUFFER_SIZE) {
+                fprintf(stderr, "Invalid buffer size: %s\n", value);
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if ((strcmp(argv[i], "-j") == 0 && i + 1 < argc) || strncmp(argv[i], "--jobs=", 7) == 0) {
+            const char *value = (strcmp(argv[i], "-j") == 0) ? argv[++i] : argv[i] + 7;
+            char *end = NULL;
+            const unsigned long threads = strtoul(value, &end, 10);
+            if (end == value || *end != '\0' || *value == '-' || threads > MAX_THREADS) {
+                fprintf(stderr, "Invalid number of threads: %s\n", value);
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            options.threads = threads == 0 ? get_cpu_count() : (unsigned)threads;
+        } else if ((strcmp(argv[i], "-e") == 0 && i + 1 < argc) || strncmp(argv[i], "--engine=", 9) == 0) {
+            const char *value = (strcmp(argv[i], "-e") == 0) ? argv[++i] : argv[i] + 9;
+            if (!find_merge_engine(value, &options.engine)) {
+                fprintf(stderr, "Unknown merge engine: %s\n", value);
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if ((strcmp(argv[i], "-m") == 0 && i + 1 < argc) || strncmp(argv[i], "--max-memory=", 13) == 0) {
+            const char *value = (strcmp(argv[i], "-m") == 0) ? argv[++i] : argv[i] + 13;
+            if (!parse_size(value, &options.max_memory) || options.max_memory < MIN_MAX_MEMORY) {
+                fprintf(stderr, "Invalid memory limit: %s\n", value);
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "--online") == 0) {
+            options.online = true;
+        } else if (strcmp(argv[i], "--sorted") == 0) {
+            options.sorted = true;
+        } else if (strcmp(argv[i], "--dedup") == 0) {
+            options.dedup = true;
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            options.pin = true;
+        } else if (strcmp(argv[i], "--io-uring") == 0) {
+            options.async_io = true;
         } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--version") == 0) {
             printf("%s version %s\n", PROGRAM_NAME, VERSION);
             exit(0);
@@ -91,5 +264,22 @@ CommandLineOptions parse_command_line_options(int argc, char *argv[]) {
         }
     }
 
+    const char *reason = get_ignored_async_io_reason(&options);
+    if (reason) {
+        fprintf(stderr, "Warning: --io-uring is ignored %s\n", reason);
+    }
+
     return options;
 }
+
+
+/**
+ * @brief Releases the memory held by the parsed options.
+ *
+ * @param options A pointer to the options returned by `parse_command_line_options()`.
+ */
+void free_command_line_options(CommandLineOptions *options) {
+    free(options->files);
+    options->files = NULL;
+    options->file_count = 0;
+}
@@ -17,11 +17,25 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
+
+#include "merge.h"
 
 typedef struct {
     bool help;
     bool debug;
-    const char *file;
+    const char **files;  // NULL when the input is stdin, see `free_command_line_options()`
+    size_t file_count;
+    const char *output;
+    size_t buffer_size;
+    unsigned threads;
+    MergeEngine engine;
+    bool online;
+    size_t max_memory;
+    bool sorted;
+    bool dedup;
+    bool pin;
+    bool async_io;
 } CommandLineOptions;
 
 
@@ -41,13 +55,25 @@ void print_usage(const char *program_name);
  *
  * This function processes arguments passed to the program and sets the
  * corresponding options in the CommandLineOptions structure. The function
- * handles three options:
+ * handles next options:
  * -h or --help: Displays the usage information and exits the program.
  * -d or --debug: Enables debug mode.
- * -f filename or --file=filename: Specifies the input file for the program.
+ * -f filename or --file=filename: Specifies an input file for the program (repeatable).
+ * -o filename or --output=filename: Specifies the output file for the program.
+ * -b size or --buffer-size=size: Specifies the size of the read buffer.
+ * -j threads or --jobs=threads: Specifies the number of threads (0 means all CPUs).
+ * -e engine or --engine=engine: Specifies the merge engine (auto, qsort, radix or bitmap).
+ * --online: Merges the input on the fly to bound the memory.
+ * -m size or --max-memory=size: Limits the memory of the parsed input, spilling the rest to disk.
+ * --sorted: Streams the sorted inputs through a k-way merge.
+ * --dedup: Drops the exact duplicates while parsing the input.
+ * --pin: Pins the threads to CPUs.
+ * --io-uring: Reads the input files by io_uring.
  *
  * If an unknown option or incorrect usage is detected, the function will
  * print an error message, display usage information, and exit the program.
+ * If --io-uring can't take effect with the other options (e.g. the files are
+ * parsed in parallel), the function warns about it on stderr.
  *
  * @param argc The count of command line arguments including the program name.
  * @param argv The array of command line arguments where argv[0] is the
@@ -55,3 +81,11 @@ void print_usage(const char *program_name);
  * @return CommandLineOptions structure containing parsed options.
  */
 CommandLineOptions parse_command_line_options(int argc, char *argv[]);
+
+
+/**
+ * @brief Releases the memory held by the parsed options.
+ *
+ * @param options A pointer to the options returned by `parse_command_line_options()`.
+ */
+void free_command_line_options(CommandLineOptions *options);
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dedup.h"
+#include "bits.h"
+
+
+// the multiplier of the Fibonacci hashing, i.e. 2^64 / φ
+#define GOLDEN_RATIO_64 0x9E3779B97F4A7C15ull
+
+
+static uint64_t *allocate_slots(const size_t capacity) {
+    uint64_t *keys = calloc(capacity, sizeof(uint64_t));
+    if (!keys) {
+        perror("Failed to allocate deduplication set");
+        exit(EXIT_FAILURE);
+    }
+    return keys;
+}
+
+
+// the index of the first group to probe; the high bits of the product are mixed best
+static inline size_t get_home_group(const uint64_t key, const size_t group_mask) {
+    return (size_t)((key * GOLDEN_RATIO_64) >> 32) & group_mask;
+}
+
+
+/**
+ * @brief Finds the key or the empty slot to store it.
+ *
+ * Every group is compared as a whole, so the loop over its keys has no branches
+ * and is vectorized by the compiler.
+ *
+ * @param keys The slots.
+ * @param capacity The number of the slots.
+ * @param key The key to be found (not 0).
+ * @param found A pointer to store whether the key is in the set.
+ * @return A pointer to the slot with the key or to the empty slot for it.
+ */
+static uint64_t *find_slot(uint64_t *keys, const size_t capacity, const uint64_t key, bool *found) {
+    const size_t group_mask = capacity / DEDUP_GROUP_SIZE - 1;
+
+    for (size_t group = get_home_group(key, group_mask);; group = (group + 1) & group_mask) {
+        uint64_t *slots = keys + group * DEDUP_GROUP_SIZE;
+        uint32_t matches = 0;
+        uint32_t empty = 0;
+        for (unsigned i = 0; i < DEDUP_GROUP_SIZE; i++) {
+            matches |= (uint32_t)(slots[i] == key) << i;
+            empty |= (uint32_t)(slots[i] == 0) << i;
+        }
+
+        // the keys are never removed one by one, so the key can't be past an empty slot
+        if (matches) {
+            *found = true;
+            return slots + count_trailing_zeros32(matches);
+        }
+        if (empty) {
+            *found = false;
+            return slots + count_trailing_zeros32(empty);
+        }
+    }
+}
+
+
+static void grow_dedup_set(DedupSet *set) {
+    const size_t capacity = set->capacity * 2;
+    uint64_t *keys = allocate_slots(capacity);
+
+    for (size_t i = 0; i < set->capacity; i++) {
+        if (set->keys[i]) {
+            bool found;
+            *find_slot(keys, capacity, set->keys[i], &found) = set->keys[i];
+        }
+    }
+
+    free(set->keys);
+    set->keys = keys;
+    set->capacity = capacity;
+}
+
+
+/**
+ * @brief Initializes an empty set.
+ *
+ * @param set A pointer to the set.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void init_dedup_set(DedupSet *set) {
+    set->keys = allocate_slots(DEDUP_INITIAL_CAPACITY);
+    set->capacity = DEDUP_INITIAL_CAPACITY;
+    set->count = 0;
+    set->has_zero = false;
+    set->stats = (DedupStats){0, 0};
+}
+
+
+/**
+ * @brief Adds the key to the set.
+ *
+ * The set grows twice once it's half full. The statistics count the key either
+ * as a new entry or as a duplicate.
+ *
+ * @param set A pointer to the set.
+ * @param key The key made by `get_dedup_key()`.
+ * @return true if the key is new; false if it's a duplicate.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+bool insert_dedup_key(DedupSet *set, const uint64_t key) {
+    set->stats.entries++;
+
+    bool found;
+    if (key == 0) {
+        found = set->has_zero;
+        set->has_zero = true;
+    } else {
+        uint64_t *slot = find_slot(set->keys, set->capacity, key, &found);
+        if (!found) {
+            *slot = key;
+            if (++set->count > set->capacity / 2) {
+                grow_dedup_set(set);
+            }
+        }
+    }
+
+    if (found) {
+        set->stats.duplicates++;
+    }
+    return !found;
+}
+
+
+/**
+ * @brief Removes all the keys and shrinks the set to its initial capacity.
+ *
+ * The statistics are kept.
+ *
+ * @param set A pointer to the set.
+ */
+void clear_dedup_set(DedupSet *set) {
+    if (set->capacity > DEDUP_INITIAL_CAPACITY) {
+        free(set->keys);
+        set->keys = allocate_slots(DEDUP_INITIAL_CAPACITY);
+        set->capacity = DEDUP_INITIAL_CAPACITY;
+    } else {
+        memset(set->keys, 0, set->capacity * sizeof(uint64_t));
+    }
+    set->count = 0;
+    set->has_zero = false;
+}
+
+
+/**
+ * @brief Releases the memory of the set. The statistics are kept.
+ *
+ * @param set A pointer to the set.
+ */
+void free_dedup_set(DedupSet *set) {
+    free(set->keys);
+    set->keys = NULL;
+    set->capacity = 0;
+    set->count = 0;
+}
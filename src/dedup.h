@@ -0,0 +1,108 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MERGE_IP_DEDUP_H
+#define MERGE_IP_DEDUP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// the number of the keys compared at once: 4 keys take 32 bytes, i.e. one AVX2 register
+#define DEDUP_GROUP_SIZE 4
+// the initial number of the slots, i.e. 512 KiB
+#define DEDUP_INITIAL_CAPACITY (64 * 1024)
+
+
+// The statistics of the duplicate elimination
+typedef struct {
+    size_t entries;     // the number of the entries seen, including the duplicates
+    size_t duplicates;  // the number of the entries dropped
+} DedupStats;
+
+// An open-addressing hash set of the entries seen so far. Every entry is a 64-bit key
+// made of its minimal and maximal addresses. The slots are probed linearly in aligned
+// groups of DEDUP_GROUP_SIZE keys, so a probe is a single branch-free comparison of
+// the whole group. 0 marks the empty slots, so the key 0 (i.e. 0.0.0.0/32) is
+// stored apart.
+typedef struct {
+    uint64_t *keys;
+    size_t capacity;    // the number of the slots, a power of two
+    size_t count;       // the number of the keys in the slots
+    bool has_zero;
+    DedupStats stats;
+} DedupSet;
+
+
+/**
+ * @brief Makes the key of an IP range.
+ *
+ * @param min_ip The minimal address of the range in the host byte order.
+ * @param max_ip The maximal address of the range in the host byte order.
+ * @return The key of the range.
+ */
+static inline uint64_t get_dedup_key(const uint32_t min_ip, const uint32_t max_ip) {
+    return (uint64_t)min_ip << 32 | max_ip;
+}
+
+
+/**
+ * @brief Initializes an empty set.
+ *
+ * @param set A pointer to the set.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void init_dedup_set(DedupSet *set);
+
+
+/**
+ * @brief Adds the key to the set.
+ *
+ * The set grows twice once it's half full. The statistics count the key either
+ * as a new entry or as a duplicate.
+ *
+ * @param set A pointer to the set.
+ * @param key The key made by `get_dedup_key()`.
+ * @return true if the key is new; false if it's a duplicate.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+bool insert_dedup_key(DedupSet *set, uint64_t key);
+
+
+/**
+ * @brief Removes all the keys and shrinks the set to its initial capacity.
+ *
+ * The statistics are kept.
+ *
+ * @param set A pointer to the set.
+ */
+void clear_dedup_set(DedupSet *set);
+
+
+/**
+ * @brief Releases the memory of the set. The statistics are kept.
+ *
+ * @param set A pointer to the set.
+ */
+void free_dedup_set(DedupSet *set);
+
+#endif //MERGE_IP_DEDUP_H
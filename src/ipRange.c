@@ -14,12 +14,196 @@
  * limitations under the License.
  */
 
+// `mremap()` is a Linux extension
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+#endif
 
 #include "ipRange.h"
 
 
+// the smallest non-zero capacity of a list
+#define MIN_CAPACITY 16
+
+// arrays larger than this are allocated as anonymous mappings backed by huge pages
+#define MAPPED_ARRAY_THRESHOLD ((size_t)64 * 1024 * 1024)
+
+#if !defined(_WIN32) && !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+    #define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#if !defined(_WIN32) && defined(MAP_ANONYMOUS)
+    #define MAPPED_ARRAYS_SUPPORTED
+#endif
+
+
+/**
+ * @brief Allocates an array for the ipRangeList.
+ *
+ * Large arrays are mapped directly (and marked as candidates for transparent huge
+ * pages where it's supported), the rest is allocated on the heap.
+ *
+ * @param capacity The number of elements in the array.
+ * @param element_size The size of an element in bytes.
+ * @param mapped A pointer to store whether the array has been mapped.
+ * @return The pointer to the array or NULL if the allocation fails.
+ */
+static void *allocate_array(const size_t capacity, const size_t element_size, bool *mapped) {
+    *mapped = false;
+
+    if (capacity > SIZE_MAX / element_size) {
+        return NULL;
+    }
+
+#ifdef MAPPED_ARRAYS_SUPPORTED
+    const size_t size = capacity * element_size;
+    if (size >= MAPPED_ARRAY_THRESHOLD) {
+        void *array = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (array != MAP_FAILED) {
+            #ifdef MADV_HUGEPAGE
+                madvise(array, size, MADV_HUGEPAGE);
+            #endif
+            *mapped = true;
+            return array;
+        }
+    }
+#endif
+
+    return malloc(capacity * element_size);
+}
+
+
+/**
+ * @brief Releases an array allocated by `allocate_array()`.
+ *
+ * @param array The array to be released.
+ * @param capacity The number of elements in the array.
+ * @param element_size The size of an element in bytes.
+ * @param mapped Whether the array has been mapped.
+ */
+static void release_array(void *array, const size_t capacity, const size_t element_size, const bool mapped) {
+#ifdef MAPPED_ARRAYS_SUPPORTED
+    if (mapped) {
+        munmap(array, capacity * element_size);
+        return;
+    }
+#else
+    (void)capacity;
+    (void)element_size;
+    (void)mapped;
+#endif
+
+    free(array);
+}
+
+
+// One of the arrays of the ipRangeList: either the ranges or the hosts
+typedef struct {
+    void **elements;
+    size_t length;
+    size_t *capacity;
+    bool *mapped;
+    size_t element_size;
+} ArrayRef;
+
+
+static ArrayRef get_ranges_ref(ipRangeList *data) {
+    return (ArrayRef){(void **)&data->cidrs, data->length, &data->capacity, &data->mapped, sizeof(ipRange)};
+}
+
+
+static ArrayRef get_hosts_ref(ipRangeList *data) {
+    return (ArrayRef){(void **)&data->hosts, data->host_count, &data->host_capacity, &data->hosts_mapped, sizeof(uint32_t)};
+}
+
+
+/**
+ * @brief Changes the capacity of an array of the ipRangeList preserving its content.
+ *
+ * @param array The array to resize.
+ * @param capacity The new capacity. Must not be less than the length of the array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+static void resize_array(const ArrayRef array, const size_t capacity) {
+    if (capacity == 0) {
+        release_array(*array.elements, *array.capacity, array.element_size, *array.mapped);
+        *array.elements = NULL;
+        *array.capacity = 0;
+        *array.mapped = false;
+        return;
+    }
+
+    // heap arrays that stay on the heap are simply reallocated
+    const bool needs_mapping = capacity <= SIZE_MAX / array.element_size
+        && capacity * array.element_size >= MAPPED_ARRAY_THRESHOLD;
+    if (!*array.mapped && !needs_mapping) {
+        void *elements = realloc(*array.elements, capacity * array.element_size);
+        if (!elements) {
+            perror("Failed to reallocate CIDR buffer");
+            exit(EXIT_FAILURE);
+        }
+        *array.elements = elements;
+        *array.capacity = capacity;
+        return;
+    }
+
+#if defined(MAPPED_ARRAYS_SUPPORTED) && defined(MREMAP_MAYMOVE)
+    // a mapped array is remapped without copying
+    if (*array.mapped && needs_mapping) {
+        void *elements = mremap(*array.elements, *array.capacity * array.element_size,
+                                capacity * array.element_size, MREMAP_MAYMOVE);
+        if (elements != MAP_FAILED) {
+            *array.elements = elements;
+            *array.capacity = capacity;
+            return;
+        }
+    }
+#endif
+
+    bool mapped = false;
+    void *elements = allocate_array(capacity, array.element_size, &mapped);
+    if (!elements) {
+        perror("Failed to reallocate CIDR buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    if (array.length) {
+        memcpy(elements, *array.elements, array.length * array.element_size);
+    }
+    release_array(*array.elements, *array.capacity, array.element_size, *array.mapped);
+
+    *array.elements = elements;
+    *array.capacity = capacity;
+    *array.mapped = mapped;
+}
+
+
+/**
+ * @brief Grows an array of the ipRangeList geometrically to fit at least `required` elements.
+ *
+ * @param array The array to grow.
+ * @param required The number of elements the array must be able to hold.
+ */
+static void grow_array(const ArrayRef array, const size_t required) {
+    size_t capacity = *array.capacity < MIN_CAPACITY ? MIN_CAPACITY : *array.capacity;
+    while (capacity < required) {
+        capacity = capacity > SIZE_MAX / 2 ? required : capacity * 2;
+    }
+    resize_array(array, capacity);
+}
+
+
 /**
  * @brief Initializes a ipRangeList structure.
  *
@@ -39,19 +223,24 @@ ipRangeList *getIpRangeList(const size_t size) {
         exit(EXIT_FAILURE);
     }
 
+    data->cidrs = NULL;
+    data->length = 0;
+    data->capacity = 0;
+    data->mapped = false;
+    data->hosts = NULL;
+    data->host_count = 0;
+    data->host_capacity = 0;
+    data->hosts_mapped = false;
+
     if (size > 0) {
-        data->cidrs = malloc(sizeof(ipRange) * size);
+        data->cidrs = allocate_array(size, sizeof(ipRange), &data->mapped);
         if (!data->cidrs) {
             perror("Failed to allocate CIDR buffer");
             exit(EXIT_FAILURE);
         }
-    } else {
-        data->cidrs = NULL;
+        data->capacity = size;
     }
 
-    data->length = 0;
-    data->capacity = size;
-
     return data;
 }
 
@@ -66,18 +255,73 @@ ipRangeList *getIpRangeList(const size_t size) {
  */
 void freeIpRangeList(ipRangeList *data) {
     if (data->cidrs != NULL) {
-        free(data->cidrs);
+        release_array(data->cidrs, data->capacity, sizeof(ipRange), data->mapped);
         data->cidrs = NULL;
     }
+    if (data->hosts != NULL) {
+        release_array(data->hosts, data->host_capacity, sizeof(uint32_t), data->hosts_mapped);
+        data->hosts = NULL;
+    }
     free(data);
 }
 
+/**
+ * Ensures the ipRangeList can hold at least `capacity` elements without reallocation.
+ *
+ * This function never shrinks the list.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param capacity The number of elements the list must be able to hold.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void reserveIpRangeList(ipRangeList *data, const size_t capacity) {
+    if (capacity > data->capacity) {
+        resize_array(get_ranges_ref(data), capacity);
+    }
+}
+
+/**
+ * Ensures the ipRangeList can hold at least `capacity` hosts without reallocation.
+ *
+ * This function never shrinks the list.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param capacity The number of hosts the list must be able to hold.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void reserveIpHosts(ipRangeList *data, const size_t capacity) {
+    if (capacity > data->host_capacity) {
+        resize_array(get_hosts_ref(data), capacity);
+    }
+}
+
+/**
+ * Releases the unused capacity of the ipRangeList.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void shrinkIpRangeListToFit(ipRangeList *data) {
+    if (data->capacity > data->length) {
+        resize_array(get_ranges_ref(data), data->length);
+    }
+    if (data->host_capacity > data->host_count) {
+        resize_array(get_hosts_ref(data), data->host_count);
+    }
+}
+
 /**
  * Adds a copy of the ipRange block to the ipRangeList structure.
  *
  * This function ensures that the ipRangeList structure has enough space
- * to store the new ipRange block, reallocating if necessary. It then duplicates
- * and stores the ipRange block and increments the length counter.
+ * to store the new ipRange block, growing the buffer geometrically if necessary.
+ * It then duplicates and stores the ipRange block and increments the length counter.
  *
  * @param data Pointer to the ipRangeList structure.
  * @param range The ipRange block to add.
@@ -86,16 +330,78 @@ void freeIpRangeList(ipRangeList *data) {
  *       exits the program.
  */
 void appendIpRange(ipRangeList *data, const ipRange *range) {
-    if (data->length > 0 && data->length % data->capacity == 0) {
-        data->cidrs = realloc(data->cidrs, 2 * data->length * sizeof(ipRange *));
-
-        if (!data->cidrs) {
-            perror("Failed to reallocate CIDR buffer");
-            exit(EXIT_FAILURE);
-        }
-
-        data->capacity *= 2;
+    if (data->length == data->capacity) {
+        grow_array(get_ranges_ref(data), data->length + 1);
     }
     data->cidrs[data->length] = *range;
     data->length++;
 }
+
+/**
+ * Appends copies of several ipRange blocks to the end of the `ipRangeList`.
+ *
+ * This function grows the CIDR buffer at most once to fit all the
+ * new blocks and copies them at once.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param ranges The array of ipRange blocks to add.
+ * @param count The number of blocks in the `ranges` array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void appendIpRanges(ipRangeList *data, const ipRange *ranges, const size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    if (data->length + count > data->capacity) {
+        grow_array(get_ranges_ref(data), data->length + count);
+    }
+
+    memcpy(data->cidrs + data->length, ranges, count * sizeof(ipRange));
+    data->length += count;
+}
+
+/**
+ * Appends a single host (a /32 block) to the `ipRangeList`.
+ *
+ * The hosts are stored as bare addresses, separately from the ranges,
+ * which takes half of the memory.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param address The address of the host in the host byte order.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void appendIpHost(ipRangeList *data, const uint32_t address) {
+    if (data->host_count == data->host_capacity) {
+        grow_array(get_hosts_ref(data), data->host_count + 1);
+    }
+    data->hosts[data->host_count] = address;
+    data->host_count++;
+}
+
+/**
+ * Appends several hosts (/32 blocks) to the `ipRangeList`.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param hosts The array of addresses in the host byte order.
+ * @param count The number of addresses in the `hosts` array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void appendIpHosts(ipRangeList *data, const uint32_t *hosts, const size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    if (data->host_count + count > data->host_capacity) {
+        grow_array(get_hosts_ref(data), data->host_count + count);
+    }
+
+    memcpy(data->hosts + data->host_count, hosts, count * sizeof(uint32_t));
+    data->host_count += count;
+}
@@ -17,6 +17,10 @@
 #ifndef IPRANGE_H
 #define IPRANGE_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef _WIN32
   #include <winsock2.h>
   #include <ws2tcpip.h>
@@ -36,6 +40,12 @@ typedef struct {
     ipRange *cidrs;
     size_t length;
     size_t capacity;
+    bool mapped; // the buffer is an anonymous memory mapping rather than a heap block
+    // the /32 blocks are stored separately as bare addresses in the host byte order
+    uint32_t *hosts;
+    size_t host_count;
+    size_t host_capacity;
+    bool hosts_mapped;
 } ipRangeList;
 
 
@@ -65,12 +75,48 @@ ipRangeList *getIpRangeList(const size_t size);
  */
 void freeIpRangeList(ipRangeList *data);
 
+/**
+ * Ensures the ipRangeList can hold at least `capacity` elements without reallocation.
+ *
+ * This function never shrinks the list.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param capacity The number of elements the list must be able to hold.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void reserveIpRangeList(ipRangeList *data, size_t capacity);
+
+/**
+ * Ensures the ipRangeList can hold at least `capacity` hosts without reallocation.
+ *
+ * This function never shrinks the list.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param capacity The number of hosts the list must be able to hold.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void reserveIpHosts(ipRangeList *data, size_t capacity);
+
+/**
+ * Releases the unused capacity of the ipRangeList.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void shrinkIpRangeListToFit(ipRangeList *data);
+
 /**
  * Appends a copy of the ipRange block to the end of the `ipRangeList`.
  *
  * This function ensures that the `ipRangeList` structure has enough space
- * to store the new `ipRange` block, reallocating if necessary. It then duplicates
- * and stores the ipRange block and increments the length counter.
+ * to store the new `ipRange` block, growing the buffer geometrically if necessary.
+ * It then duplicates and stores the ipRange block and increments the length counter.
  *
  * @param data Pointer to the ipRangeList structure.
  * @param range The ipRange block to add.
@@ -80,4 +126,45 @@ void freeIpRangeList(ipRangeList *data);
  */
 void appendIpRange(ipRangeList *data, const ipRange *range);
 
+/**
+ * Appends copies of several ipRange blocks to the end of the `ipRangeList`.
+ *
+ * This function grows the CIDR buffer at most once to fit all the
+ * new blocks and copies them at once.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param ranges The array of ipRange blocks to add.
+ * @param count The number of blocks in the `ranges` array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void appendIpRanges(ipRangeList *data, const ipRange *ranges, size_t count);
+
+/**
+ * Appends a single host (a /32 block) to the `ipRangeList`.
+ *
+ * The hosts are stored as bare addresses, separately from the ranges,
+ * which takes half of the memory.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param address The address of the host in the host byte order.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void appendIpHost(ipRangeList *data, uint32_t address);
+
+/**
+ * Appends several hosts (/32 blocks) to the `ipRangeList`.
+ *
+ * @param data Pointer to the ipRangeList structure.
+ * @param hosts The array of addresses in the host byte order.
+ * @param count The number of addresses in the `hosts` array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void appendIpHosts(ipRangeList *data, const uint32_t *hosts, size_t count);
+
 #endif //IPRANGE_H
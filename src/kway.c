@@ -0,0 +1,178 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "kway.h"
+#include "merge.h"
+
+
+// The next range of one of the streams
+typedef struct {
+    ipRange range;
+    size_t stream;
+} HeapEntry;
+
+
+static inline bool is_before(const HeapEntry *a, const HeapEntry *b) {
+    return a->range.min_ip.s_addr < b->range.min_ip.s_addr;
+}
+
+
+static void sift_down(HeapEntry *heap, const size_t size, size_t position) {
+    const HeapEntry entry = heap[position];
+    for (;;) {
+        size_t child = 2 * position + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && is_before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!is_before(&heap[child], &entry)) {
+            break;
+        }
+        heap[position] = heap[child];
+        position = child;
+    }
+    heap[position] = entry;
+}
+
+
+/**
+ * @brief Reads the next range of the list.
+ *
+ * @param cursor A pointer to the ListCursor.
+ * @param range A pointer to store the range.
+ * @return true if the range is read; false at the end of the list.
+ */
+bool next_list_range(void *cursor, ipRange *range) {
+    ListCursor *list_cursor = cursor;
+    if (list_cursor->position == list_cursor->list->length) {
+        return false;
+    }
+    *range = list_cursor->list->cidrs[list_cursor->position++];
+    return true;
+}
+
+
+/**
+ * @brief Merges several sorted streams of IP ranges and passes the result on.
+ *
+ * The streams are merged with a binary heap keyed by the start of the next range
+ * of every stream, and the overlapping or adjacent ranges are merged on the fly.
+ * So, besides the streams themselves, the memory is O(k).
+ *
+ * @param streams The array of the streams. Every stream must be sorted by `min_ip`.
+ * @param count The number of the streams.
+ * @param emit The function which takes the merged ranges, in ascending order.
+ * @param target The state passed to `emit`.
+ * @return The number of the merged ranges.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+size_t merge_range_streams_into(const RangeStream *streams, const size_t count, const EmitRangeFunction emit,
+                                void *target) {
+    HeapEntry *heap = malloc((count ? count : 1) * sizeof(HeapEntry));
+    if (!heap) {
+        perror("Failed to allocate merge heap");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (streams[i].next(streams[i].source, &heap[size].range)) {
+            heap[size++].stream = i;
+        }
+    }
+    for (size_t i = size / 2; i-- > 0;) {
+        sift_down(heap, size, i);
+    }
+
+    size_t merged_count = 0;
+    bool open = false;
+    ipRange current = {0};
+
+    while (size > 0) {
+        const ipRange *next = &heap[0].range;
+        if (!open) {
+            current = *next;
+            open = true;
+        } else if (next->min_ip.s_addr <= current.max_ip.s_addr || next->min_ip.s_addr - 1 == current.max_ip.s_addr) {
+            if (current.max_ip.s_addr < next->max_ip.s_addr) {
+                current.max_ip = next->max_ip;
+            }
+        } else {
+            emit(target, &current);
+            merged_count++;
+            current = *next;
+        }
+
+        const RangeStream *stream = &streams[heap[0].stream];
+        if (!stream->next(stream->source, &heap[0].range)) {
+            heap[0] = heap[--size];
+        }
+        if (size > 0) {
+            sift_down(heap, size, 0);
+        }
+    }
+
+    if (open) {
+        emit(target, &current);
+        merged_count++;
+    }
+
+    free(heap);
+    return merged_count;
+}
+
+
+// The state of `write_merged_range()`
+typedef struct {
+    Writer *writer;
+    size_t cidr_count;
+} MergedOutput;
+
+
+static void write_merged_range(void *target, const ipRange *range) {
+    MergedOutput *output = target;
+    output->cidr_count += write_ip_range(range, output->writer);
+}
+
+
+/**
+ * @brief Merges several sorted streams of IP ranges and writes the result in CIDR notation.
+ *
+ * The streams are merged with a binary heap keyed by the start of the next range
+ * of every stream, and the overlapping or adjacent ranges are merged on the fly.
+ * So, besides the streams themselves, the memory is O(k), and the first CIDRs are
+ * written before the streams are read to the end.
+ *
+ * @param streams The array of the streams. Every stream must be sorted by `min_ip`.
+ * @param count The number of the streams.
+ * @param writer The writer to append the CIDR blocks to.
+ * @return The total number of CIDR blocks written.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+size_t merge_range_streams(const RangeStream *streams, const size_t count, Writer *writer) {
+    MergedOutput output = {.writer = writer, .cidr_count = 0};
+    merge_range_streams_into(streams, count, write_merged_range, &output);
+    return output.cidr_count;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_KWAY_H
+#define MERGE_IP_KWAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ipRange.h"
+#include "writer.h"
+
+
+/**
+ * @brief Reads the next range of a stream.
+ *
+ * @param source The state of the stream.
+ * @param range A pointer to store the range.
+ * @return true if the range is read; false at the end of the stream.
+ */
+typedef bool (*NextRangeFunction)(void *source, ipRange *range);
+
+/**
+ * @brief Takes a range of the merged streams.
+ *
+ * @param target The state of the consumer.
+ * @param range The merged range.
+ */
+typedef void (*EmitRangeFunction)(void *target, const ipRange *range);
+
+// A source of IP ranges sorted by `min_ip`
+typedef struct {
+    NextRangeFunction next;
+    void *source;
+} RangeStream;
+
+// The state of a RangeStream over the ranges of an ipRangeList
+typedef struct {
+    const ipRangeList *list;
+    size_t position;
+} ListCursor;
+
+
+/**
+ * @brief Reads the next range of the list.
+ *
+ * @param cursor A pointer to the ListCursor.
+ * @param range A pointer to store the range.
+ * @return true if the range is read; false at the end of the list.
+ */
+bool next_list_range(void *cursor, ipRange *range);
+
+
+/**
+ * @brief Merges several sorted streams of IP ranges and passes the result on.
+ *
+ * The streams are merged with a binary heap keyed by the start of the next range
+ * of every stream, and the overlapping or adjacent ranges are merged on the fly.
+ * So, besides the streams themselves, the memory is O(k).
+ *
+ * @param streams The array of the streams. Every stream must be sorted by `min_ip`.
+ * @param count The number of the streams.
+ * @param emit The function which takes the merged ranges, in ascending order.
+ * @param target The state passed to `emit`.
+ * @return The number of the merged ranges.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+size_t merge_range_streams_into(const RangeStream *streams, size_t count, EmitRangeFunction emit, void *target);
+
+
+/**
+ * @brief Merges several sorted streams of IP ranges and writes the result in CIDR notation.
+ *
+ * The streams are merged with a binary heap keyed by the start of the next range
+ * of every stream, and the overlapping or adjacent ranges are merged on the fly.
+ * So, besides the streams themselves, the memory is O(k), and the first CIDRs are
+ * written before the streams are read to the end.
+ *
+ * @param streams The array of the streams. Every stream must be sorted by `min_ip`.
+ * @param count The number of the streams.
+ * @param writer The writer to append the CIDR blocks to.
+ * @return The total number of CIDR blocks written.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+size_t merge_range_streams(const RangeStream *streams, size_t count, Writer *writer);
+
+#endif //MERGE_IP_KWAY_H
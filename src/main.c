@@ -17,9 +17,115 @@
 #include <stdlib.h>
 
 #include "ipRange.h"
+#include "kway.h"
 #include "merge.h"
 #include "reader.h"
 #include "cli.h"
+#include "parallel.h"
+#include "scanner.h"
+#include "spill.h"
+#include "sweep.h"
+#include "writer.h"
+
+/**
+ * @brief Writes the merged list together with the runs spilled while reading the input.
+ *
+ * The runs and the list are sorted streams, so they're merged on the fly, and
+ * their read buffers share a half of the memory limit.
+ *
+ * @param list The merged list.
+ * @param spill_runs The spilled runs.
+ * @param max_memory The memory limit.
+ * @param writer The writer to append the CIDR blocks to.
+ * @return The total number of CIDR blocks written.
+ */
+static size_t write_with_spilled_runs(const ipRangeList *list, SpillRuns *spill_runs, const size_t max_memory,
+                                      Writer *writer) {
+    size_t buffer_size = max_memory / 2 / spill_runs->count;
+    buffer_size = buffer_size < MIN_SPILL_BUFFER_SIZE ? MIN_SPILL_BUFFER_SIZE
+                : buffer_size > SPILL_BUFFER_SIZE ? SPILL_BUFFER_SIZE
+                : buffer_size;
+    open_spilled_runs(spill_runs, buffer_size);
+
+    RangeStream *streams = malloc((spill_runs->count + 1) * sizeof(RangeStream));
+    if (!streams) {
+        perror("Failed to allocate merge streams");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < spill_runs->count; i++) {
+        streams[i] = (RangeStream){.next = next_spilled_range, .source = &spill_runs->runs[i]};
+    }
+    ListCursor cursor = {.list = list, .position = 0};
+    streams[spill_runs->count] = (RangeStream){.next = next_list_range, .source = &cursor};
+
+    const size_t total_cidr_count = merge_range_streams(streams, spill_runs->count + 1, writer);
+    free(streams);
+
+    return total_cidr_count;
+}
+
+
+/**
+ * @brief Opens the output given by the command line options.
+ *
+ * @param options The command line options (no output file means stdout).
+ * @return A pointer to the new writer.
+ */
+static Writer *open_output(const CommandLineOptions *options) {
+    return options->output ? open_file_writer(options->output) : open_stream_writer(stdout);
+}
+
+
+/**
+ * @brief Merges the sorted inputs on the fly and writes the result.
+ *
+ * Every input is read chunk by chunk as a sorted stream, so the memory is
+ * proportional to the number of the inputs rather than to their size. All the
+ * inputs are opened before the output is, so a missing one leaves no output
+ * behind.
+ *
+ * @param options The command line options (no files means stdin).
+ * @param reader_options Reading options.
+ * @return The total number of CIDR blocks written.
+ */
+static size_t write_sorted_inputs(const CommandLineOptions *options, const ReaderOptions *reader_options) {
+    const size_t count = options->file_count ? options->file_count : 1;
+    FILE **files = malloc(count * sizeof(FILE *));
+    SortedReader **readers = malloc(count * sizeof(SortedReader *));
+    RangeStream *streams = malloc(count * sizeof(RangeStream));
+    if (!files || !readers || !streams) {
+        perror("Failed to allocate merge streams");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const char *name = options->file_count ? options->files[i] : "stdin";
+        files[i] = options->file_count ? fopen(name, "r") : stdin;
+        if (!files[i]) {
+            perror("Failed to open file");
+            exit(EXIT_FAILURE);
+        }
+        readers[i] = open_sorted_reader(files[i], name, reader_options);
+        streams[i] = (RangeStream){.next = next_sorted_range, .source = readers[i]};
+    }
+
+    Writer *writer = open_output(options);
+    const size_t total_cidr_count = merge_range_streams(streams, count, writer);
+    close_writer(writer);
+
+    for (size_t i = 0; i < count; i++) {
+        close_sorted_reader(readers[i]);
+        if (files[i] != stdin) {
+            fclose(files[i]);
+        }
+    }
+    free(streams);
+    free(readers);
+    free(files);
+
+    return total_cidr_count;
+}
+
 
 /**
  * @brief Entry point of the program that processes command line options
@@ -46,25 +152,91 @@ int main(const int argc, char *argv[]) {
         }
     #endif
 
-    const CommandLineOptions options = parse_command_line_options(argc, argv);
-    ipRangeList *ip_range_list = NULL;
+    CommandLineOptions options = parse_command_line_options(argc, argv);
+    SpillRuns spill_runs = {0};
+    // the sorted inputs are merged on the fly, so there's nothing to drop the duplicates from
+    DedupSet dedup_set;
+    if (options.dedup && !options.sorted) {
+        init_dedup_set(&dedup_set);
+    }
+    const ReaderOptions reader_options = {
+        .buffer_size = options.buffer_size, .threads = options.threads, .online = options.online,
+        .max_memory = options.max_memory, .spill_runs = &spill_runs,
+        .dedup = options.dedup && !options.sorted ? &dedup_set : NULL, .async_io = options.async_io,
+        .debug = options.debug,
+    };
+    MergeOptions merge_options = {
+        .threads = options.threads, .engine = options.engine, .max_memory = options.max_memory,
+    };
+
+    // the threads are started once and shared by all the parallel phases
+    const unsigned pool_size = start_thread_pool(options.threads, options.pin);
 
-    if (options.file) {
+    if (options.debug) {
+        printf("DEBUG: Using the %s scanner\n", get_scanner()->name);
+        printf("DEBUG: Using the %s merge sweep\n", get_sweeper()->name);
+        printf("DEBUG: Using %u thread(s)\n", options.threads);
+        if (pool_size > 1) {
+            printf("DEBUG: Started a pool of %u thread(s)%s\n", pool_size, options.pin ? " pinned to CPUs" : "");
+        }
+        if (options.online) {
+            printf("DEBUG: Merging the input while reading it\n");
+        }
+        if (options.max_memory) {
+            printf("DEBUG: Limiting the parsed input to %zu bytes\n", options.max_memory);
+        }
+    }
+
+    for (size_t i = 0; options.debug && i < options.file_count; i++) {
+        printf("DEBUG: Reading from file: %s\n", options.files[i]);
+    }
+    if (options.debug && !options.file_count) {
+        printf("DEBUG: Reading from stdin\n");
+    }
+
+    size_t total_merged_cidrs = 0;
+    if (options.sorted) {
+        // the inputs are merged as they're read, so there's nothing to keep in memory
         if (options.debug) {
-            printf("DEBUG: Reading from file: %s\n", options.file);
+            printf("DEBUG: Merging %zu sorted input(s) on the fly\n", options.file_count ? options.file_count : 1);
         }
-        ip_range_list = read_from_file(options.file);
+        total_merged_cidrs = write_sorted_inputs(&options, &reader_options);
     } else {
+        ipRangeList *ip_range_list = options.file_count
+            ? read_from_files(options.files, options.file_count, &reader_options)
+            : read_from_stdin(&reader_options);
+        if (reader_options.dedup) {
+            free_dedup_set(&dedup_set);
+        }
+
+        merge_options.engine = plan_merge_engine(ip_range_list, &merge_options);
         if (options.debug) {
-            printf("DEBUG: Reading from stdin\n");
+            if (reader_options.dedup) {
+                const DedupStats *stats = &dedup_set.stats;
+                printf("DEBUG: Dropped %zu duplicate(s) of %zu parsed entries (%.1f%%)\n",
+                       stats->duplicates, stats->entries,
+                       stats->entries ? 100.0 * (double)stats->duplicates / (double)stats->entries : 0.0);
+            }
+            if (spill_runs.count) {
+                printf("DEBUG: Spilled %zu sorted run(s) to temporary files\n", spill_runs.count);
+            }
+            printf("DEBUG: Using the %s merge engine for %zu range(s) and %zu host(s)\n",
+                   get_merge_engine_name(merge_options.engine), ip_range_list->length, ip_range_list->host_count);
         }
-        ip_range_list = read_from_stdin();
+
+        // the input isn't needed after the merge, so the result takes its place
+        merge_cidr_in_place(ip_range_list, &merge_options);
+        Writer *writer = open_output(&options);
+        total_merged_cidrs = spill_runs.count
+            ? write_with_spilled_runs(ip_range_list, &spill_runs, options.max_memory, writer)
+            : write_ip_ranges_in_parallel(ip_range_list, writer, options.threads);
+        close_writer(writer);
+        free_spilled_runs(&spill_runs);
+        freeIpRangeList(ip_range_list);
     }
+    free_command_line_options(&options);
+    stop_thread_pool();
 
-    ipRangeList *merged_ip_range = merge_cidr(ip_range_list);
-    freeIpRangeList(ip_range_list);
-    const size_t total_merged_cidrs = print_ip_ranges(merged_ip_range);
-    freeIpRangeList(merged_ip_range);
     if (total_merged_cidrs > 0) {
         if (options.debug) {
             printf("DEBUG: Merged IP ranges in the CIDR format (total: %zu)\n", total_merged_cidrs);
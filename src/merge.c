@@ -16,184 +16,303 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
 #ifdef _WIN32
     #include <stdint.h>
 #endif
 
+#include "bitmap.h"
+#include "cidr.h"
 #include "merge.h"
+#include "parallel.h"
+#include "sort.h"
+#include "sweep.h"
 
 
 #define ALL_ONES 0xFFFFFFFF
+// arrays shorter than this are not worth merging in parallel
+#define MIN_PARALLEL_MERGE_SIZE (64 * 1024)
+// the ranges formatted by one task of `write_ip_ranges_in_parallel()`
+#define FORMAT_CHUNK_SIZE (16 * 1024)
+// the chunks formatted per thread before the texts are written out, which bounds the memory
+#define FORMAT_CHUNKS_PER_THREAD 4
+// the room for the text of the longest range
+#define MAX_RANGE_TEXT_LENGTH (MAX_CIDRS_PER_RANGE * CIDR_MAX_LENGTH)
 
 
-/**
- * @brief Computes the maximum number of CIDRs in a given IP range.
- *
- * This function calculates the difference between the maximum IP and
- * minimum IP in the given ipRange and adds one to include both endpoints.
- * The result represents the count of CIDRs that can exist within that range.
- *
- * @param range Pointer to an ipRange structure containing the minimum and
- * maximum IP addresses.
- * @return The maximum number of CIDRs within the specified IP range.
- */
-inline size_t get_max_cidr_count(const ipRange *range) {
-    return range->max_ip.s_addr - range->min_ip.s_addr + 1;
-}
+// The rough costs (in nanoseconds) the planner compares: sorting a range or a host,
+// marking an entry in the bitmap, and allocating and scanning a /16 page of the bitmap
+#define RADIX_RANGE_COST 60
+#define RADIX_HOST_COST 30
+#define BITMAP_ENTRY_COST 15
+#define BITMAP_PAGE_COST 6000
 
-/**
- * @brief Compares two `ipRange` structures for sorting.
- *
- * This function is used to compare two `ipRange` structures, which contain
- * a minimum and a maximum IP address. The comparison is primarily based on
- * the `min_ip` field. If the `min_ip` values are equal, it compares the
- * `max_ip` values.
- *
- * @param a Pointer to the first `ipRange` structure.
- * @param b Pointer to the second `ipRange` structure.
- * @return An integer less than, equal to, or greater than zero if the `min_ip`
- *         of `a` is found, respectively, to be less than, equal to, or greater
- *         than the `min_ip` of `b`. If `min_ip` values are equal, the comparison
- *         is based on the `max_ip` values.
- */
-int compare_ip_ranges(const void *a, const void *b) {
-    const ipRange *rangeA = (ipRange *)a;
-    const ipRange *rangeB = (ipRange *)b;
 
-    // first compare min_ip
-    if (rangeA->min_ip.s_addr < rangeB->min_ip.s_addr) return -1;
-    if (rangeA->min_ip.s_addr > rangeB->min_ip.s_addr) return 1;
+// indexed by MergeEngine
+static const char *const MERGE_ENGINE_NAMES[] = {"auto", "qsort", "radix", "bitmap"};
+
 
-    // now - max_ip
-    if (rangeA->max_ip.s_addr < rangeB->max_ip.s_addr) return -1;
-    if (rangeA->max_ip.s_addr > rangeB->max_ip.s_addr) return 1;
+// A chunk of the sorted array merged by one of the threads
+typedef struct {
+    const Sweeper *sweeper;
+    const ipRange *ranges;
+    size_t length;
+    ipRange *merged;
+    size_t count;
+} MergeTask;
 
-    return 0; // they are equal
+
+static void merge_chunk(void *argument) {
+    MergeTask *task = argument;
+    task->count = task->sweeper->sweep(task->ranges, task->length, task->merged);
 }
 
 
 /**
- * Function to merge an array of IP ranges.
+ * @brief Merges the sorted array of IP ranges into the `merged` array.
  *
- * This function takes an input array of `ipRange` structures representing IP ranges
- * and merges overlapping or contiguous ranges into a result array.
+ * Large arrays are split into chunks which are merged by separate threads. After that
+ * the results are stitched together: the first ranges of a chunk may overlap or touch
+ * the last range of the previous one.
  *
- * @param rawRanges An array of `ipRange` structures representing the IP ranges to be merged.
- * @return The number of merged IP ranges stored in the `result` array.
+ * @param ranges The sorted array of IP ranges.
+ * @param length The number of ranges in the array.
+ * @param merged The array for the merged ranges, at least `length` long. It may be
+ *               the `ranges` array itself.
+ * @param threads The number of threads to use.
+ * @return The number of the merged ranges.
  */
-ipRangeList *merge_ip_ranges(const ipRangeList *rawRanges) {
-    ipRangeList *result = getIpRangeList(rawRanges->length);
-    if (rawRanges->length == 0) {
-        return result;
+static size_t sweep_ip_ranges(const ipRange *ranges, const size_t length, ipRange *merged, const unsigned threads) {
+    const Sweeper *sweeper = get_sweeper();
+
+    if (threads <= 1 || length < MIN_PARALLEL_MERGE_SIZE) {
+        return sweeper->sweep(ranges, length, merged);
     }
 
-    ipRange current = rawRanges->cidrs[0];
+    MergeTask *tasks = calloc(threads, sizeof(MergeTask));
+    if (!tasks) {
+        perror("Failed to allocate merge tasks");
+        exit(EXIT_FAILURE);
+    }
 
-    if (current.max_ip.s_addr == ALL_ONES) {
-        appendIpRange(result, &current);
-        return result;
+    // every chunk is merged into the same place of the result, so the chunks never overlap
+    const size_t chunk_length = length / threads;
+    for (size_t i = 0; i < threads; i++) {
+        const size_t start = chunk_length * i;
+        tasks[i].sweeper = sweeper;
+        tasks[i].ranges = ranges + start;
+        tasks[i].length = i + 1 == threads ? length - start : chunk_length;
+        tasks[i].merged = merged + start;
     }
 
-    for (size_t i = 1; i < rawRanges->length; ++i) {
-        if (rawRanges->cidrs[i].max_ip.s_addr == ALL_ONES) {
-            appendIpRange(result, &(ipRange){.min_ip = current.min_ip, .max_ip = {ALL_ONES}});
-            return result;
+    run_in_parallel(merge_chunk, tasks, sizeof(MergeTask), threads);
+
+    size_t total = tasks[0].count;
+    for (size_t i = 1; i < threads; i++) {
+        ipRange *last = &merged[total - 1];
+        const ipRange *chunk = tasks[i].merged;
+        size_t count = tasks[i].count;
+
+        if (last->max_ip.s_addr == ALL_ONES) {
+            break;
         }
 
-        if ((current.max_ip.s_addr + 1) >= rawRanges->cidrs[i].min_ip.s_addr) {
-            if (current.max_ip.s_addr < rawRanges->cidrs[i].max_ip.s_addr) {
-                current.max_ip = rawRanges->cidrs[i].max_ip;
+        // a range may swallow several ranges of the next chunk
+        while (count > 0 && chunk->min_ip.s_addr <= last->max_ip.s_addr + 1) {
+            if (last->max_ip.s_addr < chunk->max_ip.s_addr) {
+                last->max_ip = chunk->max_ip;
+            }
+            chunk++;
+            count--;
+            if (last->max_ip.s_addr == ALL_ONES) {
+                count = 0;
             }
-        } else {
-            appendIpRange(result, &current);
-            current = rawRanges->cidrs[i];
         }
-    }
 
-    if (result->length) {
-        if (result->cidrs[result->length - 1].max_ip.s_addr != current.max_ip.s_addr) {
-            result->cidrs[result->length++] = current;
-        }
-    } else {
-        result->cidrs[result->length++] = current;
+        memmove(merged + total, chunk, count * sizeof(ipRange));
+        total += count;
     }
 
-    return result;
+    free(tasks);
+    return total;
 }
 
 
 /**
- * @brief Calculate the number of bits in the length of a range.
+ * Function to merge an array of IP ranges.
  *
- * This function computes the bit length of the given integer, effectively
- * counting the number of bits required to represent the value.
+ * This function takes a sorted array of `ipRange` structures representing IP ranges
+ * and merges overlapping or contiguous ranges into a result array.
  *
- * @param x The integer value for which to calculate the bit length.
- * @return The number of bits required to represent the range.
+ * @param rawRanges An array of `ipRange` structures representing the IP ranges to be merged.
+ * @param threads The number of threads to use.
+ * @return The number of merged IP ranges stored in the `result` array.
  */
-uint32_t bit_length(const uint32_t x) {
-    return x == 0 ? 0 : (int)log2(x) + 1;
+ipRangeList *merge_ip_ranges(const ipRangeList *rawRanges, const unsigned threads) {
+    ipRangeList *result = getIpRangeList(rawRanges->length);
+    result->length = sweep_ip_ranges(rawRanges->cidrs, rawRanges->length, result->cidrs, threads);
+    return result;
 }
 
 
 /**
- * @brief Count the number of trailing zero bits in an integer.
+ * @brief Writes an IP range in CIDR notation to the writer.
  *
- * This function calculates the number of consecutive zero bits at the
- * least significant end of the given integer. If the input number is zero,
- * it returns the provided bit count.
+ * @param range The IP range to be written.
+ * @param writer The writer to append the CIDR blocks to.
  *
- * @param number The integer value to be analyzed.
- * @param bits The number of bits to consider for the operation.
- * @return The count of trailing zero bits.
+ * @return The number of CIDR blocks written.
  */
-uint32_t count_right_hand_zero_bits(const uint32_t number, const uint32_t bits) {
-    if (number == 0) {
-        return bits;
+size_t write_ip_range(const ipRange *range, Writer *writer) {
+    CidrBlock blocks[MAX_CIDRS_PER_RANGE];
+    const size_t count = split_range_to_cidrs(range->min_ip.s_addr, range->max_ip.s_addr, blocks);
+    for (size_t block = 0; block < count; block++) {
+        write_cidr(writer, blocks[block].network, blocks[block].prefix);
     }
-    return (uint32_t)fmin(bits, bit_length(~number & (number - 1)));
+    return count;
 }
 
 
 /**
- * @brief Writes IP ranges in CIDR notation to a file.
+ * @brief Writes IP ranges in CIDR notation to the writer.
  *
  * This function iterates over an array of `ipRange` structures, converts each range
- * into CIDR notation, and writes the CIDR blocks to the specified output file stream.
+ * into CIDR notation, and writes the CIDR blocks to the writer.
  * It returns the total number of CIDR blocks written.
  *
  * @param ranges Pointer to an array of `ipRange` structures representing the IP ranges to be written.
- * @param out The output file stream where the CIDR blocks will be written.
+ * @param writer The writer to append the CIDR blocks to.
  *
- * @return The total number of CIDR blocks written to the file.
+ * @return The total number of CIDR blocks written.
  */
-size_t write_ip_ranges_to_file(const ipRangeList *ranges, FILE *out) {
+size_t write_ip_ranges(const ipRangeList *ranges, Writer *writer) {
     size_t total_cidr_count = 0;
 
     for (size_t i = 0; i < ranges->length; ++i) {
-        uint32_t first = ranges->cidrs[i].min_ip.s_addr;
-        const uint32_t last = ranges->cidrs[i].max_ip.s_addr;
+        total_cidr_count += write_ip_range(&ranges->cidrs[i], writer);
+    }
 
-        while ((first <= last) && (first - 1 != ALL_ONES)) {
-            const unsigned short IP_BITS = 32;
-            const uint32_t nbits = (uint32_t)fmin(
-                count_right_hand_zero_bits(first, IP_BITS),
-                bit_length(last - first + 1) - 1
-            );
+    return total_cidr_count;
+}
 
-            const struct in_addr addr = {.s_addr = htonl(first)};
-            fprintf(out, "%s/%d\n", inet_ntoa(addr), IP_BITS - nbits);
-            total_cidr_count++;
 
-            first += 1 << nbits;
+// A chunk of the merged ranges formatted into the text by one of the threads
+typedef struct {
+    const ipRange *ranges;
+    size_t length;
+    char *text;        // kept between the rounds, so it's allocated once per task
+    size_t capacity;
+    size_t text_length;
+    size_t cidr_count;
+} FormatTask;
+
+
+static void format_chunk(void *argument) {
+    FormatTask *task = argument;
+    CidrBlock blocks[MAX_CIDRS_PER_RANGE];
+    task->text_length = 0;
+    task->cidr_count = 0;
+
+    for (size_t i = 0; i < task->length; i++) {
+        if (task->capacity - task->text_length < MAX_RANGE_TEXT_LENGTH) {
+            const size_t capacity = task->capacity * 2 + MAX_RANGE_TEXT_LENGTH;
+            char *text = realloc(task->text, capacity);
+            if (!text) {
+                perror("Failed to allocate output text");
+                exit(EXIT_FAILURE);
+            }
+            task->text = text;
+            task->capacity = capacity;
         }
 
-        if (first - 1 == ALL_ONES) {
-            break;
+        const size_t count = split_range_to_cidrs(task->ranges[i].min_ip.s_addr, task->ranges[i].max_ip.s_addr, blocks);
+        char *cursor = task->text + task->text_length;
+        for (size_t block = 0; block < count; block++) {
+            cursor = format_cidr(cursor, blocks[block].network, blocks[block].prefix);
+        }
+        task->text_length = (size_t)(cursor - task->text);
+        task->cidr_count += count;
+    }
+}
+
+
+/**
+ * @brief Writes IP ranges in CIDR notation to the writer using several threads.
+ *
+ * The ranges are split into chunks, which are split into CIDR blocks and formatted
+ * by separate threads, each into its own buffer. The buffers are written out in
+ * order, so the output is the same as the one of `write_ip_ranges()`. The chunks are
+ * processed in rounds of a few per thread, so the text of the whole list is never
+ * kept in memory.
+ *
+ * @param ranges Pointer to an array of `ipRange` structures representing the IP ranges to be written.
+ * @param writer The writer to append the CIDR blocks to.
+ * @param threads The number of threads to use.
+ *
+ * @return The total number of CIDR blocks written.
+ */
+size_t write_ip_ranges_in_parallel(const ipRangeList *ranges, Writer *writer, const unsigned threads) {
+    if (threads <= 1 || ranges->length < MIN_PARALLEL_MERGE_SIZE) {
+        return write_ip_ranges(ranges, writer);
+    }
+
+    const size_t chunk_count = (size_t)threads * FORMAT_CHUNKS_PER_THREAD;
+    FormatTask *tasks = calloc(chunk_count, sizeof(FormatTask));
+    const char **texts = malloc(chunk_count * sizeof(char *));
+    size_t *lengths = malloc(chunk_count * sizeof(size_t));
+    if (!tasks || !texts || !lengths) {
+        perror("Failed to allocate format tasks");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t total_cidr_count = 0;
+    for (size_t start = 0; start < ranges->length;) {
+        size_t count = 0;
+        for (; count < chunk_count && start < ranges->length; count++) {
+            const size_t remaining = ranges->length - start;
+            tasks[count].ranges = ranges->cidrs + start;
+            tasks[count].length = remaining < FORMAT_CHUNK_SIZE ? remaining : FORMAT_CHUNK_SIZE;
+            start += tasks[count].length;
+        }
+
+        run_in_parallel(format_chunk, tasks, sizeof(FormatTask), count);
+
+        for (size_t i = 0; i < count; i++) {
+            texts[i] = tasks[i].text;
+            lengths[i] = tasks[i].text_length;
+            total_cidr_count += tasks[i].cidr_count;
         }
+        write_texts(writer, texts, lengths, count);
     }
 
+    for (size_t i = 0; i < chunk_count; i++) {
+        free(tasks[i].text);
+    }
+    free(lengths);
+    free(texts);
+    free(tasks);
+
+    return total_cidr_count;
+}
+
+
+/**
+ * @brief Writes IP ranges in CIDR notation to a file.
+ *
+ * This function iterates over an array of `ipRange` structures, converts each range
+ * into CIDR notation, and writes the CIDR blocks to the specified output file stream.
+ * It returns the total number of CIDR blocks written.
+ *
+ * @param ranges Pointer to an array of `ipRange` structures representing the IP ranges to be written.
+ * @param out The output file stream where the CIDR blocks will be written.
+ *
+ * @return The total number of CIDR blocks written to the file.
+ */
+size_t write_ip_ranges_to_file(const ipRangeList *ranges, FILE *out) {
+    Writer *writer = open_stream_writer(out);
+    const size_t total_cidr_count = write_ip_ranges(ranges, writer);
+    close_writer(writer);
+
     return total_cidr_count;
 }
 
@@ -212,18 +331,308 @@ size_t print_ip_ranges(const ipRangeList *ranges) {
 }
 
 /**
- * @brief Merges and converts a list of CIDR blocks into an array of `CidrRecord` structures.
+ * @brief Sorts the ranges of the list in place, leaving its hosts aside.
  *
- * This function processes a list of CIDR blocks, parses them into IP ranges, merges overlapping
- * or contiguous ranges, and then converts the merged ranges back into CIDR strings. The resultant
- * CIDR strings are stored in a newly allocated array.
+ * @param cidr_list The list of IP ranges.
+ * @param engine The engine which sorts the ranges: MERGE_ENGINE_QSORT or MERGE_ENGINE_RADIX.
+ * @param threads The number of threads to use.
+ * @return false if the ranges are canonical already, i.e. there's nothing to merge; true otherwise.
+ */
+static bool sort_list_ranges(const ipRangeList *cidr_list, const MergeEngine engine, const unsigned threads) {
+    if (engine == MERGE_ENGINE_QSORT) {
+        if (cidr_list->length) {
+            qsort(cidr_list->cidrs, cidr_list->length, sizeof(ipRange), compare_ip_ranges);
+        }
+        return true;
+    }
+
+    // Many inputs (RIR exports, the output of the previous run) are sorted already
+    // or consist of a few sorted pieces, so look at the order before sorting
+    const RangeOrder order = scan_ip_range_order(cidr_list->cidrs, cidr_list->length, MAX_NATURAL_RUNS);
+
+    if (order.canonical) {
+        return false;
+    }
+
+    // Sort input CIDRs
+    if (order.runs > MAX_NATURAL_RUNS) {
+        sort_ip_ranges_in_parallel(cidr_list->cidrs, cidr_list->length, threads);
+    } else if (order.runs > 1) {
+        merge_sorted_runs(cidr_list->cidrs, cidr_list->length);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Sorts the hosts of the list in place.
  *
- * @param cidr_list A list of C-strings representing CIDR blocks.
+ * @param cidr_list The list of hosts.
+ * @param engine The engine which sorts the hosts: MERGE_ENGINE_QSORT or MERGE_ENGINE_RADIX.
+ */
+static void sort_list_hosts(const ipRangeList *cidr_list, const MergeEngine engine) {
+    if (engine == MERGE_ENGINE_QSORT) {
+        qsort(cidr_list->hosts, cidr_list->host_count, sizeof(uint32_t), compare_ip_hosts);
+    } else {
+        sort_ip_hosts(cidr_list->hosts, cidr_list->host_count);
+    }
+}
+
+
+/**
+ * @brief Counts the runs of consecutive addresses in the sorted array of hosts.
  *
- * @return The number of resulting CIDR records stored in the `cidr_records` array.
+ * @param hosts The sorted array of host addresses.
+ * @param count The number of addresses in the array.
+ * @return The number of runs (duplicates belong to the same run).
  */
-ipRangeList *merge_cidr(const ipRangeList *cidr_list) {
-    // Sort input CIDRs
-    qsort(cidr_list->cidrs, cidr_list->length, sizeof(ipRange), compare_ip_ranges);
-    return merge_ip_ranges(cidr_list);
+static size_t count_host_runs(const uint32_t *hosts, const size_t count) {
+    size_t runs = count ? 1 : 0;
+    for (size_t i = 1; i < count; i++) {
+        runs += hosts[i] - hosts[i - 1] > 1;
+    }
+    return runs;
+}
+
+
+/**
+ * @brief Collapses the previous run of consecutive addresses into a range.
+ *
+ * @param hosts The sorted array of host addresses.
+ * @param position A pointer to the position right after the run, it's moved to the start of the run.
+ * @return The range covering the run.
+ */
+static ipRange previous_host_run(const uint32_t *hosts, size_t *position) {
+    const uint32_t last = hosts[--(*position)];
+    uint32_t first = last;
+    while (*position > 0 && first - hosts[*position - 1] <= 1) {
+        first = hosts[--(*position)];
+    }
+    return (ipRange){.min_ip = {first}, .max_ip = {last}};
+}
+
+
+/**
+ * @brief Prepends the range to the sorted merged ranges, merging it with the first one if possible.
+ *
+ * @param merged The array the merged ranges are built in from its end.
+ * @param start The position of the first merged range.
+ * @param end The position right after the last merged range.
+ * @param range The range to prepend. It must not end after the first range of the array.
+ * @return The new position of the first merged range.
+ */
+static size_t prepend_merged_range(ipRange *merged, const size_t start, const size_t end, const ipRange *range) {
+    if (start < end) {
+        ipRange *first = &merged[start];
+        if (first->min_ip.s_addr == 0 || range->max_ip.s_addr >= first->min_ip.s_addr - 1) {
+            if (first->min_ip.s_addr > range->min_ip.s_addr) {
+                first->min_ip = range->min_ip;
+            }
+            return start;
+        }
+    }
+
+    merged[start - 1] = *range;
+    return start - 1;
+}
+
+
+/**
+ * @brief Merges the sorted hosts into the merged ranges of the list in place.
+ *
+ * The hosts are collapsed into runs of consecutive addresses on the fly, and both
+ * sorted sequences are merged in a single linear sweep. The sweep goes from the
+ * highest addresses down and builds the result at the end of the array, which is
+ * grown by the number of the runs only, so it never overwrites the ranges it
+ * hasn't read yet.
+ *
+ * @param ranges The list of the merged ranges, sorted and disjoint.
+ * @param hosts The sorted array of host addresses.
+ * @param host_count The number of addresses in the array.
+ */
+static void merge_hosts_into_ranges(ipRangeList *ranges, const uint32_t *hosts, const size_t host_count) {
+    const size_t end = ranges->length + count_host_runs(hosts, host_count);
+    reserveIpRangeList(ranges, end);
+
+    ipRange *cidrs = ranges->cidrs;
+    size_t start = end;
+    size_t range_position = ranges->length;
+    size_t host_position = host_count;
+
+    while (range_position > 0 || host_position > 0) {
+        if (host_position == 0
+                || (range_position > 0 && cidrs[range_position - 1].max_ip.s_addr >= hosts[host_position - 1])) {
+            const ipRange range = cidrs[--range_position];
+            start = prepend_merged_range(cidrs, start, end, &range);
+        } else {
+            const ipRange run = previous_host_run(hosts, &host_position);
+            start = prepend_merged_range(cidrs, start, end, &run);
+        }
+    }
+
+    memmove(cidrs, cidrs + start, (end - start) * sizeof(ipRange));
+    ranges->length = end - start;
+}
+
+
+/**
+ * @brief Merges overlapping CIDR blocks
+ *
+ * This function sorts the ranges and the hosts of the list, merges the overlapping
+ * or contiguous ones, and returns the merged ranges in a newly allocated list.
+ * The input keeps its ranges and hosts, though the sorting engines reorder them.
+ *
+ * The radix engine sorts the ranges and the hosts of the list separately, and the hosts
+ * join the merged ranges in the final linear sweep. The bitmap engine doesn't sort at all,
+ * but marks everything in a bitmap of the address space and scans it for runs.
+ *
+ * @param cidr_list The list of IP ranges and hosts.
+ * @param options Merging options or NULL to use the defaults.
+ *
+ * @return A new list of the merged ranges, sorted and without hosts. The caller
+ *         frees it with `freeIpRangeList()`.
+ */
+ipRangeList *merge_cidr(const ipRangeList *cidr_list, const MergeOptions *options) {
+    const MergeEngine engine = plan_merge_engine(cidr_list, options);
+    if (engine == MERGE_ENGINE_BITMAP) {
+        return merge_with_bitmap(cidr_list);
+    }
+
+    const unsigned threads = options && options->threads > 1 ? options->threads : 1;
+
+    ipRangeList *merged;
+    if (sort_list_ranges(cidr_list, engine, threads)) {
+        merged = merge_ip_ranges(cidr_list, engine == MERGE_ENGINE_QSORT ? 1 : threads);
+    } else {
+        // there's nothing to merge
+        merged = getIpRangeList(cidr_list->length);
+        appendIpRanges(merged, cidr_list->cidrs, cidr_list->length);
+    }
+
+    if (cidr_list->host_count) {
+        sort_list_hosts(cidr_list, engine);
+        merge_hosts_into_ranges(merged, cidr_list->hosts, cidr_list->host_count);
+    }
+
+    // the result is allocated for the worst case, i.e. when nothing is merged
+    shrinkIpRangeListToFit(merged);
+
+    return merged;
+}
+
+
+/**
+ * @brief Merges overlapping CIDR blocks in place.
+ *
+ * Unlike `merge_cidr()`, this function takes over the list: the merged ranges are
+ * written over its sorted ranges, the hosts are released, and the unused capacity
+ * is returned to the system. Thus, the peak memory is about the size of the input
+ * rather than twice of it.
+ *
+ * @param cidr_list The list of IP ranges and hosts. On return, it holds the merged
+ *                  ranges and no hosts.
+ * @param options Merging options or NULL to use the defaults.
+ */
+void merge_cidr_in_place(ipRangeList *cidr_list, const MergeOptions *options) {
+    const MergeEngine engine = plan_merge_engine(cidr_list, options);
+    if (engine == MERGE_ENGINE_BITMAP) {
+        merge_with_bitmap_in_place(cidr_list);
+        return;
+    }
+
+    const unsigned threads = options && options->threads > 1 ? options->threads : 1;
+
+    if (sort_list_ranges(cidr_list, engine, threads)) {
+        cidr_list->length = sweep_ip_ranges(cidr_list->cidrs, cidr_list->length, cidr_list->cidrs,
+                                            engine == MERGE_ENGINE_QSORT ? 1 : threads);
+    }
+
+    if (cidr_list->host_count) {
+        sort_list_hosts(cidr_list, engine);
+        merge_hosts_into_ranges(cidr_list, cidr_list->hosts, cidr_list->host_count);
+        cidr_list->host_count = 0;
+    }
+
+    // releases the hosts and the ranges swallowed by the merge
+    shrinkIpRangeListToFit(cidr_list);
+}
+
+
+/**
+ * @brief Chooses the merge engine for the list.
+ *
+ * The engine given by the options is used as is, unless it's MERGE_ENGINE_AUTO.
+ * Otherwise, the tiny inputs are sorted with qsort(), and for the rest the
+ * estimated costs of the radix sort and of the bitmap are compared. The sort
+ * costs in proportion to the number of the entries (the hosts are cheaper than
+ * the ranges), while the bitmap costs mostly in proportion to the number of the
+ * /16 pages it allocates, so it wins for dense inputs. Still, the bitmap is not
+ * used when its pages together with the list exceed the memory limit given by
+ * the options.
+ *
+ * @param cidr_list The list of IP ranges and hosts to be merged.
+ * @param options Merging options or NULL to use the defaults.
+ * @return The engine to use, never MERGE_ENGINE_AUTO.
+ */
+MergeEngine plan_merge_engine(const ipRangeList *cidr_list, const MergeOptions *options) {
+    if (options && options->engine != MERGE_ENGINE_AUTO) {
+        return options->engine;
+    }
+
+    const size_t entries = cidr_list->length + cidr_list->host_count;
+    if (entries <= MAX_QSORT_INPUT_SIZE) {
+        return MERGE_ENGINE_QSORT;
+    }
+
+    // the sort runs in parallel, while the bitmap is filled by a single thread
+    const unsigned threads = options && options->threads > 1 ? options->threads : 1;
+    const uint64_t radix_cost = ((uint64_t)cidr_list->length * RADIX_RANGE_COST
+                                 + (uint64_t)cidr_list->host_count * RADIX_HOST_COST) / threads;
+    const size_t pages = count_bitmap_pages(cidr_list);
+    const uint64_t bitmap_cost = (uint64_t)entries * BITMAP_ENTRY_COST + (uint64_t)pages * BITMAP_PAGE_COST;
+
+    if (bitmap_cost >= radix_cost) {
+        return MERGE_ENGINE_RADIX;
+    }
+
+    // the page table and the pages are allocated on top of the list
+    const uint64_t peak_size = (uint64_t)cidr_list->length * sizeof(ipRange)
+                               + (uint64_t)cidr_list->host_count * sizeof(uint32_t)
+                               + (uint64_t)BITMAP_PAGE_COUNT * sizeof(uint64_t *)
+                               + (uint64_t)pages * BITMAP_PAGE_WORDS * sizeof(uint64_t);
+    if (options && options->max_memory && peak_size > options->max_memory) {
+        return MERGE_ENGINE_RADIX;
+    }
+
+    return MERGE_ENGINE_BITMAP;
+}
+
+
+/**
+ * @brief Returns the name of the merge engine, e.g. "radix".
+ *
+ * @param engine The merge engine.
+ * @return A constant C-string with the name of the engine.
+ */
+const char *get_merge_engine_name(const MergeEngine engine) {
+    return MERGE_ENGINE_NAMES[engine];
+}
+
+
+/**
+ * @brief Finds the merge engine by its name.
+ *
+ * @param name The name of the engine, e.g. "bitmap".
+ * @param engine A pointer to store the engine.
+ * @return true if the engine is found; false otherwise.
+ */
+bool find_merge_engine(const char *name, MergeEngine *engine) {
+    for (size_t i = 0; i < sizeof(MERGE_ENGINE_NAMES) / sizeof(MERGE_ENGINE_NAMES[0]); i++) {
+        if (strcmp(name, MERGE_ENGINE_NAMES[i]) == 0) {
+            *engine = (MergeEngine)i;
+            return true;
+        }
+    }
+    return false;
 }
@@ -17,29 +17,140 @@
 #ifndef MERGE_IP_MERGE_H
 #define MERGE_IP_MERGE_H
 
+#include <stdbool.h>
 #include <stdio.h>
 
 #include "ipRange.h"
+#include "writer.h"
 
-#define CIDR_SIZE 20
+// the inputs up to this size are sorted with qsort() by the AUTO engine
+#define MAX_QSORT_INPUT_SIZE 1024
 
-typedef char CidrRecord[CIDR_SIZE];
+typedef enum {
+    MERGE_ENGINE_AUTO,   // chosen by `plan_merge_engine()` for the given input
+    MERGE_ENGINE_QSORT,  // sorts with qsort(), no extra memory, for the tiny inputs
+    MERGE_ENGINE_RADIX,  // sorts the ranges and folds the overlapping ones
+    MERGE_ENGINE_BITMAP, // marks the ranges in a bitmap of the address space, see bitmap.h
+} MergeEngine;
+
+typedef struct {
+    unsigned threads; // 0 or 1 means the merge runs on the calling thread only
+    MergeEngine engine;
+    size_t max_memory; // 0 means no limit, otherwise the AUTO engine keeps the bitmap and the list within it
+} MergeOptions;
+
+
+/**
+ * @brief Returns the name of the merge engine, e.g. "radix".
+ *
+ * @param engine The merge engine.
+ * @return A constant C-string with the name of the engine.
+ */
+const char *get_merge_engine_name(MergeEngine engine);
+
+
+/**
+ * @brief Finds the merge engine by its name.
+ *
+ * @param name The name of the engine, e.g. "bitmap".
+ * @param engine A pointer to store the engine.
+ * @return true if the engine is found; false otherwise.
+ */
+bool find_merge_engine(const char *name, MergeEngine *engine);
 
 /**
  * @brief Merges overlapping CIDR blocks
  *
- * This function processes a list of CIDR blocks, parses them into IP ranges,
- * merges overlapping or contiguous ranges, and then converts the merged ranges
- * back into CIDR strings. The resultant CIDR strings are stored in a newly
- * allocated array.
+ * This function sorts the ranges and the hosts of the list, merges the overlapping
+ * or contiguous ones, and returns the merged ranges in a newly allocated list.
+ * The input keeps its ranges and hosts, though the sorting engines reorder them.
+ *
+ * @param cidr_list The list of IP ranges and hosts.
+ * @param options Merging options or NULL to use the defaults.
+ *
+ * @return A new list of the merged ranges, sorted and without hosts. The caller
+ *         frees it with `freeIpRangeList()`.
+ */
+ipRangeList *merge_cidr(const ipRangeList *cidr_list, const MergeOptions *options);
+
+
+/**
+ * @brief Merges overlapping CIDR blocks in place.
+ *
+ * Unlike `merge_cidr()`, this function takes over the list: the merged ranges are
+ * written over its sorted ranges, the hosts are released, and the unused capacity
+ * is returned to the system. Thus, the peak memory is about the size of the input
+ * rather than twice of it.
+ *
+ * @param cidr_list The list of IP ranges and hosts. On return, it holds the merged
+ *                  ranges and no hosts.
+ * @param options Merging options or NULL to use the defaults.
+ */
+void merge_cidr_in_place(ipRangeList *cidr_list, const MergeOptions *options);
+
+
+/**
+ * @brief Chooses the merge engine for the list.
+ *
+ * The engine given by the options is used as is, unless it's MERGE_ENGINE_AUTO.
+ * Otherwise, the tiny inputs are sorted with qsort(), and for the rest the
+ * estimated costs of the radix sort and of the bitmap are compared. The sort
+ * costs in proportion to the number of the entries (the hosts are cheaper than
+ * the ranges), while the bitmap costs mostly in proportion to the number of the
+ * /16 pages it allocates, so it wins for dense inputs. Still, the bitmap is not
+ * used when its pages together with the list exceed the memory limit given by
+ * the options.
+ *
+ * @param cidr_list The list of IP ranges and hosts to be merged.
+ * @param options Merging options or NULL to use the defaults.
+ * @return The engine to use, never MERGE_ENGINE_AUTO.
+ */
+MergeEngine plan_merge_engine(const ipRangeList *cidr_list, const MergeOptions *options);
+
+
+/**
+ * @brief Writes an IP range in CIDR notation to the writer.
  *
- * @param cidr_list A list of C-strings representing CIDR blocks.
+ * @param range The IP range to be written.
+ * @param writer The writer to append the CIDR blocks to.
  *
- * @return The number of resulting CIDR records stored in the `cidr_records` array.
+ * @return The number of CIDR blocks written.
  */
-ipRangeList *merge_cidr(const ipRangeList *cidr_list);
+size_t write_ip_range(const ipRange *range, Writer *writer);
 
 
+/**
+ * @brief Writes IP ranges in CIDR notation to the writer.
+ *
+ * This function iterates over an array of `ipRange` structures, converts each range
+ * into CIDR notation, and writes the CIDR blocks to the writer.
+ * It returns the total number of CIDR blocks written.
+ *
+ * @param ranges Pointer to an array of `ipRange` structures representing the IP ranges to be written.
+ * @param writer The writer to append the CIDR blocks to.
+ *
+ * @return The total number of CIDR blocks written.
+ */
+size_t write_ip_ranges(const ipRangeList *ranges, Writer *writer);
+
+
+/**
+ * @brief Writes IP ranges in CIDR notation to the writer using several threads.
+ *
+ * The ranges are split into chunks, which are split into CIDR blocks and formatted
+ * by separate threads, each into its own buffer. The buffers are written out in
+ * order, so the output is the same as the one of `write_ip_ranges()`. The chunks are
+ * processed in rounds of a few per thread, so the text of the whole list is never
+ * kept in memory.
+ *
+ * @param ranges Pointer to an array of `ipRange` structures representing the IP ranges to be written.
+ * @param writer The writer to append the CIDR blocks to.
+ * @param threads The number of threads to use.
+ *
+ * @return The total number of CIDR blocks written.
+ */
+size_t write_ip_ranges_in_parallel(const ipRangeList *ranges, Writer *writer, unsigned threads);
+
 
 /**
  * @brief Writes IP ranges in CIDR notation to a file.
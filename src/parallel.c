@@ -0,0 +1,660 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// `sched_getaffinity()` and `pthread_setaffinity_np()` are GNU extensions
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+#include "parallel.h"
+#include "atomics.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL _Thread_local
+#endif
+
+
+// the attempts to make progress which just spin, and then the ones which yield the CPU
+#define SPIN_ATTEMPTS 64
+#define YIELD_ATTEMPTS 128
+// how long a thread sleeps when there's no progress for a while; the sleep doubles every
+// few attempts up to the longest one, so a thread waiting for a slow producer rarely wakes up
+#define IDLE_SLEEP_NANOSECONDS 50000
+#define MAX_IDLE_SLEEP_NANOSECONDS 10000000
+#define SLEEPS_PER_DOUBLING 8
+
+// the states of the gate of `run_concurrently()`
+#define GATE_CLOSED 0
+#define GATE_OPEN 1
+#define GATE_CANCELLED 2
+
+// the tasks a deque of the pool can hold, the others are executed by the submitting thread
+#define DEQUE_CAPACITY 1024
+// the quota of the CPU time of the cgroup (v2 and v1)
+#define CGROUP_CPU_MAX "/sys/fs/cgroup/cpu.max"
+#define CGROUP_CPU_QUOTA "/sys/fs/cgroup/cpu/cpu.cfs_quota_us"
+#define CGROUP_CPU_PERIOD "/sys/fs/cgroup/cpu/cpu.cfs_period_us"
+
+
+typedef struct {
+    TaskFunction task;
+    void *argument;
+    const AtomicSize *gate;  // the task waits until the gate is open, NULL means "don't wait"
+    bool started;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+} Worker;
+
+
+static void run_worker(const Worker *worker) {
+    size_t gate = worker->gate ? load_acquire(worker->gate) : GATE_OPEN;
+    for (unsigned attempt = 0; gate == GATE_CLOSED; attempt++) {
+        wait_for_progress(attempt);
+        gate = load_acquire(worker->gate);
+    }
+
+    if (gate == GATE_OPEN) {
+        worker->task(worker->argument);
+    }
+}
+
+
+#ifdef _WIN32
+static DWORD WINAPI worker_entry(LPVOID argument) {
+    run_worker(argument);
+    return 0;
+}
+#else
+static void *worker_entry(void *argument) {
+    run_worker(argument);
+    return NULL;
+}
+#endif
+
+
+static bool start_worker(Worker *worker) {
+#ifdef _WIN32
+    worker->thread = CreateThread(NULL, 0, worker_entry, worker, 0, NULL);
+    worker->started = worker->thread != NULL;
+#else
+    worker->started = pthread_create(&worker->thread, NULL, worker_entry, worker) == 0;
+#endif
+    return worker->started;
+}
+
+
+static void join_worker(const Worker *worker) {
+#ifdef _WIN32
+    WaitForSingleObject(worker->thread, INFINITE);
+    CloseHandle(worker->thread);
+#else
+    pthread_join(worker->thread, NULL);
+#endif
+}
+
+
+static Worker *allocate_workers(const TaskFunction task, void *arguments, const size_t argument_size,
+                                const size_t count, const AtomicSize *gate) {
+    Worker *workers = calloc(count, sizeof(Worker));
+    if (!workers) {
+        perror("Failed to allocate workers");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        workers[i].task = task;
+        workers[i].argument = (char *)arguments + i * argument_size;
+        workers[i].gate = gate;
+    }
+    return workers;
+}
+
+
+// A task submitted to the pool by `run_in_parallel()`
+typedef struct {
+    TaskFunction task;
+    void *argument;
+    AtomicSize *remaining;  // the number of the unfinished tasks of the same call
+} PoolTask;
+
+// A Chase-Lev deque of tasks: its owner pushes and pops them at the bottom, while the
+// other threads steal them from the top, so the owner takes a lock-free path and
+// rarely contends with the thieves. The slots hold pointers to PoolTask.
+typedef struct {
+    AtomicSize top;
+    char padding[64];       // keeps the ends of the deque in different cache lines
+    AtomicSize bottom;
+    AtomicSize slots[DEQUE_CAPACITY];
+} WorkDeque;
+
+typedef struct {
+    WorkDeque *deques;      // one per thread, the first one belongs to the thread which started the pool
+    Worker *workers;        // the threads of the pool, the first one is the starting thread itself
+    size_t size;
+    AtomicSize stopping;
+    AtomicSize generation;  // changed whenever tasks are submitted, so the idle threads wake up
+    bool pinned;
+} ThreadPool;
+
+static ThreadPool pool = {NULL, NULL, 0, 0, 0, false};
+
+// the idle threads of the pool sleep here till `generation` changes
+#ifdef _WIN32
+static SRWLOCK idle_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE idle_condition = CONDITION_VARIABLE_INIT;
+#else
+static pthread_mutex_t idle_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idle_condition = PTHREAD_COND_INITIALIZER;
+#endif
+// the deque of the current thread or SIZE_MAX if the thread doesn't belong to the pool
+static THREAD_LOCAL size_t current_deque = SIZE_MAX;
+
+
+static bool push_task(WorkDeque *deque, PoolTask *task) {
+    const size_t bottom = load_relaxed(&deque->bottom);
+    if (bottom - load_acquire(&deque->top) >= DEQUE_CAPACITY) {
+        return false;
+    }
+
+    store_relaxed(&deque->slots[bottom % DEQUE_CAPACITY], (size_t)(uintptr_t)task);
+    store_release(&deque->bottom, bottom + 1);
+    return true;
+}
+
+
+static PoolTask *pop_task(WorkDeque *deque) {
+    const size_t bottom = load_relaxed(&deque->bottom) - 1;
+    store_relaxed(&deque->bottom, bottom);
+    full_fence();
+    const size_t top = load_relaxed(&deque->top);
+
+    if ((ptrdiff_t)(bottom - top) < 0) {
+        store_relaxed(&deque->bottom, bottom + 1);
+        return NULL;
+    }
+
+    PoolTask *task = (PoolTask *)(uintptr_t)load_relaxed(&deque->slots[bottom % DEQUE_CAPACITY]);
+    if (bottom == top) {
+        // the last task may be being stolen right now, so the owner has to win it as the thieves do
+        if (!compare_exchange(&deque->top, top, top + 1)) {
+            task = NULL;
+        }
+        store_relaxed(&deque->bottom, bottom + 1);
+    }
+    return task;
+}
+
+
+static PoolTask *steal_task(WorkDeque *deque) {
+    const size_t top = load_acquire(&deque->top);
+    full_fence();
+    const size_t bottom = load_acquire(&deque->bottom);
+    if ((ptrdiff_t)(bottom - top) <= 0) {
+        return NULL;
+    }
+
+    PoolTask *task = (PoolTask *)(uintptr_t)load_relaxed(&deque->slots[top % DEQUE_CAPACITY]);
+    return compare_exchange(&deque->top, top, top + 1) ? task : NULL;
+}
+
+
+// takes a task of the thread's own deque or steals one from the others
+static PoolTask *find_task(const size_t self) {
+    PoolTask *task = pop_task(&pool.deques[self]);
+    for (size_t i = 1; !task && i < pool.size; i++) {
+        task = steal_task(&pool.deques[(self + i) % pool.size]);
+    }
+    return task;
+}
+
+
+static void execute_task(const PoolTask *task) {
+    task->task(task->argument);
+    add_and_fetch(task->remaining, SIZE_MAX);
+}
+
+
+// blocks the idle thread till the tasks are submitted or the pool is stopped, unless it
+// happened already after the thread had seen the `generation`
+static void park_pool_thread(const size_t generation) {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&idle_lock);
+    while (load_acquire(&pool.generation) == generation && !load_acquire(&pool.stopping)) {
+        SleepConditionVariableSRW(&idle_condition, &idle_lock, INFINITE, 0);
+    }
+    ReleaseSRWLockExclusive(&idle_lock);
+#else
+    pthread_mutex_lock(&idle_lock);
+    while (load_acquire(&pool.generation) == generation && !load_acquire(&pool.stopping)) {
+        pthread_cond_wait(&idle_condition, &idle_lock);
+    }
+    pthread_mutex_unlock(&idle_lock);
+#endif
+}
+
+
+// wakes up all the idle threads of the pool
+static void wake_pool_threads(void) {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&idle_lock);
+    add_and_fetch(&pool.generation, 1);
+    WakeAllConditionVariable(&idle_condition);
+    ReleaseSRWLockExclusive(&idle_lock);
+#else
+    pthread_mutex_lock(&idle_lock);
+    add_and_fetch(&pool.generation, 1);
+    pthread_cond_broadcast(&idle_condition);
+    pthread_mutex_unlock(&idle_lock);
+#endif
+}
+
+
+/**
+ * @brief Pins the thread to the n-th CPU the process may run on.
+ *
+ * It's a hint, so the errors are ignored, and it does nothing but on Linux.
+ *
+ * @param index The index of the thread in the pool.
+ */
+static void pin_current_thread(const size_t index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+        return;
+    }
+
+    size_t target = index % (size_t)CPU_COUNT(&allowed);
+    for (size_t cpu = 0; cpu < (size_t)CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed) && target-- == 0) {
+            cpu_set_t selected;
+            CPU_ZERO(&selected);
+            CPU_SET(cpu, &selected);
+            pthread_setaffinity_np(pthread_self(), sizeof(selected), &selected);
+            return;
+        }
+    }
+#else
+    (void)index;
+#endif
+}
+
+
+static void run_pool_thread(void *argument) {
+    current_deque = (size_t)((WorkDeque *)argument - pool.deques);
+    if (pool.pinned) {
+        pin_current_thread(current_deque);
+    }
+
+    unsigned attempt = 0;
+    while (!load_acquire(&pool.stopping)) {
+        // the tasks submitted after this point change the generation, so they aren't missed
+        const size_t generation = load_acquire(&pool.generation);
+        const PoolTask *task = find_task(current_deque);
+        if (task) {
+            execute_task(task);
+            attempt = 0;
+        } else if (attempt < YIELD_ATTEMPTS) {
+            wait_for_progress(attempt++);
+        } else {
+            park_pool_thread(generation);
+            attempt = 0;
+        }
+    }
+}
+
+
+/**
+ * @brief Runs the tasks by the pool, helping it until all of them are complete.
+ *
+ * The tasks go to the deque of the calling thread, so the idle threads of the pool
+ * steal them, while the calling thread executes the first task and then the tasks
+ * nobody has taken yet (or the tasks of the others, if its own deque is empty).
+ *
+ * @param task The function to execute.
+ * @param arguments The array of `count` arguments.
+ * @param argument_size The size of one element of the `arguments` array.
+ * @param count The number of tasks (at least 1).
+ */
+static void run_in_pool(const TaskFunction task, void *arguments, const size_t argument_size, const size_t count) {
+    PoolTask *tasks = malloc(count * sizeof(PoolTask));
+    if (!tasks) {
+        perror("Failed to allocate tasks");
+        exit(EXIT_FAILURE);
+    }
+
+    AtomicSize remaining = count - 1;
+    WorkDeque *deque = &pool.deques[current_deque];
+    // the owner pops the last task first, so the thieves take them in order
+    for (size_t i = count; i-- > 1;) {
+        tasks[i] = (PoolTask){.task = task, .argument = (char *)arguments + i * argument_size, .remaining = &remaining};
+        if (!push_task(deque, &tasks[i])) {
+            execute_task(&tasks[i]);
+        }
+    }
+
+    if (count > 1) {
+        wake_pool_threads();
+    }
+    task(arguments);
+
+    unsigned attempt = 0;
+    while (load_acquire(&remaining)) {
+        const PoolTask *other = find_task(current_deque);
+        if (other) {
+            execute_task(other);
+            attempt = 0;
+        } else {
+            wait_for_progress(attempt);
+            attempt += attempt < YIELD_ATTEMPTS;
+        }
+    }
+
+    free(tasks);
+}
+
+
+#ifdef __linux__
+/**
+ * @brief Reads the CPU quota of the cgroup of the process (e.g. of a container).
+ *
+ * @return The number of CPUs the quota corresponds to (rounded up) or 0 if there's no quota.
+ */
+static unsigned get_cpu_quota(void) {
+    unsigned long long quota = 0;
+    unsigned long long period = 0;
+
+    FILE *file = fopen(CGROUP_CPU_MAX, "r");
+    if (file) {
+        // "max 100000" means "no limit"
+        char value[32];
+        if (fscanf(file, "%31s %llu", value, &period) != 2 || strcmp(value, "max") == 0) {
+            period = 0;
+        } else {
+            quota = strtoull(value, NULL, 10);
+        }
+        fclose(file);
+    } else if ( (file = fopen(CGROUP_CPU_QUOTA, "r")) ) {
+        // -1 means "no limit"
+        long long value = -1;
+        if (fscanf(file, "%lld", &value) == 1 && value > 0) {
+            quota = (unsigned long long)value;
+        }
+        fclose(file);
+
+        if (quota && (file = fopen(CGROUP_CPU_PERIOD, "r"))) {
+            if (fscanf(file, "%llu", &period) != 1) {
+                period = 0;
+            }
+            fclose(file);
+        }
+    }
+
+    if (!quota || !period) {
+        return 0;
+    }
+    const unsigned long long count = (quota + period - 1) / period;
+    return count < UINT32_MAX ? (unsigned)count : UINT32_MAX;
+}
+#endif
+
+
+/**
+ * @brief Returns the number of CPUs available to the process.
+ *
+ * On Linux, that's the number of CPUs the process may run on (see `taskset`)
+ * limited by the CPU quota of its cgroup (e.g. `docker run --cpus`), so the
+ * threads don't oversubscribe a container.
+ *
+ * @return The number of CPUs available to the process (at least 1).
+ */
+unsigned get_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (unsigned)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    #ifdef __linux__
+        cpu_set_t allowed;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0 && CPU_COUNT(&allowed) > 0) {
+            count = CPU_COUNT(&allowed);
+        }
+
+        const unsigned quota = get_cpu_quota();
+        if (quota && quota < count) {
+            count = quota;
+        }
+    #endif
+    return count > 0 ? (unsigned)count : 1;
+#endif
+}
+
+
+/**
+ * @brief Starts the pool of threads which executes the tasks of `run_in_parallel()`.
+ *
+ * The calling thread becomes the first thread of the pool, so `threads - 1` new
+ * threads are started. Every thread has its own deque of tasks, and the idle
+ * threads steal the tasks of the others, so all the parallel phases share the
+ * same threads, and no thread is started per phase.
+ *
+ * The idle threads sleep on a condition variable till the tasks are submitted, so
+ * the pool takes no CPU time between the parallel phases.
+ *
+ * @param threads The number of the threads, including the calling one.
+ * @param pinned Pin every thread to its own CPU (Linux only).
+ * @return The number of the threads in the pool (1 if no thread could be started).
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+unsigned start_thread_pool(const unsigned threads, const bool pinned) {
+    if (pool.size || threads <= 1) {
+        return pool.size ? (unsigned)pool.size : 1;
+    }
+
+    pool.deques = calloc(threads, sizeof(WorkDeque));
+    pool.workers = calloc(threads, sizeof(Worker));
+    if (!pool.deques || !pool.workers) {
+        perror("Failed to allocate thread pool");
+        exit(EXIT_FAILURE);
+    }
+    pool.size = threads;
+    pool.stopping = 0;
+    pool.generation = 0;
+    pool.pinned = pinned;
+
+    current_deque = 0;
+    if (pinned) {
+        pin_current_thread(0);
+    }
+
+    unsigned started = 1;
+    for (size_t i = 1; i < threads; i++) {
+        pool.workers[i] = (Worker){.task = run_pool_thread, .argument = &pool.deques[i], .gate = NULL};
+        // the deque of a thread which isn't started stays empty, so it doesn't matter
+        started += start_worker(&pool.workers[i]);
+    }
+    return started;
+}
+
+
+/**
+ * @brief Stops the threads of the pool and releases it.
+ *
+ * Must be called by the thread which started the pool, when no task is running.
+ */
+void stop_thread_pool(void) {
+    if (!pool.size) {
+        return;
+    }
+
+    store_release(&pool.stopping, 1);
+    wake_pool_threads();
+    for (size_t i = 1; i < pool.size; i++) {
+        if (pool.workers[i].started) {
+            join_worker(&pool.workers[i]);
+        }
+    }
+
+    free(pool.workers);
+    free(pool.deques);
+    pool = (ThreadPool){NULL, NULL, 0, 0, 0, false};
+    current_deque = SIZE_MAX;
+}
+
+
+/**
+ * @brief Runs the same task over several arguments in parallel and waits for all of them.
+ *
+ * The first task is executed by the calling thread. If the thread belongs to the
+ * pool (see `start_thread_pool()`), the others are executed by the pool, otherwise
+ * each of them gets its own thread. If a thread cannot be started, its task is
+ * executed by the calling thread.
+ *
+ * @param task The function to execute.
+ * @param arguments The array of `count` arguments, each of them `argument_size` bytes long.
+ *                  The task receives a pointer to its own element of the array.
+ * @param argument_size The size of one element of the `arguments` array.
+ * @param count The number of tasks.
+ */
+void run_in_parallel(const TaskFunction task, void *arguments, const size_t argument_size, const size_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (current_deque != SIZE_MAX) {
+        run_in_pool(task, arguments, argument_size, count);
+        return;
+    }
+
+    Worker *workers = allocate_workers(task, arguments, argument_size, count, NULL);
+    for (size_t i = 1; i < count; i++) {
+        start_worker(&workers[i]);
+    }
+
+    task(arguments);
+
+    for (size_t i = 1; i < count; i++) {
+        if (workers[i].started) {
+            join_worker(&workers[i]);
+        } else {
+            task(workers[i].argument);
+        }
+    }
+
+    free(workers);
+}
+
+
+/**
+ * @brief Runs the same task over several arguments at the same time and waits for all of them.
+ *
+ * Unlike `run_in_parallel()`, the tasks may wait for each other (e.g. the stages of
+ * a pipeline), so every task must get its own thread: the first one is executed by
+ * the calling thread, and the others don't start until all the threads are started.
+ * If a thread cannot be started, none of the tasks is executed.
+ *
+ * @param task The function to execute.
+ * @param arguments The array of `count` arguments, each of them `argument_size` bytes long.
+ *                  The task receives a pointer to its own element of the array.
+ * @param argument_size The size of one element of the `arguments` array.
+ * @param count The number of tasks.
+ * @return true if the tasks are executed; false if the threads cannot be started.
+ */
+bool run_concurrently(const TaskFunction task, void *arguments, const size_t argument_size, const size_t count) {
+    if (count == 0) {
+        return true;
+    }
+
+    AtomicSize gate = GATE_CLOSED;
+    Worker *workers = allocate_workers(task, arguments, argument_size, count, &gate);
+    bool started = true;
+    for (size_t i = 1; i < count && started; i++) {
+        started = start_worker(&workers[i]);
+    }
+
+    store_release(&gate, started ? GATE_OPEN : GATE_CANCELLED);
+    if (started) {
+        task(arguments);
+    }
+
+    for (size_t i = 1; i < count; i++) {
+        if (workers[i].started) {
+            join_worker(&workers[i]);
+        }
+    }
+
+    free(workers);
+    return started;
+}
+
+
+/**
+ * @brief Lets other threads run while the calling one waits for them.
+ *
+ * The first attempts just spin, as the progress is usually a moment away, then the
+ * thread yields the CPU, and then it sleeps for longer and longer (up to 10 ms), so
+ * a thread waiting for a slow producer doesn't burn the CPU.
+ *
+ * @param attempt The number of the attempts made so far.
+ */
+void wait_for_progress(const unsigned attempt) {
+    if (attempt < SPIN_ATTEMPTS) {
+        return;
+    }
+
+    const unsigned doublings = attempt < YIELD_ATTEMPTS ? 0 : (attempt - YIELD_ATTEMPTS) / SLEEPS_PER_DOUBLING;
+    long nanoseconds = MAX_IDLE_SLEEP_NANOSECONDS;
+    if (doublings < 8 && (IDLE_SLEEP_NANOSECONDS << doublings) < MAX_IDLE_SLEEP_NANOSECONDS) {
+        nanoseconds = IDLE_SLEEP_NANOSECONDS << doublings;
+    }
+
+#ifdef _WIN32
+    if (attempt < YIELD_ATTEMPTS) {
+        SwitchToThread();
+    } else {
+        // the shortest sleep is a millisecond there
+        Sleep(nanoseconds < 1000000 ? 1 : (DWORD)(nanoseconds / 1000000));
+    }
+#else
+    if (attempt < YIELD_ATTEMPTS) {
+        sched_yield();
+    } else {
+        const struct timespec pause = {.tv_sec = 0, .tv_nsec = nanoseconds};
+        nanosleep(&pause, NULL);
+    }
+#endif
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_PARALLEL_H
+#define MERGE_IP_PARALLEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+typedef void (*TaskFunction)(void *argument);
+
+
+/**
+ * @brief Returns the number of CPUs available to the process.
+ *
+ * On Linux, that's the number of CPUs the process may run on (see `taskset`)
+ * limited by the CPU quota of its cgroup (e.g. `docker run --cpus`), so the
+ * threads don't oversubscribe a container.
+ *
+ * @return The number of CPUs available to the process (at least 1).
+ */
+unsigned get_cpu_count(void);
+
+
+/**
+ * @brief Starts the pool of threads which executes the tasks of `run_in_parallel()`.
+ *
+ * The calling thread becomes the first thread of the pool, so `threads - 1` new
+ * threads are started. Every thread has its own deque of tasks, and the idle
+ * threads steal the tasks of the others, so all the parallel phases share the
+ * same threads, and no thread is started per phase.
+ *
+ * The idle threads sleep on a condition variable till the tasks are submitted, so
+ * the pool takes no CPU time between the parallel phases.
+ *
+ * @param threads The number of the threads, including the calling one.
+ * @param pinned Pin every thread to its own CPU (Linux only).
+ * @return The number of the threads in the pool (1 if no thread could be started).
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+unsigned start_thread_pool(unsigned threads, bool pinned);
+
+
+/**
+ * @brief Stops the threads of the pool and releases it.
+ *
+ * Must be called by the thread which started the pool, when no task is running.
+ */
+void stop_thread_pool(void);
+
+
+/**
+ * @brief Runs the same task over several arguments in parallel and waits for all of them.
+ *
+ * The first task is executed by the calling thread. If the thread belongs to the
+ * pool (see `start_thread_pool()`), the others are executed by the pool, otherwise
+ * each of them gets its own thread. If a thread cannot be started, its task is
+ * executed by the calling thread.
+ *
+ * @param task The function to execute.
+ * @param arguments The array of `count` arguments, each of them `argument_size` bytes long.
+ *                  The task receives a pointer to its own element of the array.
+ * @param argument_size The size of one element of the `arguments` array.
+ * @param count The number of tasks.
+ */
+void run_in_parallel(TaskFunction task, void *arguments, size_t argument_size, size_t count);
+
+
+
+/**
+ * @brief Runs the same task over several arguments at the same time and waits for all of them.
+ *
+ * Unlike `run_in_parallel()`, the tasks may wait for each other (e.g. the stages of
+ * a pipeline), so every task must get its own thread: the first one is executed by
+ * the calling thread, and the others don't start until all the threads are started.
+ * If a thread cannot be started, none of the tasks is executed.
+ *
+ * @param task The function to execute.
+ * @param arguments The array of `count` arguments, each of them `argument_size` bytes long.
+ *                  The task receives a pointer to its own element of the array.
+ * @param argument_size The size of one element of the `arguments` array.
+ * @param count The number of tasks.
+ * @return true if the tasks are executed; false if the threads cannot be started.
+ */
+bool run_concurrently(TaskFunction task, void *arguments, size_t argument_size, size_t count);
+
+
+/**
+ * @brief Lets other threads run while the calling one waits for them.
+ *
+ * The first attempts just spin, as the progress is usually a moment away, then the
+ * thread yields the CPU, and then it sleeps for longer and longer (up to 10 ms), so
+ * a thread waiting for a slow producer doesn't burn the CPU.
+ *
+ * @param attempt The number of the attempts made so far.
+ */
+void wait_for_progress(unsigned attempt);
+
+#endif //MERGE_IP_PARALLEL_H
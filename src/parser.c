@@ -14,250 +14,514 @@
  * limitations under the License.
  */
 
-#include <errno.h>
-#include <math.h>
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
 
 #include "parser.h"
+#include "bits.h"
+
+
+#define MAX_PREFIX_LENGTH 32
+#define MAX_OCTET_VALUE 255
+
+
+// Classes of input symbols
+enum {
+    C_DIGIT,
+    C_DOT,
+    C_SLASH,
+    C_SPACE,
+    C_OTHER,
+    CLASSES_COUNT
+};
+
+// States of the tokenizer.
+// `S_Ok_Dn` means "n-th digit of the k-th octet has been read",
+// `S_DOTk` means "k-th dot has been read, waiting for the first digit of the next octet",
+// `S_Pn` means "n-th digit of the prefix has been read".
+enum {
+    S_SPACE, // between tokens
+    S_JUNK,  // inside a token which can't be a CIDR, waiting for a whitespace
+    S_O0_D1, S_O0_D2, S_O0_D3,
+    S_O1_D1, S_O1_D2, S_O1_D3,
+    S_O2_D1, S_O2_D2, S_O2_D3,
+    S_O3_D1, S_O3_D2, S_O3_D3,
+    S_DOT1, S_DOT2, S_DOT3,
+    S_SLASH,
+    S_P1, S_P2,
+    STATES_COUNT
+};
+
+// Actions performed on a transition
+enum {
+    A_NONE,
+    A_START,        // the first digit of a token
+    A_FIRST_DIGIT,  // the first digit of an octet (except the very first one) or of the prefix
+    A_DIGIT,        // one more digit of an octet
+    A_PREFIX_DIGIT, // one more digit of the prefix
+    A_OCTET,        // an octet is complete
+    A_EMIT_HOST,    // the token is complete and it's an IP address
+    A_EMIT_CIDR,    // the token is complete and it's a CIDR block
+};
+
+#define ACTION_SHIFT 5
+#define STATE_MASK ((1 << ACTION_SHIFT) - 1)
+// a transition is packed into a single byte: 3 high bits for the action and 5 low bits for the next state
+#define T(state, action) ((uint8_t)((action) << ACTION_SHIFT | (state)))
+#define JUNK T(S_JUNK, A_NONE)
+#define SPACE T(S_SPACE, A_NONE)
+
+// the whitespace set is the same as `[ \t\n\r\v\f]`
+static const uint8_t CHAR_CLASSES[256] = {
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x00
+    C_OTHER, C_SPACE, C_SPACE, C_SPACE, C_SPACE, C_SPACE, C_OTHER, C_OTHER,   // 0x08: \t \n \v \f \r
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x10
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x18
+    C_SPACE, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x20: ' '
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_DOT,   C_SLASH,   // 0x28: '.' '/'
+    C_DIGIT, C_DIGIT, C_DIGIT, C_DIGIT, C_DIGIT, C_DIGIT, C_DIGIT, C_DIGIT,   // 0x30: '0'-'7'
+    C_DIGIT, C_DIGIT, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x38: '8' '9'
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x40
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x48
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x50
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x58
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x60
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x68
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x70
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x78
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,   // 0x80
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+    C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER, C_OTHER,
+};
+
+static const uint8_t TRANSITIONS[STATES_COUNT][CLASSES_COUNT] = {
+    //            C_DIGIT                        C_DOT                   C_SLASH                  C_SPACE                       C_OTHER
+    [S_SPACE] = { T(S_O0_D1, A_START),           JUNK,                   JUNK,                    SPACE,                        JUNK },
+    [S_JUNK]  = { JUNK,                          JUNK,                   JUNK,                    SPACE,                        JUNK },
+    [S_O0_D1] = { T(S_O0_D2, A_DIGIT),           T(S_DOT1, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O0_D2] = { T(S_O0_D3, A_DIGIT),           T(S_DOT1, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O0_D3] = { JUNK,                          T(S_DOT1, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O1_D1] = { T(S_O1_D2, A_DIGIT),           T(S_DOT2, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O1_D2] = { T(S_O1_D3, A_DIGIT),           T(S_DOT2, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O1_D3] = { JUNK,                          T(S_DOT2, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O2_D1] = { T(S_O2_D2, A_DIGIT),           T(S_DOT3, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O2_D2] = { T(S_O2_D3, A_DIGIT),           T(S_DOT3, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O2_D3] = { JUNK,                          T(S_DOT3, A_OCTET),     JUNK,                    SPACE,                        JUNK },
+    [S_O3_D1] = { T(S_O3_D2, A_DIGIT),           JUNK,                   T(S_SLASH, A_OCTET),     T(S_SPACE, A_EMIT_HOST),      JUNK },
+    [S_O3_D2] = { T(S_O3_D3, A_DIGIT),           JUNK,                   T(S_SLASH, A_OCTET),     T(S_SPACE, A_EMIT_HOST),      JUNK },
+    [S_O3_D3] = { JUNK,                          JUNK,                   T(S_SLASH, A_OCTET),     T(S_SPACE, A_EMIT_HOST),      JUNK },
+    [S_DOT1]  = { T(S_O1_D1, A_FIRST_DIGIT),     JUNK,                   JUNK,                    SPACE,                        JUNK },
+    [S_DOT2]  = { T(S_O2_D1, A_FIRST_DIGIT),     JUNK,                   JUNK,                    SPACE,                        JUNK },
+    [S_DOT3]  = { T(S_O3_D1, A_FIRST_DIGIT),     JUNK,                   JUNK,                    SPACE,                        JUNK },
+    [S_SLASH] = { T(S_P1, A_FIRST_DIGIT),        JUNK,                   JUNK,                    SPACE,                        JUNK },
+    [S_P1]    = { T(S_P2, A_PREFIX_DIGIT),       JUNK,                   JUNK,                    T(S_SPACE, A_EMIT_CIDR),      JUNK },
+    [S_P2]    = { JUNK,                          JUNK,                   JUNK,                    T(S_SPACE, A_EMIT_CIDR),      JUNK },
+};
 
 
 /**
- * @brief Returns a precompiled regex_t object for matching CIDR blocks.
+ * @brief Initializes the CIDR tokenizer.
  *
- * This function compiles a regular expression that matches CIDR blocks in the format
- * "address/prefix_length". The regex is compiled with extended syntax and newline support.
+ * This function resets the tokenizer into its initial state, i.e. as if it
+ * was at the beginning of the input. The duplicates are kept until `dedup`
+ * is set, and the order of the tokens isn't checked until `check_order` is.
  *
- * The caller is responsible for freeing the regex_t object using `regfree()` after use.
+ * @param parser A pointer to the CidrParser structure to initialize.
+ */
+void init_parser(CidrParser *parser) {
+    parser->scanner = get_scanner();
+    parser->state = S_SPACE;
+    parser->address = 0;
+    parser->value = 0;
+    parser->bad_octet = 0;
+    parser->bad_octet_position = 0;
+    parser->bad_octet_length = 0;
+    parser->leading_zero = false;
+    parser->dedup = NULL;
+    parser->check_order = false;
+    parser->out_of_order = false;
+    parser->previous = 0;
+}
+
+
+/**
+ * @brief Remembers the octet if it's the first invalid one of the token.
  *
- * @return A regex_t object representing the compiled regular expression.
+ * An octet is invalid if it's out of range or has a leading zero: like `inet_pton()`,
+ * the parser rejects "01" & co. since some tools treat them as octal numbers.
+ *
+ * @param parser A pointer to the tokenizer state.
+ * @param value The value of the octet.
+ * @param state The state in which the last digit of the octet has been read.
  */
-regex_t get_regex() {
-    // surprisingly, the `regex_t` doesn't capture space symbols by the `\s`,
-    // so I have to explicitly list them in the pattern
-    const char *CIDR_PATTERN = "(([0-9]{1,3}\\.){3}[0-9]{1,3}(/([0-9]{1,2}))?)([ \t\n\r\v\f]*)";
-
-    regex_t regex;
-    if (regcomp(&regex, CIDR_PATTERN, REG_EXTENDED | REG_NEWLINE)) {
-        fprintf(stderr, "Failed to compile regex.\n");
-        exit(EXIT_FAILURE);
+static inline void check_octet(CidrParser *parser, const uint32_t value, const uint8_t state) {
+    const unsigned digits = (unsigned)(state - S_O0_D1) % 3 + 1;
+    const bool leading_zero = (digits == 2 && value < 10) || (digits == 3 && value < 100);
+    if ((value > MAX_OCTET_VALUE || leading_zero) && !parser->bad_octet_position) {
+        parser->bad_octet = value;
+        parser->bad_octet_position = (uint8_t)((state - S_O0_D1) / 3 + 1);
+        parser->bad_octet_length = (uint8_t)digits;
+        parser->leading_zero = leading_zero;
     }
-
-    return regex;
 }
 
 
 /**
- * Parses a CIDR block and calculates the minimum and maximum IP addresses within the range.
+ * @brief Converts a complete token into an IP range and stores it.
  *
- * This function takes a CIDR block in the form "address/prefix_length", parses it, and computes
- * the range of IP addresses that fall within that CIDR block.
+ * This function validates the collected address and prefix length, computes
+ * the minimal and maximal IP addresses of the block and appends the range to the list,
+ * unless the same range has been seen already by the parser's deduplication set.
+ * The hosts are stored apart from the ranges, so the order of the tokens is
+ * checked here, if it's requested.
  *
- * @param cidr A C-string containing the CIDR notation (e.g., "192.168.1.0/24").
- * @param range A pointer to an ipRange struct where the computed min and max IP addresses will be stored.
- * @return Integer status code:
- *         - 0 on success
- *         - 2 if the IP address is invalid
- *         - 3 if the subnet mask is invalid
+ * @param parser A pointer to the tokenizer state holding the collected address.
+ * @param prefix_len The length of the network prefix.
+ * @param range_list A pointer to the ipRangeList structure to store the range.
+ *
+ * @return 1 if the range has been stored; 0 if the token is invalid or a duplicate
  */
-int parse_cidr(const char *cidr, ipRange *range) {
-    // split CIDR to IP & mask
-    char *slash = strchr(cidr, '/');
-    if (slash == NULL) {
-        perror("CIDR without prefix! It should've never happened! I'm going to die now!");
-        exit(EXIT_FAILURE);
+static size_t emit_range(CidrParser *parser, const uint32_t prefix_len, ipRangeList *range_list) {
+    const uint32_t ip = parser->address;
+
+    if (parser->bad_octet_position) {
+        fprintf(stderr, parser->leading_zero
+                    ? "ERROR: invalid IP address: octet %u (%0*u) has a leading zero\n"
+                    : "ERROR: invalid IP address: octet %u (%0*u) is out of range\n",
+                parser->bad_octet_position, (int)parser->bad_octet_length, parser->bad_octet);
+        return 0;
     }
-    *slash = '\0';
 
-    // convert IP address to binary format
-    struct in_addr ip;
-    if (inet_pton(AF_INET, cidr, &ip) != 1) {
-        fprintf(stderr, "ERROR: invalid IP address: %s\n", cidr);
-        return 2; // Error code
+    if (prefix_len > MAX_PREFIX_LENGTH) {
+        fprintf(stderr, "ERROR: invalid network mask: %u\n", prefix_len);
+        return 0;
     }
 
-    // compute mask
-    char *end = NULL;
-    const long prefix_len = strtol(slash + 1, &end, 10);
-    if (errno == ERANGE || prefix_len < 0 || prefix_len > CIDR_MAX_LENGTH) {
-        fprintf(stderr, "ERROR: invalid network mask: %s\n", slash + 1);
-        return 3; // Error code
+    // compute minimal & maximal IP-address (`<< 32` is undefined, so /0 is a special case)
+    const uint32_t mask = prefix_len == 0 ? 0 : UINT32_MAX << (MAX_PREFIX_LENGTH - prefix_len);
+    const ipRange range = {.min_ip = {ip & mask}, .max_ip = {ip | ~mask}};
+
+    if (parser->dedup && !insert_dedup_key(parser->dedup, get_dedup_key(range.min_ip.s_addr, range.max_ip.s_addr))) {
+        return 0;
     }
 
-    // compute minimal & maximal IP-address
-    const uint32_t mask = (uint32_t)htonl(~((1 << (CIDR_MAX_LENGTH - prefix_len)) - 1));
-    range->min_ip.s_addr = ntohl(ip.s_addr & mask);
-    range->max_ip.s_addr = ntohl(ip.s_addr | ~mask);
+    if (parser->check_order) {
+        parser->out_of_order |= range.min_ip.s_addr < parser->previous;
+        parser->previous = range.min_ip.s_addr;
+    }
 
-    return 0; // success
-}
+    // the hosts take half of the memory when they are stored as bare addresses
+    if (prefix_len == MAX_PREFIX_LENGTH) {
+        appendIpHost(range_list, ip);
+        return 1;
+    }
 
+    appendIpRange(range_list, &range);
 
-/**
- * @brief Checks if the given CIDR block is a pure IP, without prefix
- *
- * This function checks if the provided CIDR block string contains a prefix
- * (e.g., "/24"). If the CIDR block does not contain a prefix, it returns true.
- *
- * @param cidr The CIDR block string to check.
- *
- * @return true if the CIDR block does not have a prefix; false otherwise.
- */
-bool is_host(const char* cidr) {
-    return strchr(cidr, '/') == NULL;
+    return 1;
 }
 
 
 /**
- * @brief Checks if the CIDR block is potentially broken.
+ * @brief Runs the table-driven state machine over a part of the content.
  *
- * This function checks if the CIDR block is potentially broken by looking
- * for a two-digit prefix at the end of the CIDR block. If the CIDR block
- * is broken, it returns true; otherwise, it returns false.
- *
- * @param content The content string to check.
- * @param cidr_end The end position of the CIDR block in the content string.
+ * @param parser A pointer to the tokenizer state.
+ * @param content The chunk of the input.
+ * @param position The offset to start from.
+ * @param length The offset to stop at.
+ * @param range_list A pointer to the ipRangeList structure to store the extracted CIDR blocks.
  *
- * @return true if the CIDR block is potentially broken; false otherwise.
+ * @return The number of IP ranges extracted
  */
-bool maybe_broken_cidr(const char* content, const size_t cidr_end) {
-    if (isspace(content[cidr_end])) {
-        return false; // the regex has caught the whole CIDR block
+static size_t run_state_machine(CidrParser *parser, const char *content, const size_t position, const size_t length,
+                                ipRangeList *range_list) {
+    size_t parsed_ranges = 0;
+    const ScanFunction scan = parser->scanner->scan;
+    uint8_t state = parser->state;
+    uint32_t value = parser->value;
+
+    for (size_t i = position; i < length; ++i) {
+        // whitespaces between tokens and junk tokens are skipped in bulk by the (vectorized) scanner
+        if (state == S_SPACE && CHAR_CLASSES[(uint8_t)content[i]] == C_SPACE) {
+            i = scan(content, i, length, FIND_NON_SPACE);
+        } else if (state == S_JUNK && CHAR_CLASSES[(uint8_t)content[i]] != C_SPACE) {
+            i = scan(content, i, length, FIND_SPACE);
+        }
+        if (i == length) {
+            break;
+        }
+
+        const uint8_t symbol = (uint8_t)content[i];
+        const uint8_t previous = state;
+        const uint8_t transition = TRANSITIONS[state][CHAR_CLASSES[symbol]];
+        state = transition & STATE_MASK;
+
+        switch (transition >> ACTION_SHIFT) {
+            case A_NONE:
+                break;
+            case A_START:
+                parser->address = 0;
+                parser->bad_octet_position = 0;
+                value = (uint32_t)(symbol - '0');
+                break;
+            case A_FIRST_DIGIT:
+                value = (uint32_t)(symbol - '0');
+                break;
+            case A_DIGIT:
+                value = value * 10 + (uint32_t)(symbol - '0');
+                break;
+            case A_PREFIX_DIGIT:
+                value = value * 10 + (uint32_t)(symbol - '0');
+                break;
+            case A_OCTET:
+                check_octet(parser, value, previous);
+                parser->address = parser->address << 8 | value;
+                break;
+            case A_EMIT_HOST:
+                check_octet(parser, value, previous);
+                parser->address = parser->address << 8 | value;
+                parsed_ranges += emit_range(parser, MAX_PREFIX_LENGTH, range_list);
+                break;
+            case A_EMIT_CIDR:
+                parsed_ranges += emit_range(parser, value, range_list);
+                break;
+            default:
+                break;
+        }
     }
 
-    // There's no 2-digit prefix in the captured CIDR.
-    // Theoretically, it might be in the next text not
-    // read yet into the buffer, so the CIDR potentially MAY be broken
-    return !(
-        content[cidr_end - 3] == '/'
-        && isdigit(content[cidr_end - 2])
-        && isdigit(content[cidr_end - 1])
-    );
+    parser->state = state;
+    parser->value = value;
+
+    return parsed_ranges;
 }
 
 
 /**
- * @brief Adds the "/32" prefix to the given CIDR block string, assuming it is a host.
- *
- * This function appends "/32" to the provided CIDR block string assuming it does not
- * already contain a prefix. The function modifies the original string in place.
- *
- * @param cidr The CIDR block string to which the prefix will be added.
+ * @brief Converts a run of 1 to `max_digits` decimal digits into a number.
  *
+ * @param digits The first digit.
+ * @param count The number of the digits.
+ * @param max_digits The maximal number of the digits.
+ * @param value A pointer to store the number.
+ * @return true if the number of the digits is valid; false otherwise.
  */
-void add_prefix(char* cidr) {
-    const unsigned char length = (unsigned char)strlen(cidr); // max CIDR length is 32, which is less than 255
+static inline bool parse_digits(const char *digits, const size_t count, const size_t max_digits, uint32_t *value) {
+    if (count == 0 || count > max_digits) {
+        return false;
+    }
 
-    cidr[length] = '/';
-    cidr[length + 1] = '3';
-    cidr[length + 2] = '2';
-    cidr[length + 3] = 0;
+    uint32_t number = 0;
+    for (size_t i = 0; i < count; i++) {
+        number = number * 10 + (uint32_t)(digits[i] - '0');
+    }
+    *value = number;
+    return true;
 }
 
 
 /**
- * @brief Ensures that the given CIDR block string has a prefix.
+ * @brief Parses a well-formed token by the masks of its dots and slashes.
  *
- * This function checks if the provided CIDR block string is a host (without a prefix).
- * If it is, it appends "/32" to the CIDR block string. The function modifies the original string in place.
+ * The token is known to consist of digits, dots and slashes only, so the dots
+ * and the slash are the octet boundaries. Only the tokens which the state machine
+ * would accept are parsed here: 4 octets of up to 3 digits without leading zeros
+ * and up to 255, optionally followed by a slash and a prefix of up to 2 digits
+ * and up to 32. The rest, including the errors to be reported, is left to the
+ * state machine.
  *
- * @param cidr The CIDR block string to check and potentially modify.
+ * @param token The first byte of the token.
+ * @param length The length of the token in bytes.
+ * @param dots The mask of the dots of the token, n-th bit stands for n-th byte.
+ * @param slashes The mask of the slashes of the token.
+ * @param address A pointer to store the address.
+ * @param prefix_len A pointer to store the length of the prefix (32 if there's none).
+ * @return true if the token is parsed; false if it's up to the state machine.
  */
-void ensure_prefix(char* cidr) {
-    if (is_host(cidr)) {
-        add_prefix(cidr);
+static inline bool parse_classified_token(const char *token, const size_t length, uint64_t dots, const uint64_t slashes,
+                                          uint32_t *address, uint32_t *prefix_len) {
+    // a single slash after the last dot
+    if (slashes & (slashes - 1)) {
+        return false;
     }
-}
+    const size_t address_length = slashes ? count_trailing_zeros64(slashes) : length;
+
+    uint32_t ip = 0;
+    size_t start = 0;
+    for (unsigned octet = 0; octet < 4; octet++) {
+        size_t end = address_length;
+        if (octet < 3) {
+            if (!dots) {
+                return false;
+            }
+            end = count_trailing_zeros64(dots);
+            dots &= dots - 1;
+        } else if (dots) {
+            return false;
+        }
 
+        uint32_t value;
+        if (end < start || !parse_digits(token + start, end - start, 3, &value)
+            || value > MAX_OCTET_VALUE || (end - start > 1 && token[start] == '0')) {
+            return false;
+        }
+        ip = ip << 8 | value;
+        start = end + 1;
+    }
 
-typedef struct {
-    bool maybe_broken;
-    size_t start;
-    size_t end;
-    char cidr[CIDR_MAX_LENGTH];
-} CIDRToken;
+    *prefix_len = MAX_PREFIX_LENGTH;
+    if (slashes && (!parse_digits(token + start, length - start, 2, prefix_len) || *prefix_len > MAX_PREFIX_LENGTH)) {
+        return false;
+    }
+    *address = ip;
+    return true;
+}
 
 
-/** @brief Extracts a CIDR block from the given content using the provided regex.
+/**
+ * @brief Parses the content block by block while the tokens fit in the blocks.
  *
- * This function uses a regular expression to find and extract a CIDR block from
- * the input content. It fills the provided CIDRToken structure with the extracted
- * information, including the start and end positions of the match.
+ * Every block of SCAN_BLOCK_SIZE bytes is classified by the (vectorized) scanner
+ * at once. The whitespace mask gives the spans of the tokens, and the tokens
+ * made of the CIDR symbols only are parsed by the masks of their dots and
+ * slashes, so the digits never go through the state machine. A token which
+ * isn't well-formed goes through the state machine, which reports it. A token
+ * crossing the end of the block starts the next block.
  *
- * @param content The input string to search for a CIDR block.
- * @param regex A precompiled regular expression to match CIDR blocks.
- * @param token A pointer to a CIDRToken structure to store the extracted information.
+ * @param parser A pointer to the tokenizer state, which is between tokens.
+ * @param content The chunk of the input.
+ * @param position The offset to start from.
+ * @param length The length of the chunk in bytes.
+ * @param range_list A pointer to the ipRangeList structure to store the extracted CIDR blocks.
+ * @param parsed_ranges A pointer to the number of the IP ranges extracted to add to.
  *
- * @return true if a CIDR block was found and extracted; false otherwise.
+ * @return The offset to continue from, less than SCAN_BLOCK_SIZE bytes before the end.
  */
-bool get_token(const char* content, const regex_t* regex, CIDRToken* token) {
-    regmatch_t matches[6];
-    memset(token->cidr, 0, CIDR_MAX_LENGTH);
+static size_t parse_classified_blocks(CidrParser *parser, const char *content, size_t position, const size_t length,
+                                      ipRangeList *range_list, size_t *parsed_ranges) {
+    const ClassifyFunction classify = parser->scanner->classify;
+
+    while (length - position >= SCAN_BLOCK_SIZE) {
+        ByteClasses classes;
+        classify(content + position, &classes);
+
+        size_t offset = SCAN_BLOCK_SIZE;
+        uint64_t tokens = ~classes.spaces;
+        while (tokens) {
+            const size_t start = count_trailing_zeros64(tokens);
+            const uint64_t spaces = classes.spaces >> start;
+            if (!spaces) {
+                // the token crosses the end of the block
+                offset = start;
+                break;
+            }
+
+            const size_t token_length = count_trailing_zeros64(spaces);
+            const uint64_t token_mask = ((uint64_t)1 << token_length) - 1;
+            const char *token = content + position + start;
+
+            uint32_t address;
+            uint32_t prefix_len;
+            if ((~classes.symbols >> start & token_mask) == 0
+                && parse_classified_token(token, token_length, classes.dots >> start & token_mask,
+                                          classes.slashes >> start & token_mask, &address, &prefix_len)) {
+                parser->address = address;
+                parser->bad_octet_position = 0;
+                *parsed_ranges += emit_range(parser, prefix_len, range_list);
+            } else {
+                // the token with the whitespace after it, so the state machine ends up between tokens again
+                *parsed_ranges += run_state_machine(parser, content, position + start,
+                                                    position + start + token_length + 1, range_list);
+            }
+
+            // the token is followed by a whitespace, so the shift is less than 64
+            tokens = ~classes.spaces & UINT64_MAX << (start + token_length);
+        }
 
-    if (regexec(regex, content, 6, matches, 0) != 0) {
-        return false;
+        if (offset == 0) {
+            // a token longer than the block can't be a CIDR, so it's skipped as junk
+            position = parser->scanner->scan(content, position, length, FIND_SPACE);
+            if (position == length) {
+                parser->state = S_JUNK;
+            }
+        } else {
+            position += offset;
+        }
     }
 
-    token->start = matches[1].rm_so;
-    const size_t cidr_end = matches[1].rm_eo;
-    token->end = matches[5].rm_eo; // position of the last matched token (CIDR + whitespaces)
-    token->maybe_broken = maybe_broken_cidr(content, cidr_end);
-
-    strncpy(token->cidr, content + token->start, cidr_end - token->start);
-    ensure_prefix(token->cidr);
-
-    return true;
+    return position;
 }
-
-
 /**
- * @brief Parses content for CIDR blocks defined by the given regular expression
- * and returns the parsed data.
+ * @brief Parses a chunk of the content for CIDR blocks and stores them as IP ranges.
+ *
+ * This function feeds the given chunk to the table-driven tokenizer. The input is
+ * a sequence of tokens separated by whitespace symbols. Every token that has the form
+ * `a.b.c.d` or `a.b.c.d/prefix` is converted into an IP range (IPv4 addresses without
+ * a prefix are treated as `/32`), all the other tokens are skipped.
  *
- * This function scans the input content for matches against the provided
- * regular expression to identify CIDR blocks. For IPv4 addresses without a
- * CIDR prefix, it appends `/32` by default. Each matched CIDR block is stored
- * in the ParsedData structure.
+ * If the scanner classifies whole blocks, the well-formed tokens are parsed by the
+ * masks of the blocks instead (see `parse_classified_blocks()`), and the state
+ * machine only finishes the token carried over from the previous chunk, takes the
+ * tokens which aren't well-formed, and parses the tail of the chunk.
  *
- * @param content The input string to be parsed for CIDR blocks.
- * @param regex A precompiled regular expression to identify CIDR blocks.
+ * The content doesn't have to be NUL-terminated, and a token may be split between
+ * this chunk and the next one: the tokenizer keeps its state in the `parser`.
+ *
+ * @param parser A pointer to the tokenizer state.
+ * @param content The chunk of the input to be parsed.
+ * @param length The length of the chunk in bytes.
  * @param range_list A pointer to the ipRangeList structure to store the extracted CIDR blocks.
- * @param require_full_cidr A boolean flag indicating whether to require a full CIDR block
  *
- * @return The number of characters parsed from the input string
+ * @return The number of IP ranges extracted from the chunk
  *
  * @note If memory allocation fails, the function prints an error message and
  *       exits the program.
  */
-size_t parse_content(const char *content, const regex_t *regex, ipRangeList *range_list, const bool require_full_cidr) {
-    ipRange *ip_range = malloc(sizeof(ipRange));
-    if (!ip_range) {
-        perror("Failed to allocate IP range");
-        exit(EXIT_FAILURE);
-    }
-
-    const size_t content_length = (size_t)strlen(content);
-    size_t parsed_length = 0;
-    CIDRToken token;
-    while ( get_token(content, regex, &token) ) {
-        parsed_length += token.end;
-
-        const bool is_last_token = parsed_length >= content_length - CIDR_MIN_LENGTH;
-        if ( require_full_cidr && is_last_token && token.maybe_broken ) {
-            parsed_length += token.start - token.end;
-            break;
+size_t parse_content(CidrParser *parser, const char *content, const size_t length, ipRangeList *range_list) {
+    size_t parsed_ranges = 0;
+    size_t position = 0;
+
+    if (parser->scanner->classify && length >= SCAN_BLOCK_SIZE) {
+        if (parser->state != S_SPACE) {
+            // the whitespace after the carried over token is fed as well to bring the state machine between tokens
+            const size_t end = parser->scanner->scan(content, 0, length, FIND_SPACE);
+            position = end < length ? end + 1 : length;
+            parsed_ranges += run_state_machine(parser, content, 0, position, range_list);
         }
+        position = parse_classified_blocks(parser, content, position, length, range_list, &parsed_ranges);
+    }
 
-        if (parse_cidr(token.cidr, ip_range) == 0) {
-            appendIpRange(range_list, ip_range);
-        }
+    return parsed_ranges + run_state_machine(parser, content, position, length, range_list);
+}
 
-        content += token.end;
-    }
 
-    free(ip_range);
+/**
+ * @brief Finalizes parsing at the end of the input.
+ *
+ * This function handles the last token of the input, which isn't followed by
+ * a whitespace symbol, and resets the tokenizer into its initial state.
+ *
+ * @param parser A pointer to the tokenizer state.
+ * @param range_list A pointer to the ipRangeList structure to store the extracted CIDR block.
+ *
+ * @return The number of IP ranges extracted (either 0 or 1)
+ */
+size_t finish_parser(CidrParser *parser, ipRangeList *range_list) {
+    // the end of the input terminates the last token just like a whitespace does
+    const size_t parsed_ranges = parse_content(parser, " ", 1, range_list);
+    parser->state = S_SPACE;
 
-    return parsed_length;
+    return parsed_ranges;
 }
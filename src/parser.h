@@ -18,63 +18,84 @@
 #define MERGE_IP_PARSE_H
 
 #include <stdbool.h>
-#include <stdio.h>
-
-#ifdef _WIN32
-    #include <stdint.h>
-    #include <pcre2posix.h>
-#else
-    #include <regex.h>
-#endif
+#include <stddef.h>
+#include <stdint.h>
 
+#include "dedup.h"
 #include "ipRange.h"
+#include "scanner.h"
 
 
-#define BUFFER_SIZE 1024
-// strlen("255.255.255.255/255.255.255.255") + '\0'
-#define CIDR_MAX_LENGTH 32  // 3 for "/32" and 1 for '\0'
 // strlen("1.1.1.1")
 #define CIDR_MIN_LENGTH 7
-// The buffer may contain a limited number of records. In the limiting case there cannot be more than
-// ceil(BUFFER_SIZE / (CIDR_MIN_LENGTH + 1) )
-// Here:
-//   - `(BUFFER_SIZE + (CIDR_MIN_LENGTH + 1) - 1)` is an integer equivalent of `ceil()`
-//   - `+1` in the denominator is for a separator between adjacent records
-#define MAX_BUFFER_CAPACITY ((BUFFER_SIZE + (CIDR_MIN_LENGTH + 1) - 1) / (CIDR_MIN_LENGTH + 1))
+
+
+// State of the CIDR tokenizer. It is preserved between calls to `parse_content()`,
+// so a CIDR block may be split between two (or more) consecutive chunks of the input.
+typedef struct {
+    const Scanner *scanner;
+    uint8_t state;
+    uint32_t address;
+    uint32_t value;     // octet or prefix length being accumulated
+    // the first octet of the token that is out of range or has a leading zero, as it's written
+    uint32_t bad_octet;
+    uint8_t bad_octet_position; // 1 - 4, 0 if all the octets are valid
+    uint8_t bad_octet_length;   // the number of its digits, so "01" is reported as it is
+    bool leading_zero;          // the bad octet has a leading zero rather than being out of range
+    DedupSet *dedup;    // drops the exact duplicates before they're stored (NULL keeps them)
+    bool check_order;   // checks that the stored ranges go in the ascending order of their starts
+    bool out_of_order;  // a stored range has started below the previous one (with `check_order`)
+    uint32_t previous;  // the start of the last stored range (with `check_order`)
+} CidrParser;
 
 
 /**
- * @brief Returns a precompiled regex_t object for matching CIDR blocks.
+ * @brief Initializes the CIDR tokenizer.
  *
- * This function compiles a regular expression that matches CIDR blocks in the format
- * "address/prefix_length". The regex is compiled with extended syntax and newline support.
+ * This function resets the tokenizer into its initial state, i.e. as if it
+ * was at the beginning of the input. The duplicates are kept until `dedup`
+ * is set, and the order of the tokens isn't checked until `check_order` is.
  *
- * The caller is responsible for freeing the regex_t object using `regfree()` after use.
- *
- * @return A regex_t object representing the compiled regular expression.
+ * @param parser A pointer to the CidrParser structure to initialize.
  */
-regex_t get_regex();
+void init_parser(CidrParser *parser);
 
 
 /**
- * @brief Parses content for CIDR blocks defined by the given regular expression
- * and returns the parsed data.
+ * @brief Parses a chunk of the content for CIDR blocks and stores them as IP ranges.
+ *
+ * This function feeds the given chunk to the table-driven tokenizer. The input is
+ * a sequence of tokens separated by whitespace symbols. Every token that has the form
+ * `a.b.c.d` or `a.b.c.d/prefix` is converted into an IP range (IPv4 addresses without
+ * a prefix are treated as `/32`), all the other tokens are skipped.
  *
- * This function scans the input content for matches against the provided
- * regular expression to identify CIDR blocks. For IPv4 addresses without a
- * CIDR prefix, it appends `/32` by default. Each matched CIDR block is stored
- * in the ParsedData structure.
+ * The content doesn't have to be NUL-terminated, and a token may be split between
+ * this chunk and the next one: the tokenizer keeps its state in the `parser`.
  *
- * @param content The input string to be parsed for CIDR blocks.
- * @param regex A precompiled regular expression to identify CIDR blocks.
+ * @param parser A pointer to the tokenizer state.
+ * @param content The chunk of the input to be parsed.
+ * @param length The length of the chunk in bytes.
  * @param range_list A pointer to the ipRangeList structure to store the extracted CIDR blocks.
- * @param require_full_cidr A boolean flag indicating whether to require a full CIDR block
  *
- * @return The number of characters parsed from the input string
+ * @return The number of IP ranges extracted from the chunk
  *
  * @note If memory allocation fails, the function prints an error message and
  *       exits the program.
  */
-size_t parse_content(const char *content, const regex_t *regex, ipRangeList *range_list, const bool require_full_cidr);
+size_t parse_content(CidrParser *parser, const char *content, size_t length, ipRangeList *range_list);
+
+
+/**
+ * @brief Finalizes parsing at the end of the input.
+ *
+ * This function handles the last token of the input, which isn't followed by
+ * a whitespace symbol, and resets the tokenizer into its initial state.
+ *
+ * @param parser A pointer to the tokenizer state.
+ * @param range_list A pointer to the ipRangeList structure to store the extracted CIDR block.
+ *
+ * @return The number of IP ranges extracted (either 0 or 1)
+ */
+size_t finish_parser(CidrParser *parser, ipRangeList *range_list);
 
 #endif //MERGE_IP_PARSE_H
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "queue.h"
+#include "parallel.h"
+
+
+/**
+ * @brief Initializes an empty queue.
+ *
+ * @param queue A pointer to the queue.
+ * @param capacity The number of the items the queue can hold, a power of two.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void init_spsc_queue(SpscQueue *queue, const size_t capacity) {
+    queue->slots = malloc(capacity * sizeof(void *));
+    if (!queue->slots) {
+        perror("Failed to allocate queue");
+        exit(EXIT_FAILURE);
+    }
+    queue->mask = capacity - 1;
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+
+/**
+ * @brief Puts the item at the end of the queue, unless it's full.
+ *
+ * Must be called by the producer thread only.
+ *
+ * @param queue A pointer to the queue.
+ * @param item The item (may be NULL).
+ * @return true if the item is put; false if the queue is full.
+ */
+bool try_push_spsc_queue(SpscQueue *queue, void *item) {
+    // only this thread changes `tail`, so it's read without a barrier
+    const size_t tail = queue->tail;
+    if (tail - load_acquire(&queue->head) > queue->mask) {
+        return false;
+    }
+
+    queue->slots[tail & queue->mask] = item;
+    store_release(&queue->tail, tail + 1);
+    return true;
+}
+
+
+/**
+ * @brief Takes the item from the start of the queue, unless it's empty.
+ *
+ * Must be called by the consumer thread only.
+ *
+ * @param queue A pointer to the queue.
+ * @param item A pointer to store the item.
+ * @return true if the item is taken; false if the queue is empty.
+ */
+bool try_pop_spsc_queue(SpscQueue *queue, void **item) {
+    // only this thread changes `head`, so it's read without a barrier
+    const size_t head = queue->head;
+    if (head == load_acquire(&queue->tail)) {
+        return false;
+    }
+
+    *item = queue->slots[head & queue->mask];
+    store_release(&queue->head, head + 1);
+    return true;
+}
+
+
+/**
+ * @brief Puts the item at the end of the queue, waiting while it's full.
+ *
+ * @param queue A pointer to the queue.
+ * @param item The item (may be NULL).
+ */
+void push_spsc_queue(SpscQueue *queue, void *item) {
+    for (unsigned attempt = 0; !try_push_spsc_queue(queue, item); attempt++) {
+        wait_for_progress(attempt);
+    }
+}
+
+
+/**
+ * @brief Takes the item from the start of the queue, waiting while it's empty.
+ *
+ * @param queue A pointer to the queue.
+ * @return The item.
+ */
+void *pop_spsc_queue(SpscQueue *queue) {
+    void *item = NULL;
+    for (unsigned attempt = 0; !try_pop_spsc_queue(queue, &item); attempt++) {
+        wait_for_progress(attempt);
+    }
+    return item;
+}
+
+
+/**
+ * @brief Releases the memory of the queue.
+ *
+ * @param queue A pointer to the queue.
+ */
+void free_spsc_queue(SpscQueue *queue) {
+    free(queue->slots);
+    queue->slots = NULL;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MERGE_IP_QUEUE_H
+#define MERGE_IP_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "atomics.h"
+
+
+// A bounded lock-free queue of pointers between exactly one producer thread and
+// exactly one consumer thread. The producer owns `tail`, the consumer owns `head`,
+// so neither of them needs a lock or a compare-and-swap.
+typedef struct {
+    void **slots;
+    size_t mask;        // the capacity minus one, the capacity is a power of two
+    AtomicSize head;    // the number of the items taken so far
+    char padding[64];   // keeps the counters of the two threads in different cache lines
+    AtomicSize tail;    // the number of the items put so far
+} SpscQueue;
+
+
+/**
+ * @brief Initializes an empty queue.
+ *
+ * @param queue A pointer to the queue.
+ * @param capacity The number of the items the queue can hold, a power of two.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void init_spsc_queue(SpscQueue *queue, size_t capacity);
+
+
+/**
+ * @brief Puts the item at the end of the queue, unless it's full.
+ *
+ * Must be called by the producer thread only.
+ *
+ * @param queue A pointer to the queue.
+ * @param item The item (may be NULL).
+ * @return true if the item is put; false if the queue is full.
+ */
+bool try_push_spsc_queue(SpscQueue *queue, void *item);
+
+
+/**
+ * @brief Takes the item from the start of the queue, unless it's empty.
+ *
+ * Must be called by the consumer thread only.
+ *
+ * @param queue A pointer to the queue.
+ * @param item A pointer to store the item.
+ * @return true if the item is taken; false if the queue is empty.
+ */
+bool try_pop_spsc_queue(SpscQueue *queue, void **item);
+
+
+/**
+ * @brief Puts the item at the end of the queue, waiting while it's full.
+ *
+ * @param queue A pointer to the queue.
+ * @param item The item (may be NULL).
+ */
+void push_spsc_queue(SpscQueue *queue, void *item);
+
+
+/**
+ * @brief Takes the item from the start of the queue, waiting while it's empty.
+ *
+ * @param queue A pointer to the queue.
+ * @return The item.
+ */
+void *pop_spsc_queue(SpscQueue *queue);
+
+
+/**
+ * @brief Releases the memory of the queue.
+ *
+ * @param queue A pointer to the queue.
+ */
+void free_spsc_queue(SpscQueue *queue);
+
+#endif //MERGE_IP_QUEUE_H
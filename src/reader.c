@@ -14,41 +14,484 @@
  * limitations under the License.
  */
 
+// `F_GETPIPE_SZ` is a Linux extension
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 #include "reader.h"
+#include "merge.h"
+#include "parallel.h"
 #include "parser.h"
+#include "queue.h"
+#include "scanner.h"
+#include "uring.h"
+
+
+#define INITIAL_RANGE_LIST_CAPACITY 1024
+// a rough length of a token with its separator, e.g. "10.20.30.0/24\n"
+#define AVERAGE_TOKEN_LENGTH 14
+// the smallest chunk of an in-memory input parsed by a separate thread
+#define MIN_PARALLEL_CHUNK_SIZE (256 * 1024)
+// the memory an entry takes while the list is merged: the entry and its copy in the sort scratch
+#define BYTES_PER_MERGED_ENTRY (2 * sizeof(ipRange))
+// the blocks every tokenizer of the pipeline owns: one is parsed while the other is read
+#define PIPELINE_BLOCKS_PER_TOKENIZER 2
+// the capacity of the queues between the stages: all the blocks of a tokenizer and the end marker
+#define PIPELINE_QUEUE_CAPACITY 4
+
+
+// The state of a sorted input read as a RangeStream
+struct SortedReader {
+    FILE *stream;
+    const char *name;       // the name of the input used in the error messages
+    char *buffer;
+    size_t buffer_size;
+    CidrParser parser;
+    ipRangeList *chunk;     // the ranges and hosts parsed from the last chunk of the input
+    size_t range_position;  // the next range of the chunk
+    size_t host_position;   // the next host of the chunk
+    bool finished;          // the whole input is parsed
+};
+
+
+/**
+ * @brief Estimates the number of IP ranges in the input of the given size.
+ *
+ * The estimate is used as the initial capacity of the ipRangeList, so most of
+ * the inputs are parsed without any reallocation.
+ *
+ * @param input_size The size of the input in bytes (0 if unknown).
+ * @return The expected number of IP ranges.
+ */
+static size_t estimate_range_count(const size_t input_size) {
+    const size_t estimate = input_size / AVERAGE_TOKEN_LENGTH;
+    return estimate > INITIAL_RANGE_LIST_CAPACITY ? estimate : INITIAL_RANGE_LIST_CAPACITY;
+}
+
+
+/**
+ * @brief Creates an ipRangeList for the input of the given size.
+ *
+ * Both ranges and hosts get the estimated capacity: a feed may consist of either
+ * of them, and the part of the arrays which is never written costs no memory.
+ *
+ * @param input_size The size of the input in bytes (0 if unknown).
+ * @return A pointer to the new list.
+ */
+static ipRangeList *get_list_for_input(const size_t input_size) {
+    const size_t estimate = estimate_range_count(input_size);
+    ipRangeList *data = getIpRangeList(estimate);
+    reserveIpHosts(data, estimate);
+    return data;
+}
+
+
+/**
+ * @brief Checks whether the entries are merged while the input is being read.
+ *
+ * @param options Reading options or NULL.
+ * @return true in the online mode or with the memory limit; false otherwise.
+ */
+static bool is_merged_while_reading(const ReaderOptions *options) {
+    return options && (options->online || options->max_memory);
+}
+
+
+/**
+ * @brief Returns the deduplication set shared by all the inputs.
+ *
+ * @param options Reading options or NULL.
+ * @return The set or NULL if the duplicates are kept.
+ */
+static DedupSet *get_shared_dedup_set(const ReaderOptions *options) {
+    return options ? options->dedup : NULL;
+}
+
+
+/**
+ * @brief Prepares the own deduplication set of a parsing thread.
+ *
+ * The first thread uses the shared set directly, while the others fill their
+ * own sets in parallel with it, which are merged into the shared one afterwards
+ * by `merge_dedup_set()`.
+ *
+ * @param own The set to be initialized for the thread.
+ * @param index The index of the thread.
+ * @param options Reading options or NULL.
+ * @return The set for the parser of the thread or NULL if the duplicates are kept.
+ */
+static DedupSet *get_thread_dedup_set(DedupSet *own, const size_t index, const ReaderOptions *options) {
+    DedupSet *shared = get_shared_dedup_set(options);
+    if (!shared || index == 0) {
+        return shared;
+    }
+    init_dedup_set(own);
+    return own;
+}
+
+
+/**
+ * @brief Merges the own set of a parsing thread into the shared one and releases it.
+ *
+ * The entries of the thread's list seen by the shared set already (i.e. by
+ * another thread or in another input) are dropped from the list, so the
+ * duplicates are dropped no matter how the input is split between the threads.
+ *
+ * @param shared The shared set.
+ * @param own The own set of the thread.
+ * @param list The list parsed by the thread.
+ */
+static void merge_dedup_set(DedupSet *shared, DedupSet *own, ipRangeList *list) {
+    size_t length = 0;
+    for (size_t i = 0; i < list->length; i++) {
+        const ipRange range = list->cidrs[i];
+        if (insert_dedup_key(shared, get_dedup_key(range.min_ip.s_addr, range.max_ip.s_addr))) {
+            list->cidrs[length++] = range;
+        }
+    }
+    list->length = length;
+
+    size_t host_count = 0;
+    for (size_t i = 0; i < list->host_count; i++) {
+        const uint32_t host = list->hosts[i];
+        if (insert_dedup_key(shared, get_dedup_key(host, host))) {
+            list->hosts[host_count++] = host;
+        }
+    }
+    list->host_count = host_count;
+
+    // the shared set has counted the entries kept by the own set, but not the ones it has dropped
+    shared->stats.entries += own->stats.duplicates;
+    shared->stats.duplicates += own->stats.duplicates;
+    free_dedup_set(own);
+}
+
+
+/**
+ * @brief Limits the amount of the input parsed between the merges.
+ *
+ * Every 8 bytes of the input may give an entry (e.g. "1.1.1.1\n"), so with the
+ * memory limit the slice is cut down to make the list overshoot the limit by
+ * a quarter at most.
+ *
+ * @param size The size of the read buffer or of the slice.
+ * @param options Reading options.
+ * @return The size of the slice.
+ */
+static size_t limit_slice_size(const size_t size, const ReaderOptions *options) {
+    const size_t limit = options->max_memory / 8;
+    if (!options->max_memory || size <= limit) {
+        return size;
+    }
+    return limit > MIN_READ_BUFFER_SIZE ? limit : MIN_READ_BUFFER_SIZE;
+}
+
+
+/**
+ * @brief Merges the entries parsed so far once there are enough of them.
+ *
+ * The list is the set of the merged ranges (the first `merged_length` ranges)
+ * followed by the staged ranges and hosts. In the online mode they're merged
+ * when the staged entries outnumber both ONLINE_STAGING_SIZE and the set, so
+ * every entry takes part in a constant number of merges on average. With the
+ * memory limit, they're merged when the list reaches the limit, and the merged
+ * set is spilled to a temporary file if it still takes more than a half of it.
+ *
+ * The merged entries have no duplicates, so the deduplication set, if any,
+ * starts anew then, and its size is bounded by the merge interval.
+ *
+ * @param list The list being parsed.
+ * @param merged_length A pointer to the number of the merged ranges in the list.
+ * @param options Reading options.
+ */
+static void merge_staged_entries(ipRangeList *list, size_t *merged_length, const ReaderOptions *options) {
+    const size_t staged = list->length - *merged_length + list->host_count;
+    const size_t limit = options->max_memory ? options->max_memory / BYTES_PER_MERGED_ENTRY : SIZE_MAX;
+
+    const bool is_online_merge_due = options->online && staged >= ONLINE_STAGING_SIZE && staged >= *merged_length;
+    if (!is_online_merge_due && list->length + list->host_count < limit) {
+        return;
+    }
+
+    const MergeOptions merge_options = {.engine = MERGE_ENGINE_AUTO, .max_memory = options->max_memory};
+    merge_cidr_in_place(list, &merge_options);
+    *merged_length = list->length;
+    if (options->dedup) {
+        clear_dedup_set(options->dedup);
+    }
+
+    if (list->length >= limit / 2) {
+        spill_ip_ranges(options->spill_runs, list);
+        list->length = 0;
+        *merged_length = 0;
+    }
+}
+
+
+/**
+ * @brief Returns the size of the stream if it's a regular file.
+ *
+ * @param stream The input file stream.
+ * @return The size of the file in bytes or 0 if it's unknown (e.g. for pipes).
+ */
+static size_t get_stream_size(FILE *stream) {
+#ifndef _WIN32
+    const int fd = fileno(stream);
+    struct stat file_stat;
+    if (fd >= 0 && fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode)
+            && file_stat.st_size > 0 && (uintmax_t)file_stat.st_size <= SIZE_MAX) {
+        return (size_t)file_stat.st_size;
+    }
+#else
+    (void)stream;
+#endif
+
+    return 0;
+}
+
+
+/**
+ * @brief Picks the size of the read buffer for the given stream.
+ *
+ * The buffer is at least DEFAULT_READ_BUFFER_SIZE bytes, but it's increased
+ * up to the preferred I/O block size of the file or the capacity of the pipe
+ * if they're larger. The result never exceeds MAX_READ_BUFFER_SIZE.
+ *
+ * @param stream The input file stream.
+ * @return The size of the buffer in bytes.
+ */
+static size_t get_read_buffer_size(FILE *stream) {
+    size_t buffer_size = DEFAULT_READ_BUFFER_SIZE;
+
+#ifndef _WIN32
+    // memory streams (e.g. `fmemopen()`) have no descriptor
+    const int fd = fileno(stream);
+    struct stat file_stat;
+    if (fd >= 0 && fstat(fd, &file_stat) == 0) {
+        if (file_stat.st_blksize > 0 && (size_t)file_stat.st_blksize > buffer_size) {
+            buffer_size = (size_t)file_stat.st_blksize;
+        }
+
+        #ifdef F_GETPIPE_SZ
+            if (S_ISFIFO(file_stat.st_mode)) {
+                const int pipe_size = fcntl(fd, F_GETPIPE_SZ);
+                if (pipe_size > 0 && (size_t)pipe_size > buffer_size) {
+                    buffer_size = (size_t)pipe_size;
+                }
+            }
+        #endif
+    }
+#else
+    (void)stream;
+#endif
+
+    return buffer_size < MAX_READ_BUFFER_SIZE ? buffer_size : MAX_READ_BUFFER_SIZE;
+}
+
+
+// A block of the input passed from the reader to a tokenizer
+typedef struct {
+    char *data;
+    size_t offset;  // the start of the content to be parsed
+    size_t length;  // the end of the content to be parsed, it's always followed by a whitespace
+} PipelineBlock;
+
+typedef struct {
+    SpscQueue filled_blocks;  // from the reader to the tokenizer, NULL marks the end of the input
+    SpscQueue free_blocks;    // from the tokenizer back to the reader
+    PipelineBlock blocks[PIPELINE_BLOCKS_PER_TOKENIZER];
+    ipRangeList *ranges;
+    DedupSet *dedup;    // the shared set, the own one, or NULL
+    DedupSet own_dedup;
+} Tokenizer;
+
+typedef struct {
+    FILE *stream;
+    size_t block_size;
+    Tokenizer *tokenizers;
+    size_t tokenizer_count;
+} Pipeline;
+
+typedef struct {
+    Pipeline *pipeline;
+    size_t index;  // 0 is the reader, the tokenizers follow it
+} PipelineStage;
+
+
+/**
+ * @brief Reads the stream into blocks and hands them over to the tokenizers in turn.
+ *
+ * Every block is cut right after its last whitespace and the rest of it is carried
+ * over to the next block, so no token is split between the tokenizers. A block
+ * without any whitespace is the middle of a token much longer than any CIDR, so
+ * it's skipped, as well as the rest of the token in the next block.
+ *
+ * @param pipeline The pipeline.
+ */
+static void run_reader_stage(const Pipeline *pipeline) {
+    size_t tokenizer = 0;
+    PipelineBlock *block = pop_spsc_queue(&pipeline->tokenizers[0].free_blocks);
+    size_t filled = 0;
+    bool skip_token = false;
+
+    for (;;) {
+        const size_t length = fread(block->data + filled, sizeof(char), pipeline->block_size - filled, pipeline->stream);
+        const bool is_end = length < pipeline->block_size - filled;
+        filled += length;
+
+        block->offset = 0;
+        if (skip_token) {
+            block->offset = get_scanner()->scan(block->data, 0, filled, FIND_SPACE);
+            skip_token = block->offset == filled;
+        }
+
+        if (is_end) {
+            block->length = filled;
+            push_spsc_queue(&pipeline->tokenizers[tokenizer].filled_blocks, block);
+            break;
+        }
+
+        size_t cut = filled;
+        while (cut > block->offset && !is_space(block->data[cut - 1])) {
+            cut--;
+        }
+
+        const size_t next_tokenizer = (tokenizer + 1) % pipeline->tokenizer_count;
+        PipelineBlock *next_block = pop_spsc_queue(&pipeline->tokenizers[next_tokenizer].free_blocks);
+        if (cut == block->offset) {
+            skip_token = true;
+            filled = 0;
+        } else {
+            filled -= cut;
+            memcpy(next_block->data, block->data + cut, filled);
+        }
+
+        block->length = cut;
+        push_spsc_queue(&pipeline->tokenizers[tokenizer].filled_blocks, block);
+        block = next_block;
+        tokenizer = next_tokenizer;
+    }
+
+    for (size_t i = 0; i < pipeline->tokenizer_count; i++) {
+        push_spsc_queue(&pipeline->tokenizers[i].filled_blocks, NULL);
+    }
+}
 
 
 /**
- * @brief Moves the reminder part of the buffer to the start and zeroes out the rest.
+ * @brief Parses the blocks of a tokenizer till the end of the input.
  *
- * This function takes a buffer and a starting position. It moves the content of the buffer
- * starting from the given position to the beginning of the buffer and zeroes out the rest.
+ * @param tokenizer The tokenizer.
+ */
+static void run_tokenizer_stage(Tokenizer *tokenizer) {
+    CidrParser parser;
+    init_parser(&parser);
+    parser.dedup = tokenizer->dedup;
+
+    PipelineBlock *block;
+    while ( (block = pop_spsc_queue(&tokenizer->filled_blocks)) ) {
+        // every block starts and ends at a token boundary, so the parser starts anew
+        parse_content(&parser, block->data + block->offset, block->length - block->offset, tokenizer->ranges);
+        finish_parser(&parser, tokenizer->ranges);
+        push_spsc_queue(&tokenizer->free_blocks, block);
+    }
+}
+
+
+static void run_pipeline_stage(void *argument) {
+    const PipelineStage *stage = argument;
+    if (stage->index == 0) {
+        run_reader_stage(stage->pipeline);
+    } else {
+        run_tokenizer_stage(&stage->pipeline->tokenizers[stage->index - 1]);
+    }
+}
+
+
+/**
+ * @brief Reads and parses the stream by a pipeline of threads.
  *
- * @param buffer The buffer to be modified.
- * @param reminder_start_pos The starting position from which to move content.
+ * One thread reads the stream into large blocks, and the other threads parse them,
+ * each into its own list. The threads are connected by lock-free single-producer
+ * single-consumer queues, so the reading and the parsing overlap, and a slow
+ * producer of the stream makes the parsing threads sleep rather than spin.
  *
- * @return The length of the moved fragment.
+ * @param stream The input stream.
+ * @param options Reading options, at least 2 threads.
+ * @return ParsedData structure containing all the parsed CIDR blocks or NULL if
+ *         the threads cannot be started (the caller should read the stream by itself then).
  */
-size_t move_reminder_to_start(char *buffer, const size_t reminder_start_pos) {
-    size_t buffer_size = strlen(buffer);
-    if (reminder_start_pos >= buffer_size) {
-        // If start_pos is out of bounds, zero the entire buffer
-        memset(buffer, 0, buffer_size);
-        return 0;
+static ipRangeList *read_pipelined(FILE *stream, const ReaderOptions *options) {
+    const size_t tokenizer_count = options->threads - 1;
+    Pipeline pipeline = {
+        .stream = stream,
+        .block_size = options->buffer_size ? options->buffer_size : DEFAULT_READ_BUFFER_SIZE,
+        .tokenizers = calloc(tokenizer_count, sizeof(Tokenizer)),
+        .tokenizer_count = tokenizer_count,
+    };
+    PipelineStage *stages = malloc((tokenizer_count + 1) * sizeof(PipelineStage));
+    if (!pipeline.tokenizers || !stages) {
+        perror("Failed to allocate pipeline");
+        exit(EXIT_FAILURE);
     }
-    // Calculate the length of the fragment to move
-    size_t fragment_length = buffer_size - reminder_start_pos;
 
-    // Move the fragment to the beginning of the buffer
-    memmove(buffer, buffer + reminder_start_pos, fragment_length);
+    for (size_t i = 0; i < tokenizer_count; i++) {
+        Tokenizer *tokenizer = &pipeline.tokenizers[i];
+        init_spsc_queue(&tokenizer->filled_blocks, PIPELINE_QUEUE_CAPACITY);
+        init_spsc_queue(&tokenizer->free_blocks, PIPELINE_QUEUE_CAPACITY);
+        for (size_t b = 0; b < PIPELINE_BLOCKS_PER_TOKENIZER; b++) {
+            tokenizer->blocks[b].data = malloc(pipeline.block_size);
+            if (!tokenizer->blocks[b].data) {
+                perror("Failed to allocate read buffer");
+                exit(EXIT_FAILURE);
+            }
+            try_push_spsc_queue(&tokenizer->free_blocks, &tokenizer->blocks[b]);
+        }
+        tokenizer->ranges = get_list_for_input(0);
+        tokenizer->dedup = get_thread_dedup_set(&tokenizer->own_dedup, i, options);
+    }
+    for (size_t i = 0; i <= tokenizer_count; i++) {
+        stages[i] = (PipelineStage){.pipeline = &pipeline, .index = i};
+    }
 
-    // Zero out the rest of the buffer
-    memset(buffer + fragment_length, 0, buffer_size - fragment_length);
+    const bool is_read = run_concurrently(run_pipeline_stage, stages, sizeof(PipelineStage), tokenizer_count + 1);
 
-    return fragment_length;
+    // the first list takes over the others
+    ipRangeList *ip_range_list = is_read ? pipeline.tokenizers[0].ranges : NULL;
+    for (size_t i = 0; i < tokenizer_count; i++) {
+        Tokenizer *tokenizer = &pipeline.tokenizers[i];
+        if (i > 0 && tokenizer->dedup) {
+            merge_dedup_set(options->dedup, tokenizer->dedup, tokenizer->ranges);
+        }
+        if (is_read && i > 0) {
+            appendIpRanges(ip_range_list, tokenizer->ranges->cidrs, tokenizer->ranges->length);
+            appendIpHosts(ip_range_list, tokenizer->ranges->hosts, tokenizer->ranges->host_count);
+        }
+        if (!is_read || i > 0) {
+            freeIpRangeList(tokenizer->ranges);
+        }
+        for (size_t b = 0; b < PIPELINE_BLOCKS_PER_TOKENIZER; b++) {
+            free(tokenizer->blocks[b].data);
+        }
+        free_spsc_queue(&tokenizer->filled_blocks);
+        free_spsc_queue(&tokenizer->free_blocks);
+    }
+    free(stages);
+    free(pipeline.tokenizers);
+
+    return ip_range_list;
 }
 
 
@@ -56,65 +499,510 @@ size_t move_reminder_to_start(char *buffer, const size_t reminder_start_pos) {
  * @brief Reads data from a given stream, parses it to extract CIDR blocks,
  *        and returns a ParsedData structure containing all the extracted CIDR blocks.
  *
- * This function reads the input stream line by line, and for each line,
- * it attempts to match and extract CIDR blocks using a regular expression.
- * The extracted CIDR blocks are stored in a ParsedData structure, which is returned
- * upon completion of the function. It handles potential line splits by keeping
- * any remaining part of a line in a buffer till it is fully parsed in subsequent read operations.
+ * This function reads the input stream chunk by chunk and feeds every chunk
+ * to the CIDR tokenizer. The extracted CIDR blocks are stored in a ParsedData
+ * structure, which is returned upon completion of the function. A CIDR block
+ * split between two chunks is handled by the tokenizer, which keeps its state
+ * till the next chunk is read.
+ *
+ * Unless the buffer size is given in the options, it is derived from the
+ * preferred I/O block size of the stream or the capacity of the pipe.
+ *
+ * If more than one thread is requested, one thread reads the stream into blocks
+ * (DEFAULT_READ_BUFFER_SIZE bytes unless the buffer size is given) and the other
+ * threads parse them, so reading and parsing overlap.
+ *
+ * In the online mode, the list is a set of the merged ranges followed by the
+ * entries parsed since the last merge. Once there are at least ONLINE_STAGING_SIZE
+ * such entries, and at least as many as the merged ranges, they're merged into
+ * the set. Thus, the list never grows much beyond twice the size of the result.
+ *
+ * With the memory limit, the entries are merged the same way once they reach
+ * the limit, and if the merged ranges still take more than a half of it, they
+ * go to a temporary file as a sorted run, leaving the list empty. The caller
+ * merges the runs with the list at the end (see `merge_range_streams()`).
  *
  * @param stream The input file stream to read data from.
+ * @param options Reading options or NULL to use the defaults.
+ * @return ParsedData structure containing all the parsed CIDR blocks.
+ *
+ * @note If memory allocation fails, the function prints an error message and exits the program.
+ */
+ipRangeList *read_from_stream(FILE *stream, const ReaderOptions *options) {
+    const bool merged_while_reading = is_merged_while_reading(options);
+    if (!merged_while_reading && options && options->threads > 1) {
+        ipRangeList *ip_range_list = read_pipelined(stream, options);
+        if (ip_range_list) {
+            return ip_range_list;
+        }
+    }
+
+    size_t buffer_size = options && options->buffer_size
+        ? options->buffer_size
+        : get_read_buffer_size(stream);
+    if (options) {
+        buffer_size = limit_slice_size(buffer_size, options);
+    }
+
+    char *buffer = malloc(buffer_size);
+    if (!buffer) {
+        perror("Failed to allocate read buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    ipRangeList *ip_range_list = get_list_for_input(merged_while_reading ? 0 : get_stream_size(stream));
+    size_t merged_length = 0;
+
+    CidrParser parser;
+    init_parser(&parser);
+    parser.dedup = get_shared_dedup_set(options);
+
+    // the tokenizer keeps its state between chunks, so a CIDR split by the buffer
+    // boundary is neither moved nor re-scanned: every byte is read and parsed once
+    size_t length = 0;
+    while ( (length = fread(buffer, sizeof(char), buffer_size, stream)) > 0 ) {
+        parse_content(&parser, buffer, length, ip_range_list);
+        if (merged_while_reading) {
+            merge_staged_entries(ip_range_list, &merged_length, options);
+        }
+    }
+    finish_parser(&parser, ip_range_list);
+
+    free(buffer);
+
+    return ip_range_list;
+}
+
+
+typedef struct {
+    const char *content;
+    size_t length;
+    ipRangeList *ranges;
+    DedupSet *dedup;    // the shared set, the own one, or NULL
+    DedupSet own_dedup; // the tasks run in parallel, so each of them but the first has its own set
+} ParseTask;
+
+
+/**
+ * @brief Parses one chunk of an in-memory input into the task's own list.
+ *
+ * @param argument A pointer to the ParseTask structure.
+ */
+static void parse_chunk(void *argument) {
+    ParseTask *task = argument;
+    task->ranges = get_list_for_input(task->length);
+
+    CidrParser parser;
+    init_parser(&parser);
+    parser.dedup = task->dedup;
+    parse_content(&parser, task->content, task->length, task->ranges);
+    finish_parser(&parser, task->ranges);
+}
+
+
+/**
+ * @brief Parses a memory buffer merging the entries while reading it.
+ *
+ * The buffer is fed to the tokenizer slice by slice, and the parsed entries are
+ * merged (and spilled) between the slices.
+ *
+ * @param content The buffer to be parsed.
+ * @param length The length of the buffer in bytes.
+ * @param options Reading options.
+ * @return The list of the parsed entries, partially merged.
+ */
+static ipRangeList *read_from_memory_merging(const char *content, const size_t length, const ReaderOptions *options) {
+    const size_t slice_size = limit_slice_size(options->buffer_size ? options->buffer_size : DEFAULT_READ_BUFFER_SIZE,
+                                               options);
+    ipRangeList *ip_range_list = get_list_for_input(0);
+    size_t merged_length = 0;
+
+    CidrParser parser;
+    init_parser(&parser);
+    parser.dedup = options->dedup;
+
+    for (size_t offset = 0; offset < length; offset += slice_size) {
+        const size_t slice_length = length - offset < slice_size ? length - offset : slice_size;
+        parse_content(&parser, content + offset, slice_length, ip_range_list);
+        merge_staged_entries(ip_range_list, &merged_length, options);
+    }
+    finish_parser(&parser, ip_range_list);
+
+    return ip_range_list;
+}
+
+
+/**
+ * @brief Parses CIDR blocks from a memory buffer.
+ *
+ * This function feeds the whole buffer to the CIDR tokenizer at once, so
+ * there's neither copying nor carrying a split CIDR over between chunks.
+ *
+ * If more than one thread is requested, the buffer is cut into chunks aligned
+ * to whitespace symbols, each chunk is parsed by its own thread into its own
+ * list, and the lists are concatenated at the end.
+ *
+ * In the online mode or with the memory limit, the buffer is parsed by a single
+ * thread, slice by slice, merging and spilling the parsed entries as
+ * `read_from_stream()` does.
+ *
+ * @param content The buffer to be parsed. It doesn't have to be NUL-terminated.
+ * @param length The length of the buffer in bytes.
+ * @param options Reading options or NULL to use the defaults.
  * @return ParsedData structure containing all the parsed CIDR blocks.
  *
  * @note If memory allocation fails, the function prints an error message and exits the program.
  */
-ipRangeList *read_from_stream(FILE *stream) {
-    ipRangeList *ip_range_list = getIpRangeList(MAX_BUFFER_CAPACITY);
+ipRangeList *read_from_memory(const char *content, const size_t length, const ReaderOptions *options) {
+    if (is_merged_while_reading(options)) {
+        return read_from_memory_merging(content, length, options);
+    }
 
-    regex_t regex = get_regex();
+    size_t threads = options && options->threads > 1 ? options->threads : 1;
+    // it isn't worth starting a thread for a tiny chunk
+    if (threads > length / MIN_PARALLEL_CHUNK_SIZE) {
+        threads = length / MIN_PARALLEL_CHUNK_SIZE > 0 ? length / MIN_PARALLEL_CHUNK_SIZE : 1;
+    }
 
-    char buffer[BUFFER_SIZE] = {0};
-    // `fread()` doesn't automatically add '\0' at the end of the buffer,
-    // so we have to read 1 symbol less
-    size_t reminder_size = 0;
-    while ( fread(buffer + reminder_size, sizeof(char), BUFFER_SIZE - reminder_size - 1, stream) ) {
-        const size_t parsed_chars = parse_content(buffer, &regex, ip_range_list, true);
-        reminder_size = move_reminder_to_start(buffer, parsed_chars);
+    ParseTask *tasks = malloc(threads * sizeof(ParseTask));
+    if (!tasks) {
+        perror("Failed to allocate parsing tasks");
+        exit(EXIT_FAILURE);
     }
 
-    if (reminder_size) {
-        parse_content(buffer + reminder_size, &regex, ip_range_list, false);
+    // every chunk but the first one starts right at a whitespace, so no token is split between chunks
+    const Scanner *scanner = get_scanner();
+    size_t chunk_start = 0;
+    for (size_t i = 0; i < threads; i++) {
+        size_t chunk_end = length;
+        if (i + 1 < threads) {
+            const size_t boundary = length / threads * (i + 1);
+            chunk_end = scanner->scan(content, boundary > chunk_start ? boundary : chunk_start, length, FIND_SPACE);
+        }
+
+        tasks[i] = (ParseTask){.content = content + chunk_start, .length = chunk_end - chunk_start, .ranges = NULL};
+        tasks[i].dedup = get_thread_dedup_set(&tasks[i].own_dedup, i, options);
+        chunk_start = chunk_end;
     }
 
-    regfree(&regex);
+    run_in_parallel(parse_chunk, tasks, sizeof(ParseTask), threads);
+
+    // the first list takes over the others, so single-threaded parsing doesn't copy anything
+    ipRangeList *ip_range_list = tasks[0].ranges;
+    size_t total_length = 0;
+    size_t total_host_count = 0;
+    for (size_t i = 0; i < threads; i++) {
+        if (i > 0 && tasks[i].dedup) {
+            merge_dedup_set(options->dedup, tasks[i].dedup, tasks[i].ranges);
+        }
+        total_length += tasks[i].ranges->length;
+        total_host_count += tasks[i].ranges->host_count;
+    }
+    reserveIpRangeList(ip_range_list, total_length);
+    reserveIpHosts(ip_range_list, total_host_count);
+    for (size_t i = 1; i < threads; i++) {
+        appendIpRanges(ip_range_list, tasks[i].ranges->cidrs, tasks[i].ranges->length);
+        appendIpHosts(ip_range_list, tasks[i].ranges->hosts, tasks[i].ranges->host_count);
+        freeIpRangeList(tasks[i].ranges);
+    }
+    free(tasks);
 
     return ip_range_list;
 }
 
 
+#ifndef _WIN32
+/**
+ * @brief Reads a regular file by io_uring and parses it.
+ *
+ * Several large reads are kept in flight, and the blocks are parsed in the order
+ * of the file as soon as they're read, so a single thread keeps the device busy
+ * while it parses. The parser keeps its state between the blocks, as it does in
+ * `read_from_stream()`, and so do the online mode and the memory limit.
+ *
+ * @param fd The descriptor of the opened file.
+ * @param size The size of the file in bytes.
+ * @param options Reading options (`async_io` is set).
+ * @return ParsedData structure containing all the parsed CIDR blocks or NULL if
+ *         io_uring is not available (the caller should read the file in another way then).
+ */
+static ipRangeList *read_from_async_file(const int fd, const size_t size, const ReaderOptions *options) {
+    const size_t block_size = limit_slice_size(options->buffer_size ? options->buffer_size : DEFAULT_READ_BUFFER_SIZE,
+                                               options);
+    AsyncReader *reader = open_async_reader(fd, size, block_size);
+    if (!reader) {
+        return NULL;
+    }
+
+    const bool merged_while_reading = is_merged_while_reading(options);
+    ipRangeList *ip_range_list = get_list_for_input(merged_while_reading ? 0 : size);
+    size_t merged_length = 0;
+
+    CidrParser parser;
+    init_parser(&parser);
+    parser.dedup = options->dedup;
+
+    const char *block = NULL;
+    size_t length = 0;
+    while (next_async_block(reader, &block, &length)) {
+        parse_content(&parser, block, length, ip_range_list);
+        if (merged_while_reading) {
+            merge_staged_entries(ip_range_list, &merged_length, options);
+        }
+    }
+    finish_parser(&parser, ip_range_list);
+
+    close_async_reader(reader);
+
+    return ip_range_list;
+}
+
+
+/**
+ * @brief Maps a regular file into memory and parses it.
+ *
+ * The tokenizer scans the mapping directly, so the file content is never
+ * copied into a user-space buffer.
+ *
+ * @param fd The descriptor of the opened file.
+ * @param size The size of the file in bytes.
+ * @param options Reading options or NULL to use the defaults.
+ * @return ParsedData structure containing all the parsed CIDR blocks or NULL if
+ *         the file cannot be mapped (the caller should read it as a stream then).
+ */
+static ipRangeList *read_from_mapped_file(const int fd, const size_t size, const ReaderOptions *options) {
+    char *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    // these are only hints, so errors are ignored
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    #ifdef MADV_HUGEPAGE
+        // works for files only if the kernel supports read-only THP for the file system
+        madvise(mapping, size, MADV_HUGEPAGE);
+    #endif
+
+    ipRangeList *data = read_from_memory(mapping, size, options);
+    munmap(mapping, size);
+
+    return data;
+}
+#endif
+
+
+/**
+ * @brief Prints how an input has been read, if the debug output is enabled.
+ *
+ * @param name The name of the input.
+ * @param backend The way the input has been read, e.g. "io_uring".
+ * @param options Reading options or NULL to use the defaults.
+ */
+static void print_read_backend(const char *name, const char *backend, const ReaderOptions *options) {
+    if (options && options->debug) {
+        printf("DEBUG: Read %s by %s\n", name, backend);
+    }
+}
+
+
 /**
  * Reads the content of a file specified by 'filename' and parses its data.
  *
- * This function opens the file in read mode, processes its content using
- * 'read_from_stream', and then closes the file.
+ * Regular files are memory-mapped and parsed in place, all the other files
+ * (e.g. named pipes or character devices) are processed by 'read_from_stream'.
+ * With the `async_io` option, the regular files which are parsed by a single
+ * thread anyway (one thread, the online mode or the memory limit) are read by
+ * io_uring with several reads in flight instead, if it's available.
  *
  * @param filename The name of the file to be read.
+ * @param options Reading options or NULL to use the defaults.
  * @return ParsedData struct containing the parsed data from the file.
  *
  * @note If the file cannot be opened, the function prints an error message
  *       and exits the program with a failure status.
  */
-ipRangeList *read_from_file(const char *filename) {
+ipRangeList *read_from_file(const char *filename, const ReaderOptions *options) {
+#ifndef _WIN32
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open file");
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode)
+            && file_stat.st_size > 0 && (uintmax_t)file_stat.st_size <= SIZE_MAX) {
+        // several threads parse the mapping faster than a single one parses the blocks as they come
+        const bool async_io = options && options->async_io
+            && (options->threads <= 1 || is_merged_while_reading(options));
+        ipRangeList *data = async_io ? read_from_async_file(fd, (size_t)file_stat.st_size, options) : NULL;
+        const char *backend = "io_uring";
+        if (!data) {
+            data = read_from_mapped_file(fd, (size_t)file_stat.st_size, options);
+            backend = "a memory mapping";
+        }
+        if (data) {
+            print_read_backend(filename, backend, options);
+            close(fd);
+            return data;
+        }
+    }
+
+    FILE *file = fdopen(fd, "r");
+#else
     FILE *file = fopen(filename, "r");
+#endif
     if (!file) {
         perror("Failed to open file");
         exit(EXIT_FAILURE);
     }
-    ipRangeList *data = read_from_stream(file);
+    ipRangeList *data = read_from_stream(file, options);
+    print_read_backend(filename, "a stream", options);
     fclose(file);
     return data;
 }
 
 
+/**
+ * @brief Reads and parses several files as a single input.
+ *
+ * Every file is read by `read_from_file()`, and the lists are concatenated. In
+ * the online mode or with the memory limit, the concatenated list is merged and
+ * spilled as if the files were one stream.
+ *
+ * @param filenames The names of the files to be read.
+ * @param count The number of the files (at least 1).
+ * @param options Reading options or NULL to use the defaults.
+ * @return ParsedData struct containing the parsed data from all the files.
+ *
+ * @note If a file cannot be opened, the function prints an error message
+ *       and exits the program with a failure status.
+ */
+ipRangeList *read_from_files(const char **filenames, const size_t count, const ReaderOptions *options) {
+    ipRangeList *data = read_from_file(filenames[0], options);
+    size_t merged_length = 0;
+
+    for (size_t i = 1; i < count; i++) {
+        ipRangeList *file_data = read_from_file(filenames[i], options);
+        appendIpRanges(data, file_data->cidrs, file_data->length);
+        appendIpHosts(data, file_data->hosts, file_data->host_count);
+        freeIpRangeList(file_data);
+
+        if (is_merged_while_reading(options)) {
+            merge_staged_entries(data, &merged_length, options);
+        }
+    }
+
+    return data;
+}
+
+
+/**
+ * @brief Opens a sorted input as a stream of IP ranges.
+ *
+ * The input is read and parsed chunk by chunk, so the memory is bounded by the
+ * size of the read buffer no matter how large the input is. The ranges must go
+ * in the ascending order of their start addresses (e.g. the output of merge-ip
+ * itself), which is checked while they're read.
+ *
+ * @param stream The input stream. It stays open when the reader is closed.
+ * @param name The name of the input used in the error messages.
+ * @param options Reading options or NULL to use the defaults.
+ * @return A pointer to the new reader.
+ *
+ * @note If memory allocation fails, the function prints an error message and exits the program.
+ */
+SortedReader *open_sorted_reader(FILE *stream, const char *name, const ReaderOptions *options) {
+    SortedReader *reader = calloc(1, sizeof(SortedReader));
+    if (!reader) {
+        perror("Failed to allocate sorted reader");
+        exit(EXIT_FAILURE);
+    }
+
+    reader->stream = stream;
+    reader->name = name;
+    reader->buffer_size = options && options->buffer_size ? options->buffer_size : get_read_buffer_size(stream);
+    reader->buffer = malloc(reader->buffer_size);
+    if (!reader->buffer) {
+        perror("Failed to allocate read buffer");
+        exit(EXIT_FAILURE);
+    }
+    reader->chunk = getIpRangeList(0);
+    init_parser(&reader->parser);
+    // the hosts and the ranges of a chunk are stored apart, so only the parser sees the order of the tokens
+    reader->parser.check_order = true;
+
+    return reader;
+}
+
+
+/**
+ * @brief Reads the next range of a sorted input.
+ *
+ * The ranges and the hosts of the parsed chunk are interleaved by their start
+ * addresses, and the next chunk is parsed once both of them are exhausted.
+ *
+ * @param reader A pointer to the SortedReader.
+ * @param range A pointer to store the range.
+ * @return true if the range is read; false at the end of the input.
+ *
+ * @note If the input isn't sorted, the function prints an error message and
+ *       exits the program.
+ */
+bool next_sorted_range(void *reader, ipRange *range) {
+    SortedReader *sorted = reader;
+    ipRangeList *chunk = sorted->chunk;
+
+    while (sorted->range_position == chunk->length && sorted->host_position == chunk->host_count) {
+        if (sorted->finished) {
+            return false;
+        }
+
+        chunk->length = 0;
+        chunk->host_count = 0;
+        sorted->range_position = 0;
+        sorted->host_position = 0;
+
+        const size_t length = fread(sorted->buffer, sizeof(char), sorted->buffer_size, sorted->stream);
+        if (length > 0) {
+            parse_content(&sorted->parser, sorted->buffer, length, chunk);
+        } else {
+            finish_parser(&sorted->parser, chunk);
+            sorted->finished = true;
+        }
+
+        if (sorted->parser.out_of_order) {
+            fprintf(stderr, "The input is not sorted: %s\n", sorted->name);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const bool has_range = sorted->range_position < chunk->length;
+    const bool has_host = sorted->host_position < chunk->host_count;
+    if (has_range && (!has_host
+            || chunk->cidrs[sorted->range_position].min_ip.s_addr <= chunk->hosts[sorted->host_position])) {
+        *range = chunk->cidrs[sorted->range_position++];
+    } else {
+        const uint32_t host = chunk->hosts[sorted->host_position++];
+        *range = (ipRange){.min_ip = {host}, .max_ip = {host}};
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Releases the reader. The stream stays open.
+ *
+ * @param reader A pointer to the reader.
+ */
+void close_sorted_reader(SortedReader *reader) {
+    freeIpRangeList(reader->chunk);
+    free(reader->buffer);
+    free(reader);
+}
+
+
 /**
  * Reads and parses data from standard input (stdin).
  *
@@ -122,9 +1010,12 @@ ipRangeList *read_from_file(const char *filename) {
  * from the standard input and parse it. It returns a ParsedData
  * structure containing the results.
  *
+ * @param options Reading options or NULL to use the defaults.
  * @return A ParsedData structure containing the parsed CIDR blocks and their
  *         count.
  */
-ipRangeList* read_from_stdin() {
-    return read_from_stream(stdin);
+ipRangeList* read_from_stdin(const ReaderOptions *options) {
+    ipRangeList *data = read_from_stream(stdin, options);
+    print_read_backend("stdin", "a stream", options);
+    return data;
 }
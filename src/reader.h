@@ -17,27 +17,83 @@
 #ifndef MERGE_IP_READER_H
 #define MERGE_IP_READER_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 
+#include "dedup.h"
 #include "ipRange.h"
+#include "spill.h"
+
+
+#define MIN_READ_BUFFER_SIZE 1024                // 1 KiB
+#define DEFAULT_READ_BUFFER_SIZE (1024 * 1024)   // 1 MiB
+#define MAX_READ_BUFFER_SIZE (16 * 1024 * 1024)  // 16 MiB
+// the number of the entries parsed in the online mode before they're merged
+#define ONLINE_STAGING_SIZE (256 * 1024)
+
+
+typedef struct {
+    // the size of the buffer used to read streams, 0 means "detect it automatically"
+    size_t buffer_size;
+    // the number of threads parsing an in-memory input, 0 or 1 means "single-threaded"
+    unsigned threads;
+    // merge the entries on the fly, so the memory is proportional to the size of the result
+    // rather than to the size of the input (the input is parsed by a single thread then)
+    bool online;
+    // the memory the parsed entries may take, 0 means "unlimited"; once the merged entries
+    // exceed a half of it, they're spilled to `spill_runs` (required then) as a sorted run
+    size_t max_memory;
+    SpillRuns *spill_runs;
+    // drop the exact duplicates while parsing, NULL keeps them; the set is shared by all the
+    // inputs and the threads, and its statistics count the duplicates dropped
+    DedupSet *dedup;
+    // read the regular files by io_uring with several reads in flight instead of mapping them
+    // whenever they're parsed by a single thread (i.e. unless several threads parse the mapping
+    // in parallel); falls back to the mapping when io_uring is not available
+    bool async_io;
+    // print how every input is read, i.e. by io_uring, by a memory mapping or as a stream
+    bool debug;
+} ReaderOptions;
+
+// A sorted input read as a stream of IP ranges, see `open_sorted_reader()`
+typedef struct SortedReader SortedReader;
 
 
 /**
  * @brief Reads data from a given stream, parses it to extract CIDR blocks,
  *        and returns a ParsedData structure containing all the extracted CIDR blocks.
  *
- * This function reads the input stream line by line, and for each line,
- * it attempts to match and extract CIDR blocks using a regular expression.
- * The extracted CIDR blocks are stored in a ParsedData structure, which is returned
- * upon completion of the function. It handles potential line splits by keeping
- * any remaining part of a line in a buffer till it is fully parsed in subsequent read operations.
+ * This function reads the input stream chunk by chunk and feeds every chunk
+ * to the CIDR tokenizer. The extracted CIDR blocks are stored in a ParsedData
+ * structure, which is returned upon completion of the function. A CIDR block
+ * split between two chunks is handled by the tokenizer, which keeps its state
+ * till the next chunk is read.
+ *
+ * Unless the buffer size is given in the options, it is derived from the
+ * preferred I/O block size of the stream or the capacity of the pipe.
+ *
+ * If more than one thread is requested, one thread reads the stream into blocks
+ * (DEFAULT_READ_BUFFER_SIZE bytes unless the buffer size is given) and the other
+ * threads parse them, so reading and parsing overlap.
+ *
+ * In the online mode, the list is a set of the merged ranges followed by the
+ * entries parsed since the last merge. Once there are at least ONLINE_STAGING_SIZE
+ * such entries, and at least as many as the merged ranges, they're merged into
+ * the set. Thus, the list never grows much beyond twice the size of the result.
+ *
+ * With the memory limit, the entries are merged the same way once they reach
+ * the limit, and if the merged ranges still take more than a half of it, they
+ * go to a temporary file as a sorted run, leaving the list empty. The caller
+ * merges the runs with the list at the end (see `merge_range_streams()`).
  *
  * @param stream The input file stream to read data from.
+ * @param options Reading options or NULL to use the defaults.
  * @return ParsedData structure containing all the parsed CIDR blocks.
  *
  * @note If memory allocation fails, the function prints an error message and exits the program.
  */
-ipRangeList *read_from_stream(FILE *stream);
+ipRangeList *read_from_stream(FILE *stream, const ReaderOptions *options);
 
 
 /**
@@ -47,22 +103,114 @@ ipRangeList *read_from_stream(FILE *stream);
  * from the standard input and parse it. It returns a ParsedData
  * structure containing the results.
  *
+ * @param options Reading options or NULL to use the defaults.
  * @return A ParsedData structure containing the parsed CIDR blocks and their
  *         count.
  */
-ipRangeList *read_from_stdin();
+ipRangeList *read_from_stdin(const ReaderOptions *options);
 
 
 /**
- * Reads and parses data from standard input (stdin).
+ * @brief Parses CIDR blocks from a memory buffer.
  *
- * This function utilizes the read_from_stream function to read data
- * from the standard input and parse it. It returns a ParsedData
- * structure containing the results.
+ * This function feeds the whole buffer to the CIDR tokenizer at once, so
+ * there's neither copying nor carrying a split CIDR over between chunks.
  *
- * @return A ParsedData structure containing the parsed CIDR blocks and their
- *         count.
+ * If more than one thread is requested, the buffer is cut into chunks aligned
+ * to whitespace symbols, each chunk is parsed by its own thread into its own
+ * list, and the lists are concatenated at the end.
+ *
+ * In the online mode or with the memory limit, the buffer is parsed by a single
+ * thread, slice by slice, merging and spilling the parsed entries as
+ * `read_from_stream()` does.
+ *
+ * @param content The buffer to be parsed. It doesn't have to be NUL-terminated.
+ * @param length The length of the buffer in bytes.
+ * @param options Reading options or NULL to use the defaults.
+ * @return ParsedData structure containing all the parsed CIDR blocks.
+ *
+ * @note If memory allocation fails, the function prints an error message and exits the program.
+ */
+ipRangeList *read_from_memory(const char *content, size_t length, const ReaderOptions *options);
+
+
+/**
+ * Reads the content of a file specified by 'filename' and parses its data.
+ *
+ * Regular files are memory-mapped and parsed in place, all the other files
+ * (e.g. named pipes or character devices) are processed by 'read_from_stream'.
+ * With the `async_io` option, the regular files which are parsed by a single
+ * thread anyway (one thread, the online mode or the memory limit) are read by
+ * io_uring with several reads in flight instead, if it's available.
+ *
+ * @param filename The name of the file to be read.
+ * @param options Reading options or NULL to use the defaults.
+ * @return ParsedData struct containing the parsed data from the file.
+ *
+ * @note If the file cannot be opened, the function prints an error message
+ *       and exits the program with a failure status.
+ */
+ipRangeList *read_from_file(const char *filename, const ReaderOptions *options);
+
+
+
+/**
+ * @brief Reads and parses several files as a single input.
+ *
+ * Every file is read by `read_from_file()`, and the lists are concatenated. In
+ * the online mode or with the memory limit, the concatenated list is merged and
+ * spilled as if the files were one stream.
+ *
+ * @param filenames The names of the files to be read.
+ * @param count The number of the files (at least 1).
+ * @param options Reading options or NULL to use the defaults.
+ * @return ParsedData struct containing the parsed data from all the files.
+ *
+ * @note If a file cannot be opened, the function prints an error message
+ *       and exits the program with a failure status.
+ */
+ipRangeList *read_from_files(const char **filenames, size_t count, const ReaderOptions *options);
+
+
+/**
+ * @brief Opens a sorted input as a stream of IP ranges.
+ *
+ * The input is read and parsed chunk by chunk, so the memory is bounded by the
+ * size of the read buffer no matter how large the input is. The ranges must go
+ * in the ascending order of their start addresses (e.g. the output of merge-ip
+ * itself), which is checked while they're read.
+ *
+ * @param stream The input stream. It stays open when the reader is closed.
+ * @param name The name of the input used in the error messages.
+ * @param options Reading options or NULL to use the defaults.
+ * @return A pointer to the new reader.
+ *
+ * @note If memory allocation fails, the function prints an error message and exits the program.
+ */
+SortedReader *open_sorted_reader(FILE *stream, const char *name, const ReaderOptions *options);
+
+
+/**
+ * @brief Reads the next range of a sorted input.
+ *
+ * The ranges and the hosts of the parsed chunk are interleaved by their start
+ * addresses, and the next chunk is parsed once both of them are exhausted.
+ *
+ * @param reader A pointer to the SortedReader.
+ * @param range A pointer to store the range.
+ * @return true if the range is read; false at the end of the input.
+ *
+ * @note If the input isn't sorted, the function prints an error message and
+ *       exits the program.
+ */
+bool next_sorted_range(void *reader, ipRange *range);
+
+
+/**
+ * @brief Releases the reader. The stream stays open.
+ *
+ * @param reader A pointer to the reader.
  */
-ipRangeList *read_from_file(const char *filename);
+void close_sorted_reader(SortedReader *reader);
 
 #endif //MERGE_IP_READER_H
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+
+#include "scanner.h"
+#include "bits.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+    #define SCANNER_SSE2
+    #include <emmintrin.h>
+    // AVX2 is detected at runtime, so the binary still works on older CPUs
+    #if defined(__GNUC__) || defined(__clang__)
+        #define SCANNER_AVX2
+        #include <immintrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SCANNER_NEON
+    #include <arm_neon.h>
+#endif
+
+
+static size_t scan_scalar(const char *content, size_t position, const size_t length, const uint64_t target) {
+    const bool find_space = target == FIND_SPACE;
+    while (position < length && is_space(content[position]) != find_space) {
+        position++;
+    }
+    return position;
+}
+
+static const Scanner SCALAR_SCANNER = {"scalar", scan_scalar, NULL};
+
+
+#ifdef SCANNER_SSE2
+// sets the lanes which are in `[first, first + range]`, comparing them as unsigned `byte - first <= range`
+static inline __m128i in_range_sse2(const __m128i bytes, const char first, const char range) {
+    const __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(first));
+    return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(range)), shifted);
+}
+
+static inline __m128i is_space_sse2(const __m128i bytes) {
+    return _mm_or_si128(in_range_sse2(bytes, '\t', '\r' - '\t'), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+}
+
+/**
+ * @brief Classifies SCAN_BLOCK_SIZE bytes at once.
+ *
+ * @param block The pointer to the bytes to be classified. Doesn't have to be aligned.
+ * @return A bitmask where n-th bit is set if n-th byte is a whitespace.
+ */
+static inline uint64_t space_mask_sse2(const char *block) {
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < SCAN_BLOCK_SIZE / 16; i++) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i *)(const void *)(block + 16 * i));
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(is_space_sse2(bytes)) << (16 * i);
+    }
+
+    return mask;
+}
+
+static void classify_sse2(const char *block, ByteClasses *classes) {
+    *classes = (ByteClasses){0, 0, 0, 0};
+    for (unsigned i = 0; i < SCAN_BLOCK_SIZE / 16; i++) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i *)(const void *)(block + 16 * i));
+        const unsigned shift = 16 * i;
+        classes->spaces |= (uint64_t)(uint16_t)_mm_movemask_epi8(is_space_sse2(bytes)) << shift;
+        classes->symbols |= (uint64_t)(uint16_t)_mm_movemask_epi8(in_range_sse2(bytes, '.', '9' - '.')) << shift;
+        classes->dots |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('.'))) << shift;
+        classes->slashes |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('/'))) << shift;
+    }
+}
+
+static size_t scan_sse2(const char *content, size_t position, const size_t length, const uint64_t target) {
+    while (length - position >= SCAN_BLOCK_SIZE) {
+        const uint64_t matches = space_mask_sse2(content + position) ^ target;
+        if (matches) {
+            return position + count_trailing_zeros64(matches);
+        }
+        position += SCAN_BLOCK_SIZE;
+    }
+    return scan_scalar(content, position, length, target);
+}
+
+static const Scanner SSE2_SCANNER = {"SSE2", scan_sse2, classify_sse2};
+#endif
+
+
+#ifdef SCANNER_AVX2
+__attribute__((target("avx2")))
+static inline __m256i in_range_avx2(const __m256i bytes, const char first, const char range) {
+    const __m256i shifted = _mm256_sub_epi8(bytes, _mm256_set1_epi8(first));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(range)), shifted);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i is_space_avx2(const __m256i bytes) {
+    return _mm256_or_si256(in_range_avx2(bytes, '\t', '\r' - '\t'), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')));
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t space_mask_avx2(const char *block) {
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < SCAN_BLOCK_SIZE / 32; i++) {
+        const __m256i bytes = _mm256_loadu_si256((const __m256i *)(const void *)(block + 32 * i));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(is_space_avx2(bytes)) << (32 * i);
+    }
+
+    return mask;
+}
+
+__attribute__((target("avx2")))
+static void classify_avx2(const char *block, ByteClasses *classes) {
+    *classes = (ByteClasses){0, 0, 0, 0};
+    for (unsigned i = 0; i < SCAN_BLOCK_SIZE / 32; i++) {
+        const __m256i bytes = _mm256_loadu_si256((const __m256i *)(const void *)(block + 32 * i));
+        const unsigned shift = 32 * i;
+        classes->spaces |= (uint64_t)(uint32_t)_mm256_movemask_epi8(is_space_avx2(bytes)) << shift;
+        classes->symbols |= (uint64_t)(uint32_t)_mm256_movemask_epi8(in_range_avx2(bytes, '.', '9' - '.')) << shift;
+        classes->dots |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('.'))) << shift;
+        classes->slashes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('/'))) << shift;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *content, size_t position, const size_t length, const uint64_t target) {
+    while (length - position >= SCAN_BLOCK_SIZE) {
+        const uint64_t matches = space_mask_avx2(content + position) ^ target;
+        if (matches) {
+            return position + count_trailing_zeros64(matches);
+        }
+        position += SCAN_BLOCK_SIZE;
+    }
+    return scan_scalar(content, position, length, target);
+}
+
+static const Scanner AVX2_SCANNER = {"AVX2", scan_avx2, classify_avx2};
+#endif
+
+
+#ifdef SCANNER_NEON
+// NEON has no `movemask`, so every lane keeps its own bit and lanes are summed up
+static inline uint64_t movemask_neon(const uint8x16_t lanes) {
+    static const uint8_t BIT_WEIGHTS[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(lanes, vld1q_u8(BIT_WEIGHTS));
+    const uint64_t low = vaddv_u8(vget_low_u8(bits));
+    const uint64_t high = vaddv_u8(vget_high_u8(bits));
+    return low | high << 8;
+}
+
+static inline uint8x16_t is_space_neon(const uint8x16_t bytes) {
+    const uint8x16_t is_control = vcleq_u8(vsubq_u8(bytes, vdupq_n_u8('\t')), vdupq_n_u8('\r' - '\t'));
+    return vorrq_u8(is_control, vceqq_u8(bytes, vdupq_n_u8(' ')));
+}
+
+static inline uint64_t space_mask_neon(const char *block) {
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < SCAN_BLOCK_SIZE / 16; i++) {
+        const uint8x16_t bytes = vld1q_u8((const uint8_t *)block + 16 * i);
+        mask |= movemask_neon(is_space_neon(bytes)) << (16 * i);
+    }
+
+    return mask;
+}
+
+static void classify_neon(const char *block, ByteClasses *classes) {
+    *classes = (ByteClasses){0, 0, 0, 0};
+    for (unsigned i = 0; i < SCAN_BLOCK_SIZE / 16; i++) {
+        const uint8x16_t bytes = vld1q_u8((const uint8_t *)block + 16 * i);
+        const uint8x16_t is_symbol = vcleq_u8(vsubq_u8(bytes, vdupq_n_u8('.')), vdupq_n_u8('9' - '.'));
+        const unsigned shift = 16 * i;
+        classes->spaces |= movemask_neon(is_space_neon(bytes)) << shift;
+        classes->symbols |= movemask_neon(is_symbol) << shift;
+        classes->dots |= movemask_neon(vceqq_u8(bytes, vdupq_n_u8('.'))) << shift;
+        classes->slashes |= movemask_neon(vceqq_u8(bytes, vdupq_n_u8('/'))) << shift;
+    }
+}
+
+static size_t scan_neon(const char *content, size_t position, const size_t length, const uint64_t target) {
+    while (length - position >= SCAN_BLOCK_SIZE) {
+        const uint64_t matches = space_mask_neon(content + position) ^ target;
+        if (matches) {
+            return position + count_trailing_zeros64(matches);
+        }
+        position += SCAN_BLOCK_SIZE;
+    }
+    return scan_scalar(content, position, length, target);
+}
+
+static const Scanner NEON_SCANNER = {"NEON", scan_neon, classify_neon};
+#endif
+
+
+/**
+ * @brief Returns the fastest scanner supported by the current CPU.
+ *
+ * The scanner is selected at runtime: AVX2 or SSE2 on x86, NEON on ARM64, and the
+ * portable scalar implementation (e.g. for MIPS builds) otherwise.
+ *
+ * @return A pointer to the statically allocated scanner.
+ */
+const Scanner *get_scanner(void) {
+#if defined(SCANNER_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        return &AVX2_SCANNER;
+    }
+#endif
+#if defined(SCANNER_SSE2)
+    return &SSE2_SCANNER;
+#elif defined(SCANNER_NEON)
+    return &NEON_SCANNER;
+#else
+    return &SCALAR_SCANNER;
+#endif
+}
+
+
+/**
+ * @brief Returns the portable byte-by-byte scanner.
+ *
+ * @return A pointer to the statically allocated scanner.
+ */
+const Scanner *get_scalar_scanner(void) {
+    return &SCALAR_SCANNER;
+}
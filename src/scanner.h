@@ -0,0 +1,100 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_SCANNER_H
+#define MERGE_IP_SCANNER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// number of bytes classified at once by a vectorized scanner
+#define SCAN_BLOCK_SIZE 64
+
+// what the scanner is looking for
+#define FIND_SPACE ((uint64_t)0)      // the end of a token
+#define FIND_NON_SPACE (~(uint64_t)0) // the start of a token
+
+
+/**
+ * @brief Finds the first byte which is (or is not) a whitespace symbol.
+ *
+ * @param content The input to be scanned.
+ * @param position The offset to start scanning from.
+ * @param length The length of the input in bytes.
+ * @param target Either FIND_SPACE or FIND_NON_SPACE.
+ *
+ * @return The offset of the first matching byte or `length` if there's no such byte.
+ */
+typedef size_t (*ScanFunction)(const char *content, size_t position, size_t length, uint64_t target);
+
+
+// The classes of SCAN_BLOCK_SIZE bytes: n-th bit of every mask stands for n-th byte
+typedef struct {
+    uint64_t spaces;   // `[ \t\n\r\v\f]`
+    uint64_t symbols;  // `[./0-9]`, i.e. the bytes a CIDR is made of
+    uint64_t dots;
+    uint64_t slashes;
+} ByteClasses;
+
+
+/**
+ * @brief Classifies SCAN_BLOCK_SIZE bytes at once.
+ *
+ * @param block The bytes to be classified. Doesn't have to be aligned.
+ * @param classes A pointer to store the masks of the classes.
+ */
+typedef void (*ClassifyFunction)(const char *block, ByteClasses *classes);
+
+
+typedef struct {
+    const char *name;
+    ScanFunction scan;
+    ClassifyFunction classify; // NULL if the bytes can't be classified faster than one by one
+} Scanner;
+
+
+/**
+ * @brief Checks if the symbol is one of `[ \t\n\r\v\f]`.
+ *
+ * @param symbol The symbol to check.
+ * @return true if the symbol is a whitespace; false otherwise.
+ */
+static inline bool is_space(const char symbol) {
+    const uint8_t code = (uint8_t)symbol;
+    return code == ' ' || (uint8_t)(code - '\t') <= '\r' - '\t';
+}
+
+
+/**
+ * @brief Returns the fastest scanner supported by the current CPU.
+ *
+ * The scanner is selected at runtime: AVX2 or SSE2 on x86, NEON on ARM64, and the
+ * portable scalar implementation (e.g. for MIPS builds) otherwise.
+ *
+ * @return A pointer to the statically allocated scanner.
+ */
+const Scanner *get_scanner(void);
+
+
+/**
+ * @brief Returns the portable byte-by-byte scanner.
+ *
+ * @return A pointer to the statically allocated scanner.
+ */
+const Scanner *get_scalar_scanner(void);
+
+#endif //MERGE_IP_SCANNER_H
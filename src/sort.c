@@ -0,0 +1,620 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bits.h"
+#include "parallel.h"
+#include "sort.h"
+
+
+// every address is split into 11 + 11 + 10 bits digits
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+#define DIGITS_PER_ADDRESS 3
+// the least significant digits go first: max_ip is the secondary key, min_ip is the primary one
+#define RADIX_PASSES (2 * DIGITS_PER_ADDRESS)
+
+// the parallel sort splits the input into partitions by the highest bits of min_ip
+#define PARTITION_BITS 8
+#define PARTITION_COUNT (1 << PARTITION_BITS)
+#define ALL_BITS 0xFFFFFFFF
+
+
+/**
+ * @brief Compares two `ipRange` structures for sorting.
+ *
+ * This function is used to compare two `ipRange` structures, which contain
+ * a minimum and a maximum IP address. The comparison is primarily based on
+ * the `min_ip` field. If the `min_ip` values are equal, it compares the
+ * `max_ip` values.
+ *
+ * @param a Pointer to the first `ipRange` structure.
+ * @param b Pointer to the second `ipRange` structure.
+ * @return An integer less than, equal to, or greater than zero if the `min_ip`
+ *         of `a` is found, respectively, to be less than, equal to, or greater
+ *         than the `min_ip` of `b`. If `min_ip` values are equal, the comparison
+ *         is based on the `max_ip` values.
+ */
+int compare_ip_ranges(const void *a, const void *b) {
+    const ipRange *rangeA = (ipRange *)a;
+    const ipRange *rangeB = (ipRange *)b;
+
+    // first compare min_ip
+    if (rangeA->min_ip.s_addr < rangeB->min_ip.s_addr) return -1;
+    if (rangeA->min_ip.s_addr > rangeB->min_ip.s_addr) return 1;
+
+    // now - max_ip
+    if (rangeA->max_ip.s_addr < rangeB->max_ip.s_addr) return -1;
+    if (rangeA->max_ip.s_addr > rangeB->max_ip.s_addr) return 1;
+
+    return 0; // they are equal
+}
+
+
+/**
+ * @brief Compares two host addresses (`uint32_t`) for sorting.
+ *
+ * @param a Pointer to the first address.
+ * @param b Pointer to the second address.
+ * @return An integer less than, equal to, or greater than zero if `a` is found,
+ *         respectively, to be less than, equal to, or greater than `b`.
+ */
+int compare_ip_hosts(const void *a, const void *b) {
+    const uint32_t hostA = *(const uint32_t *)a;
+    const uint32_t hostB = *(const uint32_t *)b;
+    return (hostA > hostB) - (hostA < hostB);
+}
+
+
+/**
+ * @brief Returns the radix digit of the range used by the given pass.
+ *
+ * @param range The IP range.
+ * @param pass The number of the pass (0 is the least significant digit of `max_ip`).
+ * @return The digit, in the range [0, RADIX_SIZE).
+ */
+static inline uint32_t get_digit(const ipRange *range, const unsigned pass) {
+    const uint32_t address = pass < DIGITS_PER_ADDRESS ? range->max_ip.s_addr : range->min_ip.s_addr;
+    return (address >> (pass % DIGITS_PER_ADDRESS * RADIX_BITS)) & RADIX_MASK;
+}
+
+
+/**
+ * @brief Sorts a short array of IP ranges by insertion.
+ *
+ * @param ranges The array of IP ranges to be sorted in place.
+ * @param length The number of elements in the array.
+ */
+static void insertion_sort(ipRange *ranges, const size_t length) {
+    for (size_t i = 1; i < length; i++) {
+        const ipRange current = ranges[i];
+        size_t j = i;
+
+        while (j > 0 && compare_ip_ranges(&ranges[j - 1], &current) > 0) {
+            ranges[j] = ranges[j - 1];
+            j--;
+        }
+        ranges[j] = current;
+    }
+}
+
+
+/**
+ * @brief Sorts IP ranges with an LSD radix sort.
+ *
+ * The passes ping-pong between the two buffers, so the sorted array ends up
+ * in either of them.
+ *
+ * @param source The array of IP ranges to be sorted.
+ * @param scratch The scratch buffer of the same length.
+ * @param length The number of elements in the arrays.
+ * @return The buffer which holds the sorted array (either `source` or `scratch`).
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+static ipRange *radix_sort(ipRange *source, ipRange *scratch, const size_t length) {
+    if (length < SMALL_SORT_THRESHOLD) {
+        insertion_sort(source, length);
+        return source;
+    }
+
+    size_t (*histograms)[RADIX_SIZE] = calloc(RADIX_PASSES, sizeof(*histograms));
+    if (!histograms) {
+        perror("Failed to allocate radix sort histograms");
+        exit(EXIT_FAILURE);
+    }
+
+    // a single read of the input is enough to build the histograms of all the passes
+    for (size_t i = 0; i < length; i++) {
+        for (unsigned pass = 0; pass < RADIX_PASSES; pass++) {
+            histograms[pass][get_digit(&source[i], pass)]++;
+        }
+    }
+
+    ipRange *target = scratch;
+
+    for (unsigned pass = 0; pass < RADIX_PASSES; pass++) {
+        size_t *histogram = histograms[pass];
+
+        // all the keys share the same digit, so this pass wouldn't change the order
+        if (histogram[get_digit(&source[0], pass)] == length) {
+            continue;
+        }
+
+        // turn the counts into the starting offsets of the buckets
+        size_t offset = 0;
+        for (size_t digit = 0; digit < RADIX_SIZE; digit++) {
+            const size_t count = histogram[digit];
+            histogram[digit] = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            target[histogram[get_digit(&source[i], pass)]++] = source[i];
+        }
+
+        ipRange *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    free(histograms);
+    return source;
+}
+
+
+/**
+ * @brief Sorts IP ranges in ascending order of (`min_ip`, `max_ip`).
+ *
+ * This function uses an LSD radix sort over the 64-bit key made of `min_ip`
+ * and `max_ip` (six passes of 11, 11 and 10 bits per address). Passes where
+ * all the keys fall into the same bucket are skipped. Short arrays are sorted
+ * by insertion.
+ *
+ * @param ranges The array of IP ranges to be sorted in place.
+ * @param length The number of elements in the array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void sort_ip_ranges(ipRange *ranges, const size_t length) {
+    if (length < SMALL_SORT_THRESHOLD) {
+        insertion_sort(ranges, length);
+        return;
+    }
+
+    // the scratch buffer shares the allocation policy of the lists (huge pages for big inputs)
+    ipRangeList *scratch = getIpRangeList(length);
+
+    const ipRange *sorted = radix_sort(ranges, scratch->cidrs, length);
+    if (sorted != ranges) {
+        memcpy(ranges, sorted, length * sizeof(ipRange));
+    }
+
+    freeIpRangeList(scratch);
+}
+
+
+/**
+ * @brief Sorts host addresses in ascending order.
+ *
+ * This function uses the same LSD radix sort as `sort_ip_ranges()`, but over
+ * a 32-bit key, i.e. in three passes at most. The hosts which are in order
+ * already (e.g. the ones of the output of the previous run) are left as they
+ * are after a single pass over them.
+ *
+ * @param hosts The array of addresses to be sorted in place.
+ * @param length The number of elements in the array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void sort_ip_hosts(uint32_t *hosts, const size_t length) {
+    if (length < SMALL_SORT_THRESHOLD) {
+        for (size_t i = 1; i < length; i++) {
+            const uint32_t current = hosts[i];
+            size_t j = i;
+            while (j > 0 && hosts[j - 1] > current) {
+                hosts[j] = hosts[j - 1];
+                j--;
+            }
+            hosts[j] = current;
+        }
+        return;
+    }
+
+    // the first out of order host is usually met right away unless they're all in order
+    size_t ordered = 1;
+    while (ordered < length && hosts[ordered - 1] <= hosts[ordered]) {
+        ordered++;
+    }
+    if (ordered == length) {
+        return;
+    }
+
+    size_t (*histograms)[RADIX_SIZE] = calloc(DIGITS_PER_ADDRESS, sizeof(*histograms));
+    if (!histograms) {
+        perror("Failed to allocate radix sort histograms");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        for (unsigned pass = 0; pass < DIGITS_PER_ADDRESS; pass++) {
+            histograms[pass][(hosts[i] >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+        }
+    }
+
+    ipRangeList *scratch = getIpRangeList(0);
+    reserveIpHosts(scratch, length);
+    uint32_t *source = hosts;
+    uint32_t *target = scratch->hosts;
+
+    for (unsigned pass = 0; pass < DIGITS_PER_ADDRESS; pass++) {
+        size_t *histogram = histograms[pass];
+        const unsigned shift = pass * RADIX_BITS;
+
+        // all the keys share the same digit, so this pass wouldn't change the order
+        if (histogram[(source[0] >> shift) & RADIX_MASK] == length) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < RADIX_SIZE; digit++) {
+            const size_t count = histogram[digit];
+            histogram[digit] = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            target[histogram[(source[i] >> shift) & RADIX_MASK]++] = source[i];
+        }
+
+        uint32_t *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != hosts) {
+        memcpy(hosts, source, length * sizeof(uint32_t));
+    }
+
+    freeIpRangeList(scratch);
+    free(histograms);
+}
+
+
+// The state shared by all the workers of the parallel sort. Every worker owns a
+// contiguous slice of the input and a row of the `offsets` table.
+typedef struct {
+    ipRange *ranges;
+    ipRange *scratch;
+    size_t length;
+    size_t threads;
+    unsigned shift;           // min_ip >> shift gives the partition of the range
+    size_t (*offsets)[PARTITION_COUNT];
+    size_t *partition_starts; // PARTITION_COUNT + 1 elements
+} ParallelSort;
+
+typedef struct {
+    ParallelSort *sort;
+    size_t index;
+    uint32_t min_ip_and;
+    uint32_t min_ip_or;
+} SortTask;
+
+
+static inline size_t get_partition(const ipRange *range, const unsigned shift) {
+    return (range->min_ip.s_addr >> shift) & (PARTITION_COUNT - 1);
+}
+
+
+static size_t get_slice_start(const ParallelSort *sort, const size_t index) {
+    return sort->length / sort->threads * index;
+}
+
+
+static size_t get_slice_end(const ParallelSort *sort, const size_t index) {
+    return index + 1 == sort->threads ? sort->length : get_slice_start(sort, index + 1);
+}
+
+
+// collects the bits which are common for `min_ip` of all the ranges in the slice
+static void find_common_bits(void *argument) {
+    SortTask *task = argument;
+    const ParallelSort *sort = task->sort;
+    uint32_t all_ones = ALL_BITS;
+    uint32_t any_ones = 0;
+
+    for (size_t i = get_slice_start(sort, task->index); i < get_slice_end(sort, task->index); i++) {
+        all_ones &= sort->ranges[i].min_ip.s_addr;
+        any_ones |= sort->ranges[i].min_ip.s_addr;
+    }
+
+    task->min_ip_and = all_ones;
+    task->min_ip_or = any_ones;
+}
+
+
+static void count_partitions(void *argument) {
+    const SortTask *task = argument;
+    const ParallelSort *sort = task->sort;
+    size_t *counts = sort->offsets[task->index];
+
+    for (size_t i = get_slice_start(sort, task->index); i < get_slice_end(sort, task->index); i++) {
+        counts[get_partition(&sort->ranges[i], sort->shift)]++;
+    }
+}
+
+
+static void scatter_partitions(void *argument) {
+    const SortTask *task = argument;
+    const ParallelSort *sort = task->sort;
+    size_t *offsets = sort->offsets[task->index];
+
+    for (size_t i = get_slice_start(sort, task->index); i < get_slice_end(sort, task->index); i++) {
+        sort->scratch[offsets[get_partition(&sort->ranges[i], sort->shift)]++] = sort->ranges[i];
+    }
+}
+
+
+// sorts the partitions assigned to the worker and puts them back to `ranges`
+static void sort_partitions(void *argument) {
+    const SortTask *task = argument;
+    const ParallelSort *sort = task->sort;
+    // the partitions are assigned so that every worker gets about the same number of ranges
+    const size_t lower = get_slice_start(sort, task->index);
+    const size_t upper = get_slice_end(sort, task->index);
+
+    for (size_t partition = 0; partition < PARTITION_COUNT; partition++) {
+        const size_t start = sort->partition_starts[partition];
+        const size_t end = sort->partition_starts[partition + 1];
+        // a partition belongs to the worker whose slice contains the partition's first element
+        if (start == end || start < lower || start >= upper) {
+            continue;
+        }
+
+        const ipRange *sorted = radix_sort(sort->scratch + start, sort->ranges + start, end - start);
+        if (sorted != sort->ranges + start) {
+            memcpy(sort->ranges + start, sorted, (end - start) * sizeof(ipRange));
+        }
+    }
+}
+
+
+/**
+ * @brief Sorts IP ranges in ascending order of (`min_ip`, `max_ip`) using several threads.
+ *
+ * The ranges are partitioned by the highest bits in which their `min_ip` differ
+ * (an MSD radix pass, where every thread counts and scatters its own slice of the
+ * input). The partitions are then sorted independently by `sort_ip_ranges()`'s
+ * radix sort. The result is the same as the one of `sort_ip_ranges()`.
+ *
+ * @param ranges The array of IP ranges to be sorted in place.
+ * @param length The number of elements in the array.
+ * @param threads The number of threads to use.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void sort_ip_ranges_in_parallel(ipRange *ranges, const size_t length, const unsigned threads) {
+    if (threads <= 1 || length < MIN_PARALLEL_SORT_SIZE) {
+        sort_ip_ranges(ranges, length);
+        return;
+    }
+
+    ParallelSort sort = {.ranges = ranges, .length = length, .threads = threads};
+    SortTask *tasks = calloc(threads, sizeof(SortTask));
+    if (!tasks) {
+        perror("Failed to allocate sort tasks");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        tasks[i].sort = &sort;
+        tasks[i].index = i;
+    }
+
+    run_in_parallel(find_common_bits, tasks, sizeof(SortTask), threads);
+    uint32_t all_ones = ALL_BITS;
+    uint32_t any_ones = 0;
+    for (size_t i = 0; i < threads; i++) {
+        all_ones &= tasks[i].min_ip_and;
+        any_ones |= tasks[i].min_ip_or;
+    }
+
+    const uint32_t distinct_bits = all_ones ^ any_ones;
+    if (distinct_bits == 0) {
+        // all the ranges start at the same address, there's nothing to partition
+        free(tasks);
+        sort_ip_ranges(ranges, length);
+        return;
+    }
+
+    // partition by the PARTITION_BITS highest bits which aren't the same for all the ranges
+    const unsigned highest_bit = 31 - count_leading_zeros32(distinct_bits);
+    sort.shift = highest_bit + 1 < PARTITION_BITS ? 0 : highest_bit + 1 - PARTITION_BITS;
+
+    sort.offsets = calloc(threads, sizeof(*sort.offsets));
+    sort.partition_starts = calloc(PARTITION_COUNT + 1, sizeof(size_t));
+    ipRangeList *scratch = getIpRangeList(length);
+    sort.scratch = scratch->cidrs;
+    if (!sort.offsets || !sort.partition_starts) {
+        perror("Failed to allocate sort partitions");
+        exit(EXIT_FAILURE);
+    }
+
+    run_in_parallel(count_partitions, tasks, sizeof(SortTask), threads);
+
+    // every worker scatters its slice right after the same partition of the previous workers,
+    // so the order of the equal keys is preserved
+    size_t offset = 0;
+    for (size_t partition = 0; partition < PARTITION_COUNT; partition++) {
+        sort.partition_starts[partition] = offset;
+        for (size_t i = 0; i < threads; i++) {
+            const size_t count = sort.offsets[i][partition];
+            sort.offsets[i][partition] = offset;
+            offset += count;
+        }
+    }
+    sort.partition_starts[PARTITION_COUNT] = offset;
+
+    run_in_parallel(scatter_partitions, tasks, sizeof(SortTask), threads);
+    run_in_parallel(sort_partitions, tasks, sizeof(SortTask), threads);
+
+    freeIpRangeList(scratch);
+    free(sort.partition_starts);
+    free(sort.offsets);
+    free(tasks);
+}
+
+
+/**
+ * @brief Finds out how far the IP ranges are from being sorted.
+ *
+ * This function counts the ascending runs of the array in a single pass. It stops
+ * as soon as there are more than `max_runs` runs, so a shuffled input costs
+ * only a few comparisons.
+ *
+ * @param ranges The array of IP ranges.
+ * @param length The number of elements in the array.
+ * @param max_runs The number of runs after which the scan stops.
+ * @return The number of runs (at most `max_runs + 1`) and whether the ranges are canonical.
+ */
+RangeOrder scan_ip_range_order(const ipRange *ranges, const size_t length, const size_t max_runs) {
+    RangeOrder order = {.runs = length ? 1 : 0, .canonical = true};
+
+    for (size_t i = 1; i < length && order.runs <= max_runs; i++) {
+        const ipRange *previous = &ranges[i - 1];
+
+        if (compare_ip_ranges(previous, &ranges[i]) > 0) {
+            order.runs++;
+            order.canonical = false;
+        } else if (order.canonical) {
+            // a gap of at least one address is required between the canonical ranges
+            order.canonical = previous->max_ip.s_addr != ALL_BITS
+                              && ranges[i].min_ip.s_addr > previous->max_ip.s_addr + 1;
+        }
+    }
+
+    return order;
+}
+
+
+/**
+ * @brief Merges two neighbouring sorted runs.
+ *
+ * @param left The first run.
+ * @param middle The end of the first run and the beginning of the second one.
+ * @param right The end of the second run.
+ * @param target The buffer to write the merged run to.
+ */
+static void merge_runs(const ipRange *left, const ipRange *middle, const ipRange *right, ipRange *target) {
+    const ipRange *second = middle;
+
+    while (left < middle && second < right) {
+        // take from the first run on ties to keep the merge stable
+        *target++ = compare_ip_ranges(second, left) < 0 ? *second++ : *left++;
+    }
+
+    memcpy(target, left, (size_t)(middle - left) * sizeof(ipRange));
+    target += middle - left;
+    memcpy(target, second, (size_t)(right - second) * sizeof(ipRange));
+}
+
+
+/**
+ * @brief Sorts IP ranges which consist of a few ascending runs.
+ *
+ * This function merges the neighbouring runs pairwise until a single run is left,
+ * so it takes log2(runs) passes over the array.
+ *
+ * @param ranges The array of IP ranges to be sorted in place.
+ * @param length The number of elements in the array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void merge_sorted_runs(ipRange *ranges, const size_t length) {
+    // the boundaries of the runs: the run `i` is [bounds[i], bounds[i + 1])
+    size_t capacity = MAX_NATURAL_RUNS + 1;
+    size_t *bounds = malloc(capacity * sizeof(size_t));
+    if (!bounds) {
+        perror("Failed to allocate sorted runs");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t runs = 0;
+    bounds[0] = 0;
+    for (size_t i = 1; i <= length; i++) {
+        if (i < length && compare_ip_ranges(&ranges[i - 1], &ranges[i]) <= 0) {
+            continue;
+        }
+        if (runs + 2 > capacity) {
+            capacity *= 2;
+            size_t *expanded = realloc(bounds, capacity * sizeof(size_t));
+            if (!expanded) {
+                perror("Failed to allocate sorted runs");
+                exit(EXIT_FAILURE);
+            }
+            bounds = expanded;
+        }
+        bounds[++runs] = i;
+    }
+
+    if (runs <= 1) {
+        free(bounds);
+        return;
+    }
+
+    ipRangeList *scratch = getIpRangeList(length);
+    ipRange *source = ranges;
+    ipRange *target = scratch->cidrs;
+
+    while (runs > 1) {
+        size_t merged_runs = 0;
+
+        for (size_t run = 0; run < runs; run += 2) {
+            if (run + 1 < runs) {
+                merge_runs(source + bounds[run], source + bounds[run + 1], source + bounds[run + 2],
+                           target + bounds[run]);
+            } else {
+                // the odd run has no pair in this pass
+                memcpy(target + bounds[run], source + bounds[run],
+                       (bounds[run + 1] - bounds[run]) * sizeof(ipRange));
+            }
+            bounds[merged_runs++] = bounds[run];
+        }
+        bounds[merged_runs] = length;
+        runs = merged_runs;
+
+        ipRange *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != ranges) {
+        memcpy(ranges, source, length * sizeof(ipRange));
+    }
+
+    freeIpRangeList(scratch);
+    free(bounds);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_SORT_H
+#define MERGE_IP_SORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ipRange.h"
+
+// arrays shorter than this are sorted by insertion
+#define SMALL_SORT_THRESHOLD 64
+// arrays shorter than this are not worth sorting in parallel
+#define MIN_PARALLEL_SORT_SIZE (64 * 1024)
+// inputs made of up to this number of ascending runs are merged rather than sorted
+#define MAX_NATURAL_RUNS 16
+
+
+// The order of the ranges found by `scan_ip_range_order()`
+typedef struct {
+    size_t runs;    // the number of ascending runs, 0 for an empty array
+    bool canonical; // the ranges are sorted, disjoint and not adjacent, i.e. nothing to merge
+} RangeOrder;
+
+
+/**
+ * @brief Compares two `ipRange` structures for sorting.
+ *
+ * This function is used to compare two `ipRange` structures, which contain
+ * a minimum and a maximum IP address. The comparison is primarily based on
+ * the `min_ip` field. If the `min_ip` values are equal, it compares the
+ * `max_ip` values.
+ *
+ * @param a Pointer to the first `ipRange` structure.
+ * @param b Pointer to the second `ipRange` structure.
+ * @return An integer less than, equal to, or greater than zero if the `min_ip`
+ *         of `a` is found, respectively, to be less than, equal to, or greater
+ *         than the `min_ip` of `b`. If `min_ip` values are equal, the comparison
+ *         is based on the `max_ip` values.
+ */
+int compare_ip_ranges(const void *a, const void *b);
+
+
+/**
+ * @brief Compares two host addresses (`uint32_t`) for sorting.
+ *
+ * @param a Pointer to the first address.
+ * @param b Pointer to the second address.
+ * @return An integer less than, equal to, or greater than zero if `a` is found,
+ *         respectively, to be less than, equal to, or greater than `b`.
+ */
+int compare_ip_hosts(const void *a, const void *b);
+
+
+/**
+ * @brief Sorts IP ranges in ascending order of (`min_ip`, `max_ip`).
+ *
+ * This function uses an LSD radix sort over the 64-bit key made of `min_ip`
+ * and `max_ip` (six passes of 11, 11 and 10 bits per address). Passes where
+ * all the keys fall into the same bucket are skipped. Short arrays are sorted
+ * by insertion.
+ *
+ * @param ranges The array of IP ranges to be sorted in place.
+ * @param length The number of elements in the array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void sort_ip_ranges(ipRange *ranges, size_t length);
+
+
+/**
+ * @brief Sorts host addresses in ascending order.
+ *
+ * This function uses the same LSD radix sort as `sort_ip_ranges()`, but over
+ * a 32-bit key, i.e. in three passes at most. The hosts which are in order
+ * already (e.g. the ones of the output of the previous run) are left as they
+ * are after a single pass over them.
+ *
+ * @param hosts The array of addresses to be sorted in place.
+ * @param length The number of elements in the array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void sort_ip_hosts(uint32_t *hosts, size_t length);
+
+
+/**
+ * @brief Sorts IP ranges in ascending order of (`min_ip`, `max_ip`) using several threads.
+ *
+ * The ranges are partitioned by the highest bits in which their `min_ip` differ
+ * (an MSD radix pass, where every thread counts and scatters its own slice of the
+ * input). The partitions are then sorted independently by `sort_ip_ranges()`'s
+ * radix sort. The result is the same as the one of `sort_ip_ranges()`.
+ *
+ * @param ranges The array of IP ranges to be sorted in place.
+ * @param length The number of elements in the array.
+ * @param threads The number of threads to use.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void sort_ip_ranges_in_parallel(ipRange *ranges, size_t length, unsigned threads);
+
+
+/**
+ * @brief Finds out how far the IP ranges are from being sorted.
+ *
+ * This function counts the ascending runs of the array in a single pass. It stops
+ * as soon as there are more than `max_runs` runs, so a shuffled input costs
+ * only a few comparisons.
+ *
+ * @param ranges The array of IP ranges.
+ * @param length The number of elements in the array.
+ * @param max_runs The number of runs after which the scan stops.
+ * @return The number of runs (at most `max_runs + 1`) and whether the ranges are canonical.
+ */
+RangeOrder scan_ip_range_order(const ipRange *ranges, size_t length, size_t max_runs);
+
+
+/**
+ * @brief Sorts IP ranges which consist of a few ascending runs.
+ *
+ * This function merges the neighbouring runs pairwise until a single run is left,
+ * so it takes log2(runs) passes over the array.
+ *
+ * @param ranges The array of IP ranges to be sorted in place.
+ * @param length The number of elements in the array.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void merge_sorted_runs(ipRange *ranges, size_t length);
+
+#endif //MERGE_IP_SORT_H
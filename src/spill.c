@@ -0,0 +1,333 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+#include "kway.h"
+#include "spill.h"
+
+
+// the longest LEB128 encoding of a 32-bit value
+#define MAX_VARINT_LENGTH 5
+#define SPILL_FILE_TEMPLATE "merge-ip.XXXXXX"
+
+
+static FILE *create_spill_file(void) {
+#ifdef _WIN32
+    FILE *file = tmpfile();
+#else
+    const char *directory = getenv("TMPDIR");
+    if (!directory || !*directory) {
+        directory = "/tmp";
+    }
+
+    const size_t length = strlen(directory);
+    char *name = malloc(length + sizeof("/" SPILL_FILE_TEMPLATE));
+    if (!name) {
+        perror("Failed to allocate temporary file name");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(name, directory, length);
+    memcpy(name + length, "/" SPILL_FILE_TEMPLATE, sizeof("/" SPILL_FILE_TEMPLATE));
+
+    FILE *file = NULL;
+    const int fd = mkstemp(name);
+    if (fd >= 0) {
+        // nobody else needs the name, so the file is removed as soon as it's closed
+        unlink(name);
+        file = fdopen(fd, "w+b");
+        if (!file) {
+            close(fd);
+        }
+    }
+    free(name);
+#endif
+
+    if (!file) {
+        perror("Failed to create temporary file");
+        exit(EXIT_FAILURE);
+    }
+    return file;
+}
+
+
+static inline unsigned char *put_varint(unsigned char *cursor, uint32_t value) {
+    while (value >= 0x80) {
+        *cursor++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *cursor++ = (unsigned char)value;
+    return cursor;
+}
+
+
+static void write_spill_buffer(FILE *file, const unsigned char *buffer, const size_t length) {
+    if (fwrite(buffer, 1, length, file) != length) {
+        perror("Failed to write temporary file");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+// The state of a run being written, see `start_spill_run()`
+typedef struct {
+    SpillRun run;
+    unsigned char *buffer;
+    unsigned char *cursor;
+    uint32_t previous;
+} SpillWriter;
+
+
+static void start_spill_run(SpillWriter *writer) {
+    writer->buffer = malloc(SPILL_BUFFER_SIZE);
+    if (!writer->buffer) {
+        perror("Failed to allocate spill buffer");
+        exit(EXIT_FAILURE);
+    }
+    writer->cursor = writer->buffer;
+    writer->previous = 0;
+    writer->run = (SpillRun){.file = create_spill_file()};
+}
+
+
+// the signature matches `EmitRangeFunction`, so the merged runs are written right away
+static void put_spilled_range(void *target, const ipRange *range) {
+    SpillWriter *writer = target;
+    if ((size_t)(writer->cursor - writer->buffer) > SPILL_BUFFER_SIZE - 2 * MAX_VARINT_LENGTH) {
+        write_spill_buffer(writer->run.file, writer->buffer, (size_t)(writer->cursor - writer->buffer));
+        writer->cursor = writer->buffer;
+    }
+
+    writer->cursor = put_varint(writer->cursor, range->min_ip.s_addr - writer->previous);
+    writer->cursor = put_varint(writer->cursor, range->max_ip.s_addr - range->min_ip.s_addr);
+    writer->previous = range->min_ip.s_addr;
+    writer->run.length++;
+}
+
+
+static void finish_spill_run(SpillWriter *writer, SpillRuns *runs) {
+    write_spill_buffer(writer->run.file, writer->buffer, (size_t)(writer->cursor - writer->buffer));
+    if (fflush(writer->run.file) != 0) {
+        perror("Failed to write temporary file");
+        exit(EXIT_FAILURE);
+    }
+    free(writer->buffer);
+
+    if (runs->count == runs->capacity) {
+        const size_t capacity = runs->capacity ? runs->capacity * 2 : 16;
+        SpillRun *grown = realloc(runs->runs, capacity * sizeof(SpillRun));
+        if (!grown) {
+            perror("Failed to allocate spilled runs");
+            exit(EXIT_FAILURE);
+        }
+        runs->runs = grown;
+        runs->capacity = capacity;
+    }
+    runs->runs[runs->count++] = writer->run;
+}
+
+
+static void open_spill_run(SpillRun *run, const size_t buffer_size) {
+    free(run->buffer);
+    run->buffer = malloc(buffer_size);
+    if (!run->buffer) {
+        perror("Failed to allocate spill buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    rewind(run->file);
+    run->buffer_size = buffer_size;
+    run->position = 0;
+    run->filled = 0;
+    run->remaining = run->length;
+    run->previous = 0;
+}
+
+
+static void close_spill_run(SpillRun *run) {
+    fclose(run->file);
+    free(run->buffer);
+}
+
+
+/**
+ * @brief Merges the most recent runs of the lowest level into one of the next level.
+ *
+ * The levels never grow from the oldest run to the most recent one, so the runs
+ * of the lowest level are the last ones. A single run of its level joins the
+ * runs of the level above it, so every compaction reduces the number of the runs.
+ * The runs are merged on the fly, so besides the small read buffers of the runs
+ * nothing is kept in memory, and the files of the merged runs are closed.
+ *
+ * @param runs The spilled runs, at least two of them.
+ */
+static void compact_spilled_runs(SpillRuns *runs) {
+    const unsigned lowest_level = runs->runs[runs->count - 1].level;
+    size_t first = runs->count - 1;
+    while (first > 0 && runs->runs[first - 1].level == lowest_level) {
+        first--;
+    }
+    if (first == runs->count - 1) {
+        const unsigned level = runs->runs[first - 1].level;
+        while (first > 0 && runs->runs[first - 1].level == level) {
+            first--;
+        }
+    }
+    const size_t count = runs->count - first;
+
+    RangeStream *streams = malloc(count * sizeof(RangeStream));
+    if (!streams) {
+        perror("Failed to allocate merge streams");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < count; i++) {
+        open_spill_run(&runs->runs[first + i], MIN_SPILL_BUFFER_SIZE);
+        streams[i] = (RangeStream){.next = next_spilled_range, .source = &runs->runs[first + i]};
+    }
+
+    SpillWriter writer;
+    start_spill_run(&writer);
+    writer.run.level = runs->runs[first].level + 1;
+    merge_range_streams_into(streams, count, put_spilled_range, &writer);
+    free(streams);
+
+    for (size_t i = first; i < runs->count; i++) {
+        close_spill_run(&runs->runs[i]);
+    }
+    runs->count = first;
+    finish_spill_run(&writer, runs);
+}
+
+
+/**
+ * @brief Writes the merged ranges of the list to a new temporary file.
+ *
+ * The file is created in the directory given by the `TMPDIR` environment variable
+ * (or `/tmp`) and removed right away, so it disappears once it's closed, even if
+ * the program is killed.
+ *
+ * Once there are MAX_SPILL_FAN_IN runs, the most recent runs of the lowest level
+ * are merged into one of the next level first, so neither the open files nor the
+ * read buffers of the final merge grow with the input. As in a tiered LSM tree,
+ * every range is rewritten once per level, i.e. a logarithmic number of times.
+ *
+ * @param runs The runs to add the new one to.
+ * @param list The list of the merged ranges, sorted and disjoint. Its hosts are ignored.
+ *
+ * @note If the file cannot be created or written, the function prints an error
+ *       message and exits the program.
+ */
+void spill_ip_ranges(SpillRuns *runs, const ipRangeList *list) {
+    if (runs->count >= MAX_SPILL_FAN_IN) {
+        compact_spilled_runs(runs);
+    }
+
+    SpillWriter writer;
+    start_spill_run(&writer);
+    for (size_t i = 0; i < list->length; i++) {
+        put_spilled_range(&writer, &list->cidrs[i]);
+    }
+    finish_spill_run(&writer, runs);
+}
+
+
+/**
+ * @brief Prepares every run to be read from its start.
+ *
+ * @param runs The spilled runs.
+ * @param buffer_size The size of the read buffer of every run.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void open_spilled_runs(SpillRuns *runs, const size_t buffer_size) {
+    for (size_t i = 0; i < runs->count; i++) {
+        open_spill_run(&runs->runs[i], buffer_size);
+    }
+}
+
+
+static unsigned char read_spill_byte(SpillRun *run) {
+    if (run->position == run->filled) {
+        run->filled = fread(run->buffer, 1, run->buffer_size, run->file);
+        run->position = 0;
+        if (run->filled == 0) {
+            fprintf(stderr, "Failed to read temporary file: unexpected end of file\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return run->buffer[run->position++];
+}
+
+
+static uint32_t read_varint(SpillRun *run) {
+    uint32_t value = 0;
+    for (unsigned shift = 0; shift < 7 * MAX_VARINT_LENGTH; shift += 7) {
+        const unsigned char byte = read_spill_byte(run);
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return value;
+}
+
+
+/**
+ * @brief Reads the next range of the run.
+ *
+ * The signature matches `NextRangeFunction`, so a run may be used as a RangeStream.
+ *
+ * @param run A pointer to the SpillRun opened by `open_spilled_runs()`.
+ * @param range A pointer to store the range.
+ * @return true if the range is read; false at the end of the run.
+ *
+ * @note If the file cannot be read, the function prints an error message and
+ *       exits the program.
+ */
+bool next_spilled_range(void *run, ipRange *range) {
+    SpillRun *spill_run = run;
+    if (spill_run->remaining == 0) {
+        return false;
+    }
+
+    const uint32_t min_ip = spill_run->previous + read_varint(spill_run);
+    const uint32_t size = read_varint(spill_run);
+    *range = (ipRange){.min_ip = {min_ip}, .max_ip = {min_ip + size}};
+
+    spill_run->previous = min_ip;
+    spill_run->remaining--;
+    return true;
+}
+
+
+/**
+ * @brief Closes (and thus removes) the temporary files and releases the runs.
+ *
+ * @param runs The spilled runs.
+ */
+void free_spilled_runs(SpillRuns *runs) {
+    for (size_t i = 0; i < runs->count; i++) {
+        close_spill_run(&runs->runs[i]);
+    }
+    free(runs->runs);
+    *runs = (SpillRuns){0};
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_SPILL_H
+#define MERGE_IP_SPILL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ipRange.h"
+
+
+#define SPILL_BUFFER_SIZE (64 * 1024)
+#define MIN_SPILL_BUFFER_SIZE (4 * 1024)
+// the runs merged at once; there are never more of them, so the files open at the same
+// time stay far below the usual descriptor limits, and the final merge fits the memory limit
+#define MAX_SPILL_FAN_IN 32
+
+
+// A sorted run of merged ranges in a temporary file. Every range is stored as two
+// LEB128 varints: the distance from the start of the previous range and the size
+// of the range minus one, so most of the ranges take 2 - 6 bytes instead of 8.
+typedef struct {
+    FILE *file;
+    unsigned level;         // 0 for a spilled list, one more than the highest of the runs merged into it
+    size_t length;          // the number of the ranges in the run
+    size_t remaining;       // the number of the ranges not read yet
+    uint32_t previous;      // the start of the previous range
+    unsigned char *buffer;
+    size_t buffer_size;
+    size_t position;
+    size_t filled;
+} SpillRun;
+
+typedef struct {
+    SpillRun *runs;
+    size_t count;
+    size_t capacity;
+} SpillRuns;
+
+
+/**
+ * @brief Writes the merged ranges of the list to a new temporary file.
+ *
+ * The file is created in the directory given by the `TMPDIR` environment variable
+ * (or `/tmp`) and removed right away, so it disappears once it's closed, even if
+ * the program is killed.
+ *
+ * Once there are MAX_SPILL_FAN_IN runs, the most recent runs of the lowest level
+ * are merged into one of the next level first, so neither the open files nor the
+ * read buffers of the final merge grow with the input. As in a tiered LSM tree,
+ * every range is rewritten once per level, i.e. a logarithmic number of times.
+ *
+ * @param runs The runs to add the new one to.
+ * @param list The list of the merged ranges, sorted and disjoint. Its hosts are ignored.
+ *
+ * @note If the file cannot be created or written, the function prints an error
+ *       message and exits the program.
+ */
+void spill_ip_ranges(SpillRuns *runs, const ipRangeList *list);
+
+
+/**
+ * @brief Prepares every run to be read from its start.
+ *
+ * @param runs The spilled runs.
+ * @param buffer_size The size of the read buffer of every run.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+void open_spilled_runs(SpillRuns *runs, size_t buffer_size);
+
+
+/**
+ * @brief Reads the next range of the run.
+ *
+ * The signature matches `NextRangeFunction`, so a run may be used as a RangeStream.
+ *
+ * @param run A pointer to the SpillRun opened by `open_spilled_runs()`.
+ * @param range A pointer to store the range.
+ * @return true if the range is read; false at the end of the run.
+ *
+ * @note If the file cannot be read, the function prints an error message and
+ *       exits the program.
+ */
+bool next_spilled_range(void *run, ipRange *range);
+
+
+/**
+ * @brief Closes (and thus removes) the temporary files and releases the runs.
+ *
+ * @param runs The spilled runs.
+ */
+void free_spilled_runs(SpillRuns *runs);
+
+#endif //MERGE_IP_SPILL_H
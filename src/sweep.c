@@ -0,0 +1,176 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+
+#include "bits.h"
+#include "sweep.h"
+
+// AVX2 is detected at runtime, so the binary still works on older CPUs
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define SWEEP_AVX2
+    #include <immintrin.h>
+#endif
+
+
+// The sweep keeps the first address of the range being merged and the highest last
+// address seen so far. A range starts a new merged range only if there's a gap of at
+// least one address between it and everything before it. That's never the case after
+// a range ending at 255.255.255.255, so no special handling of the last address is needed.
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+} SweepState;
+
+
+static inline size_t sweep_range(SweepState *state, const ipRange *range, ipRange *merged, size_t count) {
+    const uint32_t min_ip = range->min_ip.s_addr;
+    if (min_ip > state->last && min_ip - 1 != state->last) {
+        merged[count++] = (ipRange){.min_ip = {state->first}, .max_ip = {state->last}};
+        state->first = min_ip;
+    }
+    if (range->max_ip.s_addr > state->last) {
+        state->last = range->max_ip.s_addr;
+    }
+    return count;
+}
+
+
+static size_t sweep_scalar(const ipRange *ranges, const size_t length, ipRange *merged) {
+    if (length == 0) {
+        return 0;
+    }
+
+    SweepState state = {ranges[0].min_ip.s_addr, ranges[0].max_ip.s_addr};
+    size_t count = 0;
+    for (size_t i = 1; i < length; i++) {
+        count = sweep_range(&state, &ranges[i], merged, count);
+    }
+
+    merged[count++] = (ipRange){.min_ip = {state.first}, .max_ip = {state.last}};
+    return count;
+}
+
+static const Sweeper SCALAR_SWEEPER = {"scalar", sweep_scalar};
+
+
+#ifdef SWEEP_AVX2
+/**
+ * @brief Merges a sorted array of IP ranges, SWEEP_BLOCK_SIZE ranges at a time.
+ *
+ * Every block is loaded as two registers and split into a column of `min_ip` and
+ * a column of `max_ip`. The running maximum of `max_ip` is computed by a prefix
+ * scan, and the ranges which start a new merged range are found by comparing
+ * their `min_ip` with the running maximum of the ranges before them. Only those
+ * ranges are handled one by one.
+ */
+__attribute__((target("avx2")))
+static size_t sweep_avx2(const ipRange *ranges, const size_t length, ipRange *merged) {
+    if (length == 0) {
+        return 0;
+    }
+
+    // [min0, max0, min1, max1, min2, max2, min3, max3] -> [min0, min1, min2, min3, max0, max1, max2, max3]
+    const __m256i deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i shift_by_1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i shift_by_2 = _mm256_setr_epi32(0, 1, 0, 1, 2, 3, 4, 5);
+    const __m256i shift_by_4 = _mm256_setr_epi32(0, 1, 2, 3, 0, 1, 2, 3);
+    // AVX2 compares signed integers only
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000);
+    const __m256i ones = _mm256_set1_epi32(1);
+
+    SweepState state = {ranges[0].min_ip.s_addr, ranges[0].max_ip.s_addr};
+    size_t count = 0;
+    size_t i = 1;
+
+    for (; i + SWEEP_BLOCK_SIZE <= length; i += SWEEP_BLOCK_SIZE) {
+        const __m256i low = _mm256_permutevar8x32_epi32(
+            _mm256_loadu_si256((const __m256i *)(const void *)(ranges + i)), deinterleave);
+        const __m256i high = _mm256_permutevar8x32_epi32(
+            _mm256_loadu_si256((const __m256i *)(const void *)(ranges + i + 4)), deinterleave);
+        const __m256i min_ips = _mm256_permute2x128_si256(low, high, 0x20);
+        const __m256i max_ips = _mm256_permute2x128_si256(low, high, 0x31);
+
+        // the inclusive prefix maximum; the lanes shifted in are duplicates, which don't change the maximum
+        const __m256i last = _mm256_set1_epi32((int)state.last);
+        __m256i running = _mm256_max_epu32(max_ips, _mm256_permutevar8x32_epi32(max_ips, shift_by_1));
+        running = _mm256_max_epu32(running, _mm256_permutevar8x32_epi32(running, shift_by_2));
+        running = _mm256_max_epu32(running, _mm256_permutevar8x32_epi32(running, shift_by_4));
+        running = _mm256_max_epu32(running, last);
+
+        // the highest last address before every range of the block
+        const __m256i previous = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(running, shift_by_1), last, 0x01);
+
+        // min_ip > previous && min_ip - 1 != previous
+        const __m256i above = _mm256_cmpgt_epi32(_mm256_xor_si256(min_ips, sign), _mm256_xor_si256(previous, sign));
+        const __m256i adjacent = _mm256_cmpeq_epi32(_mm256_sub_epi32(min_ips, ones), previous);
+        unsigned starts = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(adjacent, above)));
+
+        if (starts) {
+            uint32_t block_min_ips[SWEEP_BLOCK_SIZE];
+            uint32_t block_previous[SWEEP_BLOCK_SIZE];
+            _mm256_storeu_si256((__m256i *)(void *)block_min_ips, min_ips);
+            _mm256_storeu_si256((__m256i *)(void *)block_previous, previous);
+
+            while (starts) {
+                const unsigned lane = count_trailing_zeros32(starts);
+                merged[count++] = (ipRange){.min_ip = {state.first}, .max_ip = {block_previous[lane]}};
+                state.first = block_min_ips[lane];
+                starts &= starts - 1;
+            }
+        }
+
+        state.last = (uint32_t)_mm256_extract_epi32(running, 7);
+    }
+
+    for (; i < length; i++) {
+        count = sweep_range(&state, &ranges[i], merged, count);
+    }
+
+    merged[count++] = (ipRange){.min_ip = {state.first}, .max_ip = {state.last}};
+    return count;
+}
+
+static const Sweeper AVX2_SWEEPER = {"AVX2", sweep_avx2};
+#endif
+
+
+/**
+ * @brief Returns the fastest merge sweep supported by the current CPU.
+ *
+ * The sweep is selected at runtime: AVX2 on x86, and the portable scalar
+ * implementation otherwise.
+ *
+ * @return A pointer to the statically allocated sweeper.
+ */
+const Sweeper *get_sweeper(void) {
+#ifdef SWEEP_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return &AVX2_SWEEPER;
+    }
+#endif
+    return &SCALAR_SWEEPER;
+}
+
+
+/**
+ * @brief Returns the portable range-by-range sweep.
+ *
+ * @return A pointer to the statically allocated sweeper.
+ */
+const Sweeper *get_scalar_sweeper(void) {
+    return &SCALAR_SWEEPER;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_SWEEP_H
+#define MERGE_IP_SWEEP_H
+
+#include <stddef.h>
+
+#include "ipRange.h"
+
+// number of ranges handled at once by a vectorized sweep
+#define SWEEP_BLOCK_SIZE 8
+
+
+/**
+ * @brief Merges a sorted array of IP ranges.
+ *
+ * The function merges overlapping or contiguous ranges of the sorted array.
+ *
+ * @param ranges The sorted array of `ipRange` structures to be merged.
+ * @param length The number of elements in the `ranges` array.
+ * @param merged The array to store the merged ranges. It must be able to hold `length`
+ *               elements and may start at the same address as `ranges`.
+ * @return The number of merged IP ranges stored in the `merged` array.
+ */
+typedef size_t (*SweepFunction)(const ipRange *ranges, size_t length, ipRange *merged);
+
+
+typedef struct {
+    const char *name;
+    SweepFunction sweep;
+} Sweeper;
+
+
+/**
+ * @brief Returns the fastest merge sweep supported by the current CPU.
+ *
+ * The sweep is selected at runtime: AVX2 on x86, and the portable scalar
+ * implementation otherwise.
+ *
+ * @return A pointer to the statically allocated sweeper.
+ */
+const Sweeper *get_sweeper(void);
+
+
+/**
+ * @brief Returns the portable range-by-range sweep.
+ *
+ * @return A pointer to the statically allocated sweeper.
+ */
+const Sweeper *get_scalar_sweeper(void);
+
+#endif //MERGE_IP_SWEEP_H
@@ -0,0 +1,406 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// io_uring is used through the raw system calls, so there's no dependency on liburing
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define HAVE_IO_URING
+    #endif
+#endif
+
+#ifdef HAVE_IO_URING
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+
+    // the C library may be older than the kernel headers
+    #ifndef __NR_io_uring_setup
+        #undef HAVE_IO_URING
+    #endif
+#endif
+
+#include "uring.h"
+
+
+#ifdef HAVE_IO_URING
+
+// A buffer and the block of the file which is read into it
+typedef struct {
+    struct iovec buffer;   // the whole buffer, as registered with the kernel
+    struct iovec request;  // the unread part of the block, kept for IORING_OP_READV till it completes
+    uint64_t offset;       // the start of the block in the file
+    size_t length;
+    size_t filled;         // the bytes read so far
+} AsyncSlot;
+
+struct AsyncReader {
+    int ring_fd;
+    int fd;
+    uint64_t size;           // the end of the file, reduced if it's truncated while being read
+    size_t block_size;
+    bool registered;         // the buffers are registered, so IORING_OP_READ_FIXED is used
+    char *buffers;
+    AsyncSlot slots[ASYNC_READ_DEPTH];  // the block N is read into the slot N % ASYNC_READ_DEPTH
+    uint64_t next_offset;    // the start of the next block to read ahead
+    size_t scheduled;        // the number of the blocks read ahead so far
+    size_t next_block;       // the number of the next block to be returned
+    unsigned pending;        // the submissions not taken by the kernel yet
+    unsigned in_flight;      // the submissions not completed yet
+
+    // the rings shared with the kernel
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+
+// terminates the program with the error reported by a system call or a completion
+static void fail_reading(const int error) {
+    errno = error;
+    perror("Failed to read file");
+    exit(EXIT_FAILURE);
+}
+
+
+static bool map_rings(AsyncReader *reader, const struct io_uring_params *params) {
+    reader->sq_ring_size = params->sq_off.array + params->sq_entries * sizeof(unsigned);
+    reader->cq_ring_size = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+    const bool single_mmap = params->features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap && reader->cq_ring_size > reader->sq_ring_size) {
+        reader->sq_ring_size = reader->cq_ring_size;
+    }
+
+    reader->sq_ring = mmap(NULL, reader->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           reader->ring_fd, IORING_OFF_SQ_RING);
+    if (reader->sq_ring == MAP_FAILED) {
+        reader->sq_ring = NULL;
+        return false;
+    }
+    if (single_mmap) {
+        reader->cq_ring = reader->sq_ring;
+    } else {
+        reader->cq_ring = mmap(NULL, reader->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               reader->ring_fd, IORING_OFF_CQ_RING);
+        if (reader->cq_ring == MAP_FAILED) {
+            reader->cq_ring = NULL;
+            return false;
+        }
+    }
+
+    reader->sqes_size = params->sq_entries * sizeof(struct io_uring_sqe);
+    reader->sqes = mmap(NULL, reader->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        reader->ring_fd, IORING_OFF_SQES);
+    if (reader->sqes == MAP_FAILED) {
+        reader->sqes = NULL;
+        return false;
+    }
+
+    char *sq_ring = reader->sq_ring;
+    char *cq_ring = reader->cq_ring;
+    reader->sq_tail = (unsigned *)(sq_ring + params->sq_off.tail);
+    reader->sq_mask = (unsigned *)(sq_ring + params->sq_off.ring_mask);
+    reader->sq_array = (unsigned *)(sq_ring + params->sq_off.array);
+    reader->cq_head = (unsigned *)(cq_ring + params->cq_off.head);
+    reader->cq_tail = (unsigned *)(cq_ring + params->cq_off.tail);
+    reader->cq_mask = (unsigned *)(cq_ring + params->cq_off.ring_mask);
+    reader->cqes = (struct io_uring_cqe *)(cq_ring + params->cq_off.cqes);
+    return true;
+}
+
+
+static void unmap_rings(const AsyncReader *reader) {
+    if (reader->sqes) {
+        munmap(reader->sqes, reader->sqes_size);
+    }
+    if (reader->cq_ring && reader->cq_ring != reader->sq_ring) {
+        munmap(reader->cq_ring, reader->cq_ring_size);
+    }
+    if (reader->sq_ring) {
+        munmap(reader->sq_ring, reader->sq_ring_size);
+    }
+}
+
+
+// queues a read of the rest of the slot's block; there's at most one read per slot, so the
+// submission ring of ASYNC_READ_DEPTH entries never overflows
+static void submit_read(AsyncReader *reader, const size_t slot_index) {
+    AsyncSlot *slot = &reader->slots[slot_index];
+    slot->request.iov_base = (char *)slot->buffer.iov_base + slot->filled;
+    slot->request.iov_len = slot->length - slot->filled;
+
+    // the tail of the submission ring is written by this thread only
+    const unsigned tail = *reader->sq_tail;
+    const unsigned index = tail & *reader->sq_mask;
+    struct io_uring_sqe *sqe = &reader->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = reader->fd;
+    sqe->off = slot->offset + slot->filled;
+    sqe->user_data = slot_index;
+    if (reader->registered) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = (uint64_t)(uintptr_t)slot->request.iov_base;
+        sqe->len = (uint32_t)slot->request.iov_len;
+        sqe->buf_index = (uint16_t)slot_index;
+    } else {
+        sqe->opcode = IORING_OP_READV;
+        sqe->addr = (uint64_t)(uintptr_t)&slot->request;
+        sqe->len = 1;
+    }
+    reader->sq_array[index] = index;
+
+    // the kernel must see the entry before the new tail
+    __atomic_store_n(reader->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    reader->pending++;
+    reader->in_flight++;
+}
+
+
+// hands the queued reads over to the kernel and waits for `wait_count` completions
+static void enter_ring(AsyncReader *reader, const unsigned wait_count) {
+    for (;;) {
+        const long result = syscall(__NR_io_uring_enter, reader->ring_fd, reader->pending, wait_count,
+                                    wait_count ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (result >= 0) {
+            reader->pending -= (unsigned)result;
+            return;
+        }
+        if (errno != EINTR) {
+            fail_reading(errno);
+        }
+    }
+}
+
+
+// takes the completed reads, resubmitting the partial ones
+static void reap_completions(AsyncReader *reader) {
+    unsigned head = *reader->cq_head;
+    const unsigned tail = __atomic_load_n(reader->cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &reader->cqes[head & *reader->cq_mask];
+        const size_t slot_index = (size_t)cqe->user_data;
+        const int result = cqe->res;
+        AsyncSlot *slot = &reader->slots[slot_index];
+        reader->in_flight--;
+
+        if (result < 0) {
+            if (result != -EINTR && result != -EAGAIN) {
+                fail_reading(-result);
+            }
+            submit_read(reader, slot_index);
+        } else if (result == 0) {
+            // the file is shorter than it was, so nothing follows this block
+            slot->length = slot->filled;
+            if (reader->size > slot->offset + slot->filled) {
+                reader->size = slot->offset + slot->filled;
+            }
+        } else {
+            slot->filled += (size_t)result;
+            if (slot->filled < slot->length) {
+                submit_read(reader, slot_index);
+            }
+        }
+    }
+
+    __atomic_store_n(reader->cq_head, head, __ATOMIC_RELEASE);
+}
+
+
+// starts reading the next block of the file into the slot, if there's one
+static void schedule_block(AsyncReader *reader, const size_t slot_index) {
+    if (reader->next_offset >= reader->size) {
+        return;
+    }
+
+    AsyncSlot *slot = &reader->slots[slot_index];
+    const uint64_t remaining = reader->size - reader->next_offset;
+    slot->offset = reader->next_offset;
+    slot->length = remaining < reader->block_size ? (size_t)remaining : reader->block_size;
+    slot->filled = 0;
+    reader->next_offset += slot->length;
+    reader->scheduled++;
+    submit_read(reader, slot_index);
+}
+
+
+/**
+ * @brief Starts reading the file ahead with several reads in flight.
+ *
+ * The file is read by io_uring in blocks of `block_size` bytes, up to
+ * ASYNC_READ_DEPTH of them at once, into the buffers registered with the kernel
+ * (or into plain buffers, if they cannot be registered). So, the device is kept
+ * busy while the blocks read already are parsed.
+ *
+ * @param fd The descriptor of the opened regular file.
+ * @param size The size of the file in bytes.
+ * @param block_size The size of the blocks.
+ * @return A pointer to the new reader or NULL if io_uring is not available (e.g. on
+ *         an older kernel, in a sandbox which forbids it, or on another OS); the
+ *         caller should read the file in another way then.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+AsyncReader *open_async_reader(const int fd, const size_t size, const size_t block_size) {
+    AsyncReader *reader = calloc(1, sizeof(AsyncReader));
+    if (!reader) {
+        perror("Failed to allocate asynchronous reader");
+        exit(EXIT_FAILURE);
+    }
+    reader->fd = fd;
+    reader->size = size;
+    reader->block_size = block_size;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    const long ring_fd = syscall(__NR_io_uring_setup, ASYNC_READ_DEPTH, &params);
+    if (ring_fd < 0) {
+        free(reader);
+        return NULL;
+    }
+    reader->ring_fd = (int)ring_fd;
+    if (!map_rings(reader, &params)) {
+        unmap_rings(reader);
+        close(reader->ring_fd);
+        free(reader);
+        return NULL;
+    }
+
+    reader->buffers = malloc(ASYNC_READ_DEPTH * block_size);
+    if (!reader->buffers) {
+        perror("Failed to allocate read buffer");
+        exit(EXIT_FAILURE);
+    }
+    struct iovec buffers[ASYNC_READ_DEPTH];
+    for (size_t i = 0; i < ASYNC_READ_DEPTH; i++) {
+        reader->slots[i].buffer = (struct iovec){.iov_base = reader->buffers + i * block_size, .iov_len = block_size};
+        buffers[i] = reader->slots[i].buffer;
+    }
+
+    // the kernel pins the registered buffers once instead of on every read; this fails when
+    // the buffers exceed the locked memory limit, so the plain reads are the fallback
+    reader->registered = syscall(__NR_io_uring_register, reader->ring_fd, IORING_REGISTER_BUFFERS,
+                                 buffers, ASYNC_READ_DEPTH) == 0;
+
+    for (size_t i = 0; i < ASYNC_READ_DEPTH; i++) {
+        schedule_block(reader, i);
+    }
+    enter_ring(reader, 0);
+
+    return reader;
+}
+
+
+/**
+ * @brief Waits for the next block of the file.
+ *
+ * The blocks are returned in the order of the file, no matter in which order the
+ * reads complete. The previous block is reused for a read ahead, so it must not
+ * be accessed after this call.
+ *
+ * @param reader A pointer to the reader.
+ * @param data A pointer to store the start of the block.
+ * @param length A pointer to store the length of the block.
+ * @return true if there's a block; false at the end of the file.
+ *
+ * @note If reading fails, the function prints an error message and exits the program.
+ */
+bool next_async_block(AsyncReader *reader, const char **data, size_t *length) {
+    // the previous block is parsed already, so its buffer takes the next read
+    if (reader->next_block > 0) {
+        schedule_block(reader, (reader->next_block - 1) % ASYNC_READ_DEPTH);
+    }
+    if (reader->next_block == reader->scheduled) {
+        return false;
+    }
+    if (reader->pending) {
+        enter_ring(reader, 0);
+    }
+
+    const AsyncSlot *slot = &reader->slots[reader->next_block % ASYNC_READ_DEPTH];
+    reap_completions(reader);
+    while (slot->filled < slot->length) {
+        enter_ring(reader, 1);
+        reap_completions(reader);
+    }
+
+    *data = slot->buffer.iov_base;
+    *length = slot->length;
+    reader->next_block++;
+    return true;
+}
+
+
+/**
+ * @brief Releases the reader. The file stays open.
+ *
+ * @param reader A pointer to the reader.
+ */
+void close_async_reader(AsyncReader *reader) {
+    // the kernel may still write into the buffers of the reads in flight
+    while (reader->in_flight) {
+        enter_ring(reader, 1);
+        reap_completions(reader);
+    }
+
+    unmap_rings(reader);
+    close(reader->ring_fd);
+    free(reader->buffers);
+    free(reader);
+}
+
+#else
+
+AsyncReader *open_async_reader(const int fd, const size_t size, const size_t block_size) {
+    (void)fd;
+    (void)size;
+    (void)block_size;
+    return NULL;
+}
+
+
+bool next_async_block(AsyncReader *reader, const char **data, size_t *length) {
+    (void)reader;
+    (void)data;
+    (void)length;
+    return false;
+}
+
+
+void close_async_reader(AsyncReader *reader) {
+    (void)reader;
+}
+
+#endif
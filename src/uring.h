@@ -0,0 +1,78 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MERGE_IP_URING_H
+#define MERGE_IP_URING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+// the number of the reads kept in flight by an asynchronous reader
+#define ASYNC_READ_DEPTH 8
+
+
+// The blocks of a regular file read ahead by io_uring, see `open_async_reader()`
+typedef struct AsyncReader AsyncReader;
+
+
+/**
+ * @brief Starts reading the file ahead with several reads in flight.
+ *
+ * The file is read by io_uring in blocks of `block_size` bytes, up to
+ * ASYNC_READ_DEPTH of them at once, into the buffers registered with the kernel
+ * (or into plain buffers, if they cannot be registered). So, the device is kept
+ * busy while the blocks read already are parsed.
+ *
+ * @param fd The descriptor of the opened regular file.
+ * @param size The size of the file in bytes.
+ * @param block_size The size of the blocks.
+ * @return A pointer to the new reader or NULL if io_uring is not available (e.g. on
+ *         an older kernel, in a sandbox which forbids it, or on another OS); the
+ *         caller should read the file in another way then.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+AsyncReader *open_async_reader(int fd, size_t size, size_t block_size);
+
+
+/**
+ * @brief Waits for the next block of the file.
+ *
+ * The blocks are returned in the order of the file, no matter in which order the
+ * reads complete. The previous block is reused for a read ahead, so it must not
+ * be accessed after this call.
+ *
+ * @param reader A pointer to the reader.
+ * @param data A pointer to store the start of the block.
+ * @param length A pointer to store the length of the block.
+ * @return true if there's a block; false at the end of the file.
+ *
+ * @note If reading fails, the function prints an error message and exits the program.
+ */
+bool next_async_block(AsyncReader *reader, const char **data, size_t *length);
+
+
+/**
+ * @brief Releases the reader. The file stays open.
+ *
+ * @param reader A pointer to the reader.
+ */
+void close_async_reader(AsyncReader *reader);
+
+#endif //MERGE_IP_URING_H
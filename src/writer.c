@@ -0,0 +1,409 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <limits.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+#endif
+
+#include "writer.h"
+
+
+#define TEMP_FILE_SUFFIX ".XXXXXX"
+// the number of the buffers passed to a single `writev()` call
+#ifdef IOV_MAX
+    #define MAX_WRITE_VECTORS (IOV_MAX < 1024 ? IOV_MAX : 1024)
+#else
+    #define MAX_WRITE_VECTORS 16
+#endif
+
+
+// The decimal text of every octet value, e.g. {"192", 3}
+typedef struct {
+    char text[3];
+    uint8_t length;
+} OctetText;
+
+static OctetText octets[256];
+static bool octets_ready = false;
+
+
+static void init_octets(void) {
+    if (octets_ready) {
+        return;
+    }
+
+    for (unsigned value = 0; value < 256; value++) {
+        OctetText *octet = &octets[value];
+        if (value >= 100) {
+            octet->text[octet->length++] = (char)('0' + value / 100);
+        }
+        if (value >= 10) {
+            octet->text[octet->length++] = (char)('0' + value / 10 % 10);
+        }
+        octet->text[octet->length++] = (char)('0' + value % 10);
+    }
+
+    octets_ready = true;
+}
+
+
+static inline char *put_octet(char *cursor, const unsigned value) {
+    const OctetText *octet = &octets[value];
+    memcpy(cursor, octet->text, 3);
+    return cursor + octet->length;
+}
+
+
+// the file writers which are not closed yet, so their temporary files are removed at exit
+static Writer *incomplete_writers = NULL;
+
+
+static void remove_incomplete_outputs(void) {
+    for (const Writer *writer = incomplete_writers; writer; writer = writer->next_incomplete) {
+        remove(writer->temp_filename);
+    }
+}
+
+
+static void track_incomplete_output(Writer *writer) {
+    static bool is_registered = false;
+    if (!is_registered) {
+        is_registered = atexit(remove_incomplete_outputs) == 0;
+    }
+
+    writer->next_incomplete = incomplete_writers;
+    incomplete_writers = writer;
+}
+
+
+static void untrack_incomplete_output(const Writer *writer) {
+    for (Writer **link = &incomplete_writers; *link; link = &(*link)->next_incomplete) {
+        if (*link == writer) {
+            *link = writer->next_incomplete;
+            return;
+        }
+    }
+}
+
+
+// reports the error, removes the incomplete output file and terminates the program
+static void fail(const Writer *writer, const char *message) {
+    perror(message);
+    if (writer->temp_filename) {
+        remove(writer->temp_filename);
+    }
+    exit(EXIT_FAILURE);
+}
+
+
+static Writer *allocate_writer(void) {
+    init_octets();
+
+    Writer *writer = calloc(1, sizeof(Writer));
+    if (!writer) {
+        perror("Failed to allocate writer");
+        exit(EXIT_FAILURE);
+    }
+
+    writer->fd = -1;
+    writer->buffer = malloc(WRITE_BUFFER_SIZE);
+    if (!writer->buffer) {
+        perror("Failed to allocate write buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    return writer;
+}
+
+
+/**
+ * @brief Creates a writer which appends CIDR blocks to the stream.
+ *
+ * The writer uses the file descriptor of the stream, if there's one, so the
+ * stream's own buffer is flushed first. The stream stays open when the
+ * writer is closed.
+ *
+ * @param stream The output stream.
+ * @return A pointer to the new writer.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+Writer *open_stream_writer(FILE *stream) {
+    Writer *writer = allocate_writer();
+    writer->stream = stream;
+
+#ifndef _WIN32
+    // the streams in memory (fmemopen, open_memstream) have no file descriptor
+    const int fd = fileno(stream);
+    if (fd >= 0) {
+        // whatever is buffered by the stream must go before our output
+        if (fflush(stream) != 0) {
+            fail(writer, "Failed to flush output");
+        }
+        writer->fd = fd;
+    }
+#endif
+
+    return writer;
+}
+
+
+/**
+ * @brief Creates a writer which replaces the file atomically.
+ *
+ * The CIDR blocks are written to a temporary file in the same directory, which
+ * is renamed to `filename` by `close_writer()`. Thus, the readers of the file see
+ * either the old content or the complete new one, never a partially written list.
+ * If the program exits before the writer is closed (e.g. on an invalid input),
+ * the temporary file is removed.
+ *
+ * @param filename The name of the output file.
+ * @return A pointer to the new writer.
+ *
+ * @note If the temporary file cannot be created, the function prints an error
+ *       message and exits the program.
+ */
+Writer *open_file_writer(const char *filename) {
+    Writer *writer = allocate_writer();
+
+    const size_t length = strlen(filename);
+    writer->filename = malloc(length + 1);
+    writer->temp_filename = malloc(length + sizeof(TEMP_FILE_SUFFIX));
+    if (!writer->filename || !writer->temp_filename) {
+        perror("Failed to allocate output file name");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(writer->filename, filename, length + 1);
+    memcpy(writer->temp_filename, filename, length);
+    memcpy(writer->temp_filename + length, TEMP_FILE_SUFFIX, sizeof(TEMP_FILE_SUFFIX));
+
+#ifdef _WIN32
+    if (_mktemp_s(writer->temp_filename, length + sizeof(TEMP_FILE_SUFFIX)) != 0
+            || !(writer->stream = fopen(writer->temp_filename, "wb"))) {
+        perror("Failed to create output file");
+        exit(EXIT_FAILURE);
+    }
+    track_incomplete_output(writer);
+#else
+    writer->fd = mkstemp(writer->temp_filename);
+    if (writer->fd < 0) {
+        perror("Failed to create output file");
+        exit(EXIT_FAILURE);
+    }
+    track_incomplete_output(writer);
+
+    // mkstemp() creates the file readable by the owner only, while the output is expected
+    // to get the same permissions as any other new file
+    const mode_t mask = umask(0);
+    umask(mask);
+    if (fchmod(writer->fd, 0666 & ~mask) != 0) {
+        fail(writer, "Failed to set output file permissions");
+    }
+#endif
+
+    return writer;
+}
+
+
+/**
+ * @brief Formats a CIDR block in the `a.b.c.d/prefix` form followed by a new line.
+ *
+ * The decimal text of the octets is looked up in a table, which is filled by the
+ * first `open_stream_writer()` or `open_file_writer()` call. So, the threads may
+ * format the blocks at the same time once a writer is open.
+ *
+ * @param cursor The place to write the text to, at least CIDR_MAX_LENGTH bytes long.
+ * @param network The network address in the host byte order.
+ * @param prefix The length of the network prefix (0 - 32).
+ * @return A pointer right after the text.
+ */
+char *format_cidr(char *cursor, const uint32_t network, const unsigned prefix) {
+    cursor = put_octet(cursor, network >> 24);
+    *cursor++ = '.';
+    cursor = put_octet(cursor, (network >> 16) & 0xFF);
+    *cursor++ = '.';
+    cursor = put_octet(cursor, (network >> 8) & 0xFF);
+    *cursor++ = '.';
+    cursor = put_octet(cursor, network & 0xFF);
+    *cursor++ = '/';
+    cursor = put_octet(cursor, prefix);
+    *cursor++ = '\n';
+    return cursor;
+}
+
+
+/**
+ * @brief Appends a CIDR block in the `a.b.c.d/prefix` form followed by a new line.
+ *
+ * @param writer A pointer to the writer.
+ * @param network The network address in the host byte order.
+ * @param prefix The length of the network prefix (0 - 32).
+ *
+ * @note If writing fails, the function prints an error message and exits the program.
+ */
+void write_cidr(Writer *writer, const uint32_t network, const unsigned prefix) {
+    if (writer->length + CIDR_MAX_LENGTH > WRITE_BUFFER_SIZE) {
+        flush_writer(writer);
+    }
+
+    const char *cursor = format_cidr(writer->buffer + writer->length, network, prefix);
+    writer->length = (size_t)(cursor - writer->buffer);
+}
+
+
+/**
+ * @brief Writes out the buffered text.
+ *
+ * @param writer A pointer to the writer.
+ *
+ * @note If writing fails, the function prints an error message and exits the program.
+ */
+void flush_writer(Writer *writer) {
+#ifndef _WIN32
+    if (writer->fd >= 0) {
+        size_t written = 0;
+        while (written < writer->length) {
+            const ssize_t result = write(writer->fd, writer->buffer + written, writer->length - written);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail(writer, "Failed to write output");
+            }
+            written += (size_t)result;
+        }
+        writer->length = 0;
+        return;
+    }
+#endif
+
+    if (writer->length && fwrite(writer->buffer, 1, writer->length, writer->stream) != writer->length) {
+        fail(writer, "Failed to write output");
+    }
+    writer->length = 0;
+}
+
+
+/**
+ * @brief Writes out the buffered text followed by the given texts, in order.
+ *
+ * The texts are written as they are, without copying them into the buffer: a
+ * single `writev()` call takes many of them at once.
+ *
+ * @param writer A pointer to the writer.
+ * @param texts The array of the texts.
+ * @param lengths The array of the lengths of the texts.
+ * @param count The number of the texts.
+ *
+ * @note If writing fails, the function prints an error message and exits the program.
+ */
+void write_texts(Writer *writer, const char **texts, const size_t *lengths, const size_t count) {
+    flush_writer(writer);
+
+#ifndef _WIN32
+    if (writer->fd >= 0) {
+        struct iovec vectors[MAX_WRITE_VECTORS];
+        size_t text = 0;
+        size_t offset = 0;  // the part of the text `text` written already
+
+        while (text < count) {
+            size_t vector_count = 0;
+            for (size_t i = text; i < count && vector_count < MAX_WRITE_VECTORS; i++) {
+                const size_t skipped = i == text ? offset : 0;
+                vectors[vector_count++] = (struct iovec){
+                    .iov_base = (void *)(texts[i] + skipped), .iov_len = lengths[i] - skipped,
+                };
+            }
+
+            const ssize_t result = writev(writer->fd, vectors, (int)vector_count);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail(writer, "Failed to write output");
+            }
+
+            // a partial write stops in the middle of a text
+            size_t written = (size_t)result;
+            while (text < count && written >= lengths[text] - offset) {
+                written -= lengths[text] - offset;
+                offset = 0;
+                text++;
+            }
+            offset += written;
+        }
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i] && fwrite(texts[i], 1, lengths[i], writer->stream) != lengths[i]) {
+            fail(writer, "Failed to write output");
+        }
+    }
+}
+
+
+/**
+ * @brief Flushes and releases the writer.
+ *
+ * The file writers replace the output file with the temporary one.
+ *
+ * @param writer A pointer to the writer.
+ *
+ * @note If writing fails, the function prints an error message and exits the program.
+ */
+void close_writer(Writer *writer) {
+    flush_writer(writer);
+
+    if (writer->temp_filename) {
+#ifdef _WIN32
+        if (fclose(writer->stream) != 0
+                || !MoveFileExA(writer->temp_filename, writer->filename,
+                                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            fail(writer, "Failed to replace output file");
+        }
+#else
+        // the content must reach the disk before the file replaces the old one
+        if (fsync(writer->fd) != 0 || close(writer->fd) != 0) {
+            fail(writer, "Failed to write output file");
+        }
+        if (rename(writer->temp_filename, writer->filename) != 0) {
+            fail(writer, "Failed to replace output file");
+        }
+#endif
+        untrack_incomplete_output(writer);
+    } else if (writer->fd < 0 && fflush(writer->stream) != 0) {
+        fail(writer, "Failed to flush output");
+    }
+
+    free(writer->temp_filename);
+    free(writer->filename);
+    free(writer->buffer);
+    free(writer);
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MERGE_IP_WRITER_H
+#define MERGE_IP_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+#define WRITE_BUFFER_SIZE (256 * 1024)
+// strlen("255.255.255.255/32\n")
+#define CIDR_MAX_LENGTH 19
+
+
+// Buffered output of CIDR blocks. The text is formatted right into the buffer,
+// which goes to the file descriptor with `write()` when it's full.
+typedef struct Writer {
+    FILE *stream;        // the stream used when there's no file descriptor (e.g. fmemopen)
+    int fd;              // -1 when the output goes through the `stream`
+    char *buffer;
+    size_t length;
+    char *filename;      // the output file, NULL for the streams
+    char *temp_filename; // the file which replaces the output file on close
+    struct Writer *next_incomplete; // the next file writer to be cleaned up at exit
+} Writer;
+
+
+/**
+ * @brief Creates a writer which appends CIDR blocks to the stream.
+ *
+ * The writer uses the file descriptor of the stream, if there's one, so the
+ * stream's own buffer is flushed first. The stream stays open when the
+ * writer is closed.
+ *
+ * @param stream The output stream.
+ * @return A pointer to the new writer.
+ *
+ * @note If memory allocation fails, the function prints an error message and
+ *       exits the program.
+ */
+Writer *open_stream_writer(FILE *stream);
+
+
+/**
+ * @brief Creates a writer which replaces the file atomically.
+ *
+ * The CIDR blocks are written to a temporary file in the same directory, which
+ * is renamed to `filename` by `close_writer()`. Thus, the readers of the file see
+ * either the old content or the complete new one, never a partially written list.
+ * If the program exits before the writer is closed (e.g. on an invalid input),
+ * the temporary file is removed.
+ *
+ * @param filename The name of the output file.
+ * @return A pointer to the new writer.
+ *
+ * @note If the temporary file cannot be created, the function prints an error
+ *       message and exits the program.
+ */
+Writer *open_file_writer(const char *filename);
+
+
+/**
+ * @brief Formats a CIDR block in the `a.b.c.d/prefix` form followed by a new line.
+ *
+ * The decimal text of the octets is looked up in a table, which is filled by the
+ * first `open_stream_writer()` or `open_file_writer()` call. So, the threads may
+ * format the blocks at the same time once a writer is open.
+ *
+ * @param cursor The place to write the text to, at least CIDR_MAX_LENGTH bytes long.
+ * @param network The network address in the host byte order.
+ * @param prefix The length of the network prefix (0 - 32).
+ * @return A pointer right after the text.
+ */
+char *format_cidr(char *cursor, uint32_t network, unsigned prefix);
+
+
+/**
+ * @brief Appends a CIDR block in the `a.b.c.d/prefix` form followed by a new line.
+ *
+ * @param writer A pointer to the writer.
+ * @param network The network address in the host byte order.
+ * @param prefix The length of the network prefix (0 - 32).
+ *
+ * @note If writing fails, the function prints an error message and exits the program.
+ */
+void write_cidr(Writer *writer, uint32_t network, unsigned prefix);
+
+
+/**
+ * @brief Writes out the buffered text.
+ *
+ * @param writer A pointer to the writer.
+ *
+ * @note If writing fails, the function prints an error message and exits the program.
+ */
+void flush_writer(Writer *writer);
+
+
+/**
+ * @brief Writes out the buffered text followed by the given texts, in order.
+ *
+ * The texts are written as they are, without copying them into the buffer: a
+ * single `writev()` call takes many of them at once.
+ *
+ * @param writer A pointer to the writer.
+ * @param texts The array of the texts.
+ * @param lengths The array of the lengths of the texts.
+ * @param count The number of the texts.
+ *
+ * @note If writing fails, the function prints an error message and exits the program.
+ */
+void write_texts(Writer *writer, const char **texts, const size_t *lengths, size_t count);
+
+
+/**
+ * @brief Flushes and releases the writer.
+ *
+ * The file writers replace the output file with the temporary one.
+ *
+ * @param writer A pointer to the writer.
+ *
+ * @note If writing fails, the function prints an error message and exits the program.
+ */
+void close_writer(Writer *writer);
+
+#endif //MERGE_IP_WRITER_H
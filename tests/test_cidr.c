@@ -0,0 +1,76 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "cidr.h"
+
+
+void test_split_range_to_cidrs(void **state) {
+    CidrBlock blocks[MAX_CIDRS_PER_RANGE];
+
+    // the whole address space
+    assert_int_equal(split_range_to_cidrs(0x00000000, 0xFFFFFFFF, blocks), 1);
+    assert_int_equal(blocks[0].network, 0x00000000);
+    assert_int_equal(blocks[0].prefix, 0);
+
+    // a single address at both ends
+    assert_int_equal(split_range_to_cidrs(0xFFFFFFFF, 0xFFFFFFFF, blocks), 1);
+    assert_int_equal(blocks[0].network, 0xFFFFFFFF);
+    assert_int_equal(blocks[0].prefix, 32);
+    assert_int_equal(split_range_to_cidrs(0x00000000, 0x00000000, blocks), 1);
+    assert_int_equal(blocks[0].prefix, 32);
+
+    // 10.0.0.1 - 10.0.0.6: .1/32, .2/31, .4/31, .6/32
+    assert_int_equal(split_range_to_cidrs(0x0A000001, 0x0A000006, blocks), 4);
+    assert_int_equal(blocks[0].network, 0x0A000001);
+    assert_int_equal(blocks[0].prefix, 32);
+    assert_int_equal(blocks[1].network, 0x0A000002);
+    assert_int_equal(blocks[1].prefix, 31);
+    assert_int_equal(blocks[2].network, 0x0A000004);
+    assert_int_equal(blocks[2].prefix, 31);
+    assert_int_equal(blocks[3].network, 0x0A000006);
+    assert_int_equal(blocks[3].prefix, 32);
+
+    // the worst case
+    assert_int_equal(split_range_to_cidrs(0x00000001, 0xFFFFFFFE, blocks), MAX_CIDRS_PER_RANGE);
+
+    // the blocks are aligned and cover the random ranges without gaps
+    for (unsigned round = 0; round < 10000; round++) {
+        uint32_t first = (uint32_t)rand() << 16 ^ (uint32_t)rand();
+        uint32_t last = (uint32_t)rand() << 16 ^ (uint32_t)rand();
+        if (first > last) {
+            const uint32_t swap = first;
+            first = last;
+            last = swap;
+        }
+
+        const size_t count = split_range_to_cidrs(first, last, blocks);
+        uint32_t next = first;
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t host_mask = (uint32_t)(0xFFFFFFFFull >> blocks[i].prefix);
+            assert_int_equal(blocks[i].network, next);
+            assert_int_equal(blocks[i].network & host_mask, 0);
+            next = blocks[i].network + host_mask + 1;
+        }
+        assert_int_equal(next - 1, last);
+    }
+}
@@ -24,7 +24,105 @@ void test_parse_command_line_options(void **state) {
     char *args[] = {"merge-ip", "-f", "test.txt", "-d"};
     CommandLineOptions options = parse_command_line_options(4, args);
 
-    assert_non_null(options.file);
-    assert_string_equal(options.file, "test.txt");
+    assert_int_equal(options.file_count, 1);
+    assert_string_equal(options.files[0], "test.txt");
     assert_true(options.debug);
+    free_command_line_options(&options);
+}
+
+void test_parse_buffer_size_option(void **state) {
+    char *short_args[] = {"merge-ip", "-b", "64K"};
+    CommandLineOptions options = parse_command_line_options(3, short_args);
+    assert_int_equal(options.buffer_size, 64 * 1024);
+
+    char *long_args[] = {"merge-ip", "--buffer-size=16M"};
+    options = parse_command_line_options(2, long_args);
+    assert_int_equal(options.buffer_size, 16 * 1024 * 1024);
+
+    char *default_args[] = {"merge-ip"};
+    options = parse_command_line_options(1, default_args);
+    assert_int_equal(options.buffer_size, 0);
+}
+
+void test_parse_jobs_option(void **state) {
+    char *short_args[] = {"merge-ip", "-j", "8"};
+    CommandLineOptions options = parse_command_line_options(3, short_args);
+    assert_int_equal(options.threads, 8);
+
+    char *long_args[] = {"merge-ip", "--jobs=0"};
+    options = parse_command_line_options(2, long_args);
+    assert_true(options.threads >= 1);
+
+    char *default_args[] = {"merge-ip"};
+    options = parse_command_line_options(1, default_args);
+    assert_int_equal(options.threads, 1);
+}
+
+void test_parse_output_option(void **state) {
+    char *short_args[] = {"merge-ip", "-o", "result.txt"};
+    CommandLineOptions options = parse_command_line_options(3, short_args);
+    assert_string_equal(options.output, "result.txt");
+
+    char *long_args[] = {"merge-ip", "--output=result.txt"};
+    options = parse_command_line_options(2, long_args);
+    assert_string_equal(options.output, "result.txt");
+
+    char *default_args[] = {"merge-ip"};
+    options = parse_command_line_options(1, default_args);
+    assert_null(options.output);
+}
+
+void test_parse_engine_option(void **state) {
+    char *short_args[] = {"merge-ip", "-e", "bitmap"};
+    CommandLineOptions options = parse_command_line_options(3, short_args);
+    assert_int_equal(options.engine, MERGE_ENGINE_BITMAP);
+
+    char *long_args[] = {"merge-ip", "--engine=radix"};
+    options = parse_command_line_options(2, long_args);
+    assert_int_equal(options.engine, MERGE_ENGINE_RADIX);
+
+    char *default_args[] = {"merge-ip"};
+    options = parse_command_line_options(1, default_args);
+    assert_int_equal(options.engine, MERGE_ENGINE_AUTO);
+}
+
+void test_parse_online_option(void **state) {
+    char *args[] = {"merge-ip", "--online"};
+    CommandLineOptions options = parse_command_line_options(2, args);
+    assert_true(options.online);
+
+    char *default_args[] = {"merge-ip"};
+    options = parse_command_line_options(1, default_args);
+    assert_false(options.online);
+}
+
+void test_parse_sorted_inputs_option(void **state) {
+    char *args[] = {"merge-ip", "--sorted", "-f", "a.txt", "--file=b.txt", "-f", "c.txt"};
+    CommandLineOptions options = parse_command_line_options(7, args);
+    assert_true(options.sorted);
+    assert_int_equal(options.file_count, 3);
+    assert_string_equal(options.files[0], "a.txt");
+    assert_string_equal(options.files[1], "b.txt");
+    assert_string_equal(options.files[2], "c.txt");
+    free_command_line_options(&options);
+
+    char *default_args[] = {"merge-ip"};
+    options = parse_command_line_options(1, default_args);
+    assert_false(options.sorted);
+    assert_int_equal(options.file_count, 0);
+    assert_null(options.files);
+}
+
+void test_parse_max_memory_option(void **state) {
+    char *short_args[] = {"merge-ip", "-m", "64M"};
+    CommandLineOptions options = parse_command_line_options(3, short_args);
+    assert_int_equal(options.max_memory, 64 * 1024 * 1024);
+
+    char *long_args[] = {"merge-ip", "--max-memory=1G"};
+    options = parse_command_line_options(2, long_args);
+    assert_int_equal(options.max_memory, 1024 * 1024 * 1024);
+
+    char *default_args[] = {"merge-ip"};
+    options = parse_command_line_options(1, default_args);
+    assert_int_equal(options.max_memory, 0);
 }
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "dedup.h"
+#include "merge.h"
+#include "reader.h"
+
+
+void test_dedup_set_finds_duplicates(void **state) {
+    // enough keys to make the set grow a few times
+    const uint32_t key_count = 4 * DEDUP_INITIAL_CAPACITY;
+
+    DedupSet set;
+    init_dedup_set(&set);
+
+    // the key 0 is stored apart from the slots
+    assert_true(insert_dedup_key(&set, get_dedup_key(0, 0)));
+    assert_false(insert_dedup_key(&set, get_dedup_key(0, 0)));
+
+    for (uint32_t i = 1; i < key_count; i++) {
+        assert_true(insert_dedup_key(&set, get_dedup_key(i << 8, i << 8 | 0xFF)));
+    }
+    assert_true(set.capacity > DEDUP_INITIAL_CAPACITY);
+
+    // the same start with another end is a different range
+    assert_true(insert_dedup_key(&set, get_dedup_key(1 << 8, 1 << 8)));
+    for (uint32_t i = 1; i < key_count; i++) {
+        assert_false(insert_dedup_key(&set, get_dedup_key(i << 8, i << 8 | 0xFF)));
+    }
+
+    assert_int_equal(set.stats.entries, 2 * (size_t)key_count + 1);
+    assert_int_equal(set.stats.duplicates, key_count);
+
+    clear_dedup_set(&set);
+    assert_int_equal(set.capacity, DEDUP_INITIAL_CAPACITY);
+    assert_true(insert_dedup_key(&set, get_dedup_key(0, 0)));
+    assert_true(insert_dedup_key(&set, get_dedup_key(1 << 8, 1 << 8 | 0xFF)));
+    assert_int_equal(set.stats.duplicates, key_count);
+
+    free_dedup_set(&set);
+}
+
+
+void test_read_with_dedup(void **state) {
+    // every entry is repeated 4 times, the hosts as well as the ranges
+    const size_t entries = 50000;
+    const size_t repeats = 4;
+    char *content = malloc(entries * repeats * strlen("10.255.255.255/24\n") + 1);
+    assert_non_null(content);
+
+    size_t length = 0;
+    for (size_t r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < entries; i++) {
+            length += (size_t)sprintf(content + length, i % 2 ? "10.%zu.%zu.0/24\n" : "11.%zu.%zu.1\n",
+                                      (i >> 8) & 0xFF, i & 0xFF);
+        }
+    }
+
+    const unsigned THREADS[] = {1, 4};
+    for (size_t t = 0; t < sizeof(THREADS) / sizeof(THREADS[0]); t++) {
+        DedupSet set;
+        init_dedup_set(&set);
+        const ReaderOptions options = {.threads = THREADS[t], .dedup = &set};
+        ipRangeList *list = read_from_memory(content, length, &options);
+        ipRangeList *expected = read_from_memory(content, length, NULL);
+
+        // the duplicates are dropped no matter how the input is split between the threads
+        assert_int_equal(set.stats.entries, entries * repeats);
+        assert_int_equal(set.stats.duplicates, entries * (repeats - 1));
+        assert_int_equal(list->length + list->host_count, entries);
+
+        // the set is shared by the inputs, so another one drops the entries seen in the first
+        ipRangeList *repeated = read_from_memory(content, length, &options);
+        assert_int_equal(repeated->length + repeated->host_count, 0);
+        assert_int_equal(set.stats.duplicates, entries * (2 * repeats - 1));
+        freeIpRangeList(repeated);
+        free_dedup_set(&set);
+
+        merge_cidr_in_place(list, NULL);
+        merge_cidr_in_place(expected, NULL);
+        assert_int_equal(list->length, expected->length);
+        assert_memory_equal(list->cidrs, expected->cidrs, list->length * sizeof(ipRange));
+
+        freeIpRangeList(expected);
+        freeIpRangeList(list);
+    }
+
+    free(content);
+}
@@ -26,14 +26,59 @@
 #endif
 
 void test_parse_command_line_options(void **state);
+void test_parse_buffer_size_option(void **state);
+void test_parse_jobs_option(void **state);
+void test_parse_output_option(void **state);
+void test_parse_engine_option(void **state);
+void test_parse_online_option(void **state);
+void test_parse_max_memory_option(void **state);
+void test_parse_sorted_inputs_option(void **state);
 void test_empty_data_set(void **state);
 void test_noise_data_set(void **state);
 void test_merge_cidr_separated_by_new_line(void **state);
 void test_merge_cidr_separated_by_space(void **state);
 void test_merge_cidr_separated_by_tab(void **state);
+void test_merge_cidr_read_from_memory(void **state);
+void test_read_from_memory_in_parallel(void **state);
+void test_read_from_stream_pipelined(void **state);
+void test_read_online(void **state);
+void test_read_with_memory_limit(void **state);
+void test_merge_sorted_inputs(void **state);
+void test_read_from_files(void **state);
+void test_read_from_file_with_async_io(void **state);
+void test_write_ip_ranges_in_parallel(void **state);
+void test_merge_cidr_in_parallel(void **state);
+void test_merge_cidr_of_merged_ranges(void **state);
+void test_merge_cidr_with_hosts(void **state);
+void test_merge_cidr_engines_match_radix(void **state);
+void test_plan_merge_engine(void **state);
+void test_merge_cidr_in_place(void **state);
+void test_ip_range_list_growth(void **state);
 void test_reading_buffer_captures_only_host_part_of_tailing_cidr(void **state);
 void test_reading_buffer_captures_broken_part_of_tailing_cidr(void **state);
 void test_reading_buffer_captures_only_part_of_tailing_cidr_prefix(void **state);
+void test_parse_content_handles_tokens_split_between_chunks(void **state);
+void test_parse_content_skips_invalid_tokens(void **state);
+void test_parse_content_reports_bad_octet(void **state);
+void test_parse_content_matches_state_machine(void **state);
+void test_parse_content_checks_token_order(void **state);
+void test_scanner_matches_scalar_implementation(void **state);
+void test_scanner_classifies_blocks(void **state);
+void test_sort_ip_ranges_matches_qsort(void **state);
+void test_sort_ip_ranges_in_parallel_matches_sequential_sort(void **state);
+void test_scan_ip_range_order(void **state);
+void test_merge_sorted_runs_matches_sort(void **state);
+void test_sort_ip_hosts_matches_qsort(void **state);
+void test_file_writer_replaces_output_on_close(void **state);
+void test_split_range_to_cidrs(void **state);
+void test_sweeper_matches_scalar_implementation(void **state);
+void test_spilled_runs_keep_ranges(void **state);
+void test_merge_range_streams_matches_merge_cidr(void **state);
+void test_spilled_runs_are_compacted(void **state);
+void test_dedup_set_finds_duplicates(void **state);
+void test_read_with_dedup(void **state);
+void test_spsc_queue_keeps_order(void **state);
+void test_thread_pool_runs_every_task_once(void **state);
 
 int main(void) {
     #ifdef _WIN32
@@ -46,14 +91,59 @@ int main(void) {
 
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_parse_command_line_options),
+            cmocka_unit_test(test_parse_buffer_size_option),
+            cmocka_unit_test(test_parse_jobs_option),
+            cmocka_unit_test(test_parse_output_option),
+            cmocka_unit_test(test_parse_engine_option),
+            cmocka_unit_test(test_parse_online_option),
+            cmocka_unit_test(test_parse_max_memory_option),
+            cmocka_unit_test(test_parse_sorted_inputs_option),
             cmocka_unit_test(test_empty_data_set),
             cmocka_unit_test(test_noise_data_set),
             cmocka_unit_test(test_merge_cidr_separated_by_new_line),
             cmocka_unit_test(test_merge_cidr_separated_by_space),
             cmocka_unit_test(test_merge_cidr_separated_by_tab),
+            cmocka_unit_test(test_merge_cidr_read_from_memory),
+            cmocka_unit_test(test_read_from_memory_in_parallel),
+            cmocka_unit_test(test_read_from_stream_pipelined),
+            cmocka_unit_test(test_read_online),
+            cmocka_unit_test(test_read_with_memory_limit),
+            cmocka_unit_test(test_merge_sorted_inputs),
+            cmocka_unit_test(test_read_from_files),
+            cmocka_unit_test(test_read_from_file_with_async_io),
+            cmocka_unit_test(test_write_ip_ranges_in_parallel),
+            cmocka_unit_test(test_merge_cidr_in_parallel),
+            cmocka_unit_test(test_merge_cidr_of_merged_ranges),
+            cmocka_unit_test(test_merge_cidr_with_hosts),
+            cmocka_unit_test(test_merge_cidr_engines_match_radix),
+            cmocka_unit_test(test_plan_merge_engine),
+            cmocka_unit_test(test_merge_cidr_in_place),
+            cmocka_unit_test(test_ip_range_list_growth),
             cmocka_unit_test(test_reading_buffer_captures_only_host_part_of_tailing_cidr),
             cmocka_unit_test(test_reading_buffer_captures_broken_part_of_tailing_cidr),
             cmocka_unit_test(test_reading_buffer_captures_only_part_of_tailing_cidr_prefix),
+            cmocka_unit_test(test_parse_content_handles_tokens_split_between_chunks),
+            cmocka_unit_test(test_parse_content_skips_invalid_tokens),
+            cmocka_unit_test(test_parse_content_reports_bad_octet),
+            cmocka_unit_test(test_parse_content_matches_state_machine),
+            cmocka_unit_test(test_parse_content_checks_token_order),
+            cmocka_unit_test(test_scanner_matches_scalar_implementation),
+            cmocka_unit_test(test_scanner_classifies_blocks),
+            cmocka_unit_test(test_sort_ip_ranges_matches_qsort),
+            cmocka_unit_test(test_sort_ip_ranges_in_parallel_matches_sequential_sort),
+            cmocka_unit_test(test_scan_ip_range_order),
+            cmocka_unit_test(test_merge_sorted_runs_matches_sort),
+            cmocka_unit_test(test_sort_ip_hosts_matches_qsort),
+            cmocka_unit_test(test_file_writer_replaces_output_on_close),
+            cmocka_unit_test(test_split_range_to_cidrs),
+            cmocka_unit_test(test_sweeper_matches_scalar_implementation),
+            cmocka_unit_test(test_spilled_runs_keep_ranges),
+            cmocka_unit_test(test_merge_range_streams_matches_merge_cidr),
+            cmocka_unit_test(test_spilled_runs_are_compacted),
+            cmocka_unit_test(test_dedup_set_finds_duplicates),
+            cmocka_unit_test(test_read_with_dedup),
+            cmocka_unit_test(test_spsc_queue_keeps_order),
+            cmocka_unit_test(test_thread_pool_runs_every_task_once),
     };
 
     const int tests_result = cmocka_run_group_tests(tests, NULL, NULL);
@@ -20,6 +20,7 @@
 #include <setjmp.h>
 #include <cmocka.h>
 
+#include "kway.h"
 #include "merge.h"
 #include "reader.h"
 #include "ipRange.h"
@@ -29,6 +30,9 @@ const char ALPHA_NUMERIC[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmn
 // will never generate CIDR blocks with the correct format!
 const char SEPARATORS[] = " \t\n\r\v\f-_()[]\\/;,%$@!&$%*+=~`\"'<>?";
 
+// the smallest buffer makes the reading loop split CIDRs between chunks
+const ReaderOptions SMALL_BUFFER = {.buffer_size = MIN_READ_BUFFER_SIZE};
+
 typedef struct {
     const char **input_cidr_list;
     const size_t input_count;
@@ -100,6 +104,21 @@ const TestCase test_cases[] = {
                               "10.11.0.0/16\n"
                               "192.168.100.0/22\n",
         .expected_count = 8
+    },
+    {
+        // the first and the last addresses
+        .input_cidr_list = (const char *[]){"255.255.255.255", "10.0.0.0/8", "0.0.0.0/8", "255.255.255.254/32"},
+        .input_count = 4,
+        .expected_cidr_list = "0.0.0.0/8\n"
+                              "10.0.0.0/8\n"
+                              "255.255.255.254/31\n",
+        .expected_count = 3
+    },
+    {
+        .input_cidr_list = (const char *[]){"1.2.3.4", "0.0.0.0/0"},
+        .input_count = 2,
+        .expected_cidr_list = "0.0.0.0/0\n",
+        .expected_count = 1
     }
 };
 
@@ -195,10 +214,10 @@ MergedTestCase merge_test_case(const TestCase* test_case, const char* separator)
     open_stream(&data_stream, max_buffer_length);
     write_to_test_data_stream(&data_stream, test_case, separator);
 
-    const ipRangeList *range_list = read_from_stream(data_stream.stream);
+    const ipRangeList *range_list = read_from_stream(data_stream.stream, &SMALL_BUFFER);
     close_stream(&data_stream);
 
-    const ipRangeList *merged_ip_ranges = merge_cidr(range_list);
+    const ipRangeList *merged_ip_ranges = merge_cidr(range_list, NULL);
 
     TestDataStream result_stream;
     open_stream(&result_stream, max_buffer_length);
@@ -249,6 +268,345 @@ void test_merge_cidr_separated_by_tab(void **state) {
     }
 }
 
+void test_merge_cidr_read_from_memory(void **state) {
+    for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+        const size_t max_buffer_length = get_length(&test_cases[i], "\n");
+
+        // no trailing separator and no NUL-terminator: the last CIDR ends with the buffer
+        char *content = get_buffer(max_buffer_length);
+        size_t content_length = 0;
+        for (size_t item = 0; item < test_cases[i].input_count; item++) {
+            content_length += (size_t)sprintf(content + content_length, "%s%s",
+                                              item ? "\n" : "", test_cases[i].input_cidr_list[item]);
+        }
+
+        const ipRangeList *range_list = read_from_memory(content, content_length, NULL);
+        free(content);
+
+        const ipRangeList *merged_ip_ranges = merge_cidr(range_list, NULL);
+
+        TestDataStream result_stream;
+        open_stream(&result_stream, max_buffer_length);
+        const size_t count = write_ip_ranges_to_file(merged_ip_ranges, result_stream.stream);
+        read_from_test_data_stream(&result_stream);
+        fclose(result_stream.stream);
+
+        assert_int_equal(count, test_cases[i].expected_count);
+        assert_string_equal(result_stream.buffer, test_cases[i].expected_cidr_list);
+
+        free(result_stream.buffer);
+    }
+}
+
+void test_read_from_memory_in_parallel(void **state) {
+    // 10.0.0.0 - 10.1.255.255, in reverse order, one per line: that's large enough to be split between threads
+    const size_t hosts = 1 << 17;
+    char *content = get_buffer(hosts * strlen("10.255.255.255\n") + 1);
+    size_t content_length = 0;
+    for (size_t i = hosts; i-- > 0;) {
+        content_length += (size_t)sprintf(content + content_length, "10.%zu.%zu.%zu\n", i >> 16, (i >> 8) & 0xFF, i & 0xFF);
+    }
+
+    const ReaderOptions options = {.threads = 4};
+    const ipRangeList *range_list = read_from_memory(content, content_length, &options);
+    free(content);
+    assert_int_equal(range_list->host_count, hosts);
+
+    const ipRangeList *merged_ip_ranges = merge_cidr(range_list, NULL);
+
+    TestDataStream result_stream;
+    open_stream(&result_stream, 64);
+    const size_t count = write_ip_ranges_to_file(merged_ip_ranges, result_stream.stream);
+    read_from_test_data_stream(&result_stream);
+    fclose(result_stream.stream);
+
+    assert_int_equal(count, 1);
+    assert_string_equal(result_stream.buffer, "10.0.0.0/15\n");
+
+    free(result_stream.buffer);
+}
+
+void test_read_from_stream_pipelined(void **state) {
+    // the hosts in reverse order with junk tokens longer than a block in between: the junk
+    // is skipped even when it ends with something looking like an IP address
+    const size_t hosts = 1 << 16;
+    const size_t junk_length = 3 * MIN_READ_BUFFER_SIZE;
+    const size_t capacity = hosts * strlen("10.255.255.255\n") + 8 * (junk_length + 16);
+    char *content = get_buffer(capacity);
+    size_t content_length = 0;
+    for (size_t i = hosts; i-- > 0;) {
+        content_length += (size_t)sprintf(content + content_length, "10.%zu.%zu.%zu\n", i >> 16, (i >> 8) & 0xFF, i & 0xFF);
+        if (i % (hosts / 8) == 0) {
+            memset(content + content_length, 'x', junk_length);
+            content_length += junk_length;
+            content_length += (size_t)sprintf(content + content_length, "1.2.3.4\n");
+        }
+    }
+
+    TestDataStream data_stream;
+    open_stream(&data_stream, content_length + 1);
+    fwrite(content, 1, content_length, data_stream.stream);
+    rewind(data_stream.stream);
+    free(content);
+
+    const ReaderOptions options = {.buffer_size = MIN_READ_BUFFER_SIZE, .threads = 3};
+    ipRangeList *range_list = read_from_stream(data_stream.stream, &options);
+    close_stream(&data_stream);
+    assert_int_equal(range_list->host_count, hosts);
+    assert_int_equal(range_list->length, 0);
+
+    merge_cidr_in_place(range_list, NULL);
+    assert_int_equal(range_list->length, 1);
+    assert_int_equal(range_list->cidrs[0].min_ip.s_addr, 0x0A000000);
+    assert_int_equal(range_list->cidrs[0].max_ip.s_addr, 0x0A00FFFF);
+
+    freeIpRangeList(range_list);
+}
+
+void test_read_online(void **state) {
+    // 10.0.0.0 - 10.11.255.255 as hosts, interleaved with a few ranges out of order:
+    // the staged entries are merged several times, so the list never holds the whole input
+    const size_t hosts = 3 * ONLINE_STAGING_SIZE;
+    char *content = get_buffer(hosts * strlen("10.255.255.255\n") + 1);
+    size_t content_length = 0;
+    for (size_t i = 0; i < hosts; i++) {
+        const size_t host = i * 7 % hosts;
+        content_length += (size_t)sprintf(content + content_length, "10.%zu.%zu.%zu\n",
+                                          host >> 16, (host >> 8) & 0xFF, host & 0xFF);
+        if (i % 100000 == 0) {
+            content_length += (size_t)sprintf(content + content_length, "192.168.%zu.0/24\n", 10 - i / 100000);
+        }
+    }
+
+    // the memory input and the stream one (the smallest buffer splits CIDRs between chunks)
+    const ReaderOptions memory_options = {.online = true};
+    const ReaderOptions stream_options = {.online = true, .buffer_size = MIN_READ_BUFFER_SIZE};
+    TestDataStream data_stream;
+    open_stream(&data_stream, content_length + 1);
+    fwrite(content, 1, content_length, data_stream.stream);
+    rewind(data_stream.stream);
+
+    ipRangeList *lists[] = {
+        read_from_memory(content, content_length, &memory_options),
+        read_from_stream(data_stream.stream, &stream_options),
+    };
+    close_stream(&data_stream);
+    free(content);
+
+    for (size_t l = 0; l < sizeof(lists) / sizeof(lists[0]); l++) {
+        assert_true(lists[l]->length + lists[l]->host_count <= 2 * ONLINE_STAGING_SIZE);
+
+        merge_cidr_in_place(lists[l], NULL);
+        const ipRange expected[] = {
+            {.min_ip = {0x0A000000}, .max_ip = {0x0A0BFFFF}},
+            {.min_ip = {0xC0A80300}, .max_ip = {0xC0A80AFF}},
+        };
+        assert_int_equal(lists[l]->length, sizeof(expected) / sizeof(expected[0]));
+        assert_memory_equal(lists[l]->cidrs, expected, sizeof(expected));
+
+        freeIpRangeList(lists[l]);
+    }
+}
+
+void test_read_with_memory_limit(void **state) {
+    // disjoint /24 blocks in random order and hosts: they don't collapse,
+    // so they're spilled to several runs, which are merged with the rest of the list at the end
+    const size_t blocks = 1 << 17;
+    char *content = get_buffer(blocks * strlen("11.255.255.0/24\n12.255.255.255\n") + 1);
+    size_t content_length = 0;
+    for (size_t i = 0; i < blocks; i++) {
+        const size_t block = i * 5 % blocks;
+        content_length += (size_t)sprintf(content + content_length, "%zu.%zu.%zu.0/24\n",
+                                          10 + (block >> 16), (block >> 8) & 0xFF, block & 0xFF);
+        if (i % 3 == 0) {
+            content_length += (size_t)sprintf(content + content_length, "12.%zu.%zu.1\n",
+                                              (block >> 8) & 0xFF, block & 0xFF);
+        }
+    }
+
+    SpillRuns runs = {0};
+    const ReaderOptions options = {.max_memory = 1024 * 1024, .spill_runs = &runs};
+    ipRangeList *list = read_from_memory(content, content_length, &options);
+    ipRangeList *expected = read_from_memory(content, content_length, NULL);
+    merge_cidr_in_place(expected, NULL);
+    free(content);
+
+    assert_true(runs.count > 1);
+    assert_true(list->length + list->host_count < options.max_memory / sizeof(ipRange));
+
+    merge_cidr_in_place(list, NULL);
+    open_spilled_runs(&runs, MIN_SPILL_BUFFER_SIZE);
+
+    RangeStream streams[64];
+    assert_true(runs.count < sizeof(streams) / sizeof(streams[0]));
+    for (size_t i = 0; i < runs.count; i++) {
+        streams[i] = (RangeStream){.next = next_spilled_range, .source = &runs.runs[i]};
+    }
+    ListCursor cursor = {.list = list, .position = 0};
+    streams[runs.count] = (RangeStream){.next = next_list_range, .source = &cursor};
+
+    TestDataStream result_stream;
+    open_stream(&result_stream, 8 * 1024 * 1024);
+    Writer *writer = open_stream_writer(result_stream.stream);
+    const size_t count = merge_range_streams(streams, runs.count + 1, writer);
+    close_writer(writer);
+    read_from_test_data_stream(&result_stream);
+
+    // 10.0.0.0/7 and the hosts
+    assert_int_equal(count, 1 + (blocks + 2) / 3);
+    assert_int_equal(expected->length, count);
+    assert_string_equal(strtok(result_stream.buffer, "\n"), "10.0.0.0/7");
+
+    close_stream(&result_stream);
+    free_spilled_runs(&runs);
+    freeIpRangeList(expected);
+    freeIpRangeList(list);
+}
+
+void test_merge_sorted_inputs(void **state) {
+    // the outputs of merge-ip, the second one with a host out of a range and the ranges
+    // separated by spaces; the third one is empty
+    const char *inputs[] = {
+        "10.0.0.0/24\n10.0.1.5\n10.0.2.0/23\n192.168.0.0/16\n",
+        "10.0.1.0/24 10.0.1.7 10.0.4.0/22\n172.16.0.0/12",
+        "",
+    };
+    const size_t input_count = sizeof(inputs) / sizeof(inputs[0]);
+
+    TestDataStream files[3];
+    SortedReader *readers[3];
+    RangeStream streams[3];
+    for (size_t i = 0; i < input_count; i++) {
+        open_stream(&files[i], strlen(inputs[i]) + 1);
+        fputs(inputs[i], files[i].stream);
+        rewind(files[i].stream);
+        readers[i] = open_sorted_reader(files[i].stream, "test", &SMALL_BUFFER);
+        streams[i] = (RangeStream){.next = next_sorted_range, .source = readers[i]};
+    }
+
+    TestDataStream result_stream;
+    open_stream(&result_stream, 1024);
+    Writer *writer = open_stream_writer(result_stream.stream);
+    const size_t count = merge_range_streams(streams, input_count, writer);
+    close_writer(writer);
+    read_from_test_data_stream(&result_stream);
+
+    assert_int_equal(count, 3);
+    assert_string_equal(result_stream.buffer, "10.0.0.0/21\n172.16.0.0/12\n192.168.0.0/16\n");
+
+    close_stream(&result_stream);
+    for (size_t i = 0; i < input_count; i++) {
+        close_sorted_reader(readers[i]);
+        close_stream(&files[i]);
+    }
+}
+
+void test_read_from_files(void **state) {
+    char filenames[2][32];
+    const char *contents[] = {"10.0.0.0/24\n10.0.2.0/24\n", "10.0.1.0/24 10.0.3.1\n"};
+    const char *names[2];
+    for (size_t i = 0; i < 2; i++) {
+        snprintf(filenames[i], sizeof(filenames[i]), "test_read_from_files_%zu.txt", i);
+        names[i] = filenames[i];
+        FILE *file = fopen(names[i], "w");
+        assert_non_null(file);
+        fputs(contents[i], file);
+        fclose(file);
+    }
+
+    ipRangeList *list = read_from_files(names, 2, NULL);
+    assert_int_equal(list->length, 3);
+    assert_int_equal(list->host_count, 1);
+
+    merge_cidr_in_place(list, NULL);
+    assert_int_equal(list->length, 2);
+    assert_int_equal(list->cidrs[0].min_ip.s_addr, 0x0A000000);
+    assert_int_equal(list->cidrs[0].max_ip.s_addr, 0x0A0002FF);
+    assert_int_equal(list->cidrs[1].min_ip.s_addr, 0x0A000301);
+    assert_int_equal(list->cidrs[1].max_ip.s_addr, 0x0A000301);
+
+    freeIpRangeList(list);
+    for (size_t i = 0; i < 2; i++) {
+        remove(names[i]);
+    }
+}
+
+void test_read_from_file_with_async_io(void **state) {
+    const char *filename = "test_read_from_file_with_async_io.txt";
+    FILE *file = fopen(filename, "w");
+    assert_non_null(file);
+    // far more blocks of the smallest buffer than the reads in flight, with the tokens split between them
+    for (unsigned i = 0; i < 20000; i++) {
+        fprintf(file, i % 3 ? "10.%u.%u.0/24\n" : "192.168.%u.%u ", i % 251, i % 256);
+    }
+    fclose(file);
+
+    for (unsigned online = 0; online < 2; online++) {
+        const ReaderOptions options = {.buffer_size = MIN_READ_BUFFER_SIZE, .online = online};
+        const ReaderOptions async_options = {.buffer_size = MIN_READ_BUFFER_SIZE, .online = online, .async_io = true};
+
+        ipRangeList *expected = read_from_file(filename, &options);
+        ipRangeList *list = read_from_file(filename, &async_options);
+        merge_cidr_in_place(expected, NULL);
+        merge_cidr_in_place(list, NULL);
+
+        assert_int_equal(list->length, expected->length);
+        assert_memory_equal(list->cidrs, expected->cidrs, expected->length * sizeof(ipRange));
+
+        freeIpRangeList(list);
+        freeIpRangeList(expected);
+    }
+
+    remove(filename);
+}
+
+void test_write_ip_ranges_in_parallel(void **state) {
+    const char *filenames[] = {"test_write_ip_ranges_serial.txt", "test_write_ip_ranges_parallel.txt"};
+    // a few rounds of the chunks of 3 threads, the last of them incomplete
+    const size_t length = 250000;
+
+    ipRangeList *list = getIpRangeList(length);
+    uint32_t address = 0x01000000;
+    for (size_t i = 0; i < length; i++) {
+        // the gaps keep the ranges apart, so they are merged already
+        address += 2 + (uint32_t)rand() % 64;
+        const uint32_t size = (uint32_t)rand() % 300;
+        const ipRange range = {.min_ip = {address}, .max_ip = {address + size}};
+        appendIpRange(list, &range);
+        address += size;
+    }
+
+    // a file writer goes through the file descriptor, i.e. `writev()`
+    size_t counts[2];
+    for (size_t i = 0; i < 2; i++) {
+        Writer *writer = open_file_writer(filenames[i]);
+        counts[i] = i ? write_ip_ranges_in_parallel(list, writer, 3) : write_ip_ranges(list, writer);
+        close_writer(writer);
+    }
+    assert_int_equal(counts[1], counts[0]);
+
+    char *contents[2];
+    long sizes[2];
+    for (size_t i = 0; i < 2; i++) {
+        FILE *file = fopen(filenames[i], "rb");
+        assert_non_null(file);
+        fseek(file, 0, SEEK_END);
+        sizes[i] = ftell(file);
+        rewind(file);
+        contents[i] = malloc((size_t)sizes[i] + 1);
+        assert_non_null(contents[i]);
+        assert_int_equal(fread(contents[i], 1, (size_t)sizes[i], file), (size_t)sizes[i]);
+        fclose(file);
+        remove(filenames[i]);
+    }
+    assert_int_equal(sizes[1], sizes[0]);
+    assert_memory_equal(contents[1], contents[0], (size_t)sizes[0]);
+
+    free(contents[1]);
+    free(contents[0]);
+    freeIpRangeList(list);
+}
+
 void merge_cidr_separated_by_page(const size_t page_size) {
     if (page_size == 0) {
         return;
@@ -293,10 +651,10 @@ void test_empty_data_set(void **state) {
     fprintf(data_stream.stream, "%s", empty_page);
     free((void*)empty_page);
 
-    const ipRangeList *range_list = read_from_stream(data_stream.stream);
+    const ipRangeList *range_list = read_from_stream(data_stream.stream, &SMALL_BUFFER);
     close_stream(&data_stream);
 
-    const ipRangeList *merged_ip_ranges = merge_cidr(range_list);
+    const ipRangeList *merged_ip_ranges = merge_cidr(range_list, NULL);
 
     TestDataStream result_stream;
     open_stream(&result_stream, max_buffer_length);
@@ -362,10 +720,10 @@ void test_noise_data_set(void **state) {
     fprintf(data_stream.stream, "%s", noise_data);
     free((void*)noise_data);
 
-    const ipRangeList *range_list = read_from_stream(data_stream.stream);
+    const ipRangeList *range_list = read_from_stream(data_stream.stream, &SMALL_BUFFER);
     close_stream(&data_stream);
 
-    const ipRangeList *merged_ip_ranges = merge_cidr(range_list);
+    const ipRangeList *merged_ip_ranges = merge_cidr(range_list, NULL);
 
     TestDataStream result_stream;
     open_stream(&result_stream, max_buffer_length);
@@ -386,7 +744,7 @@ void test_reading_buffer_captures_only_host_part_of_tailing_cidr(void **state) {
     //
     // assuming buffer size is `1024`, we need to put 999 symbols as a
     // separator between CIDRs
-    // BUFFER_SIZE - strlen("192.168.0.0/24") + strlen("192.168.1.0") == 999
+    // MIN_READ_BUFFER_SIZE - strlen("192.168.0.0/24") + strlen("192.168.1.0") == 999
     merge_cidr_separated_by_page(999);
 }
 
@@ -404,6 +762,240 @@ void test_reading_buffer_captures_only_part_of_tailing_cidr_prefix(void **state)
     //
     // assuming buffer size is `1024`, we need to put 1001 symbols as a
     // separator between CIDRs
-    // BUFFER_SIZE - strlen("192.168.0.0/24") + strlen("192.168.1.0/2") == 999
+    // MIN_READ_BUFFER_SIZE - strlen("192.168.0.0/24") + strlen("192.168.1.0/2") == 999
     merge_cidr_separated_by_page(997);
 }
+
+void test_ip_range_list_growth(void **state) {
+    ipRangeList *range_list = getIpRangeList(0);
+    assert_int_equal(range_list->capacity, 0);
+
+    // appending to an empty list must not divide by zero or write past the buffer
+    for (uint32_t i = 0; i < 1000; i++) {
+        appendIpRange(range_list, &(ipRange){.min_ip = {i}, .max_ip = {i}});
+        assert_true(range_list->capacity >= range_list->length);
+    }
+    assert_int_equal(range_list->length, 1000);
+
+    reserveIpRangeList(range_list, 5000);
+    assert_int_equal(range_list->capacity, 5000);
+    reserveIpRangeList(range_list, 10); // never shrinks
+    assert_int_equal(range_list->capacity, 5000);
+
+    shrinkIpRangeListToFit(range_list);
+    assert_int_equal(range_list->capacity, 1000);
+    for (uint32_t i = 0; i < 1000; i++) {
+        assert_int_equal(range_list->cidrs[i].min_ip.s_addr, i);
+    }
+
+    freeIpRangeList(range_list);
+}
+
+void test_merge_cidr_in_parallel(void **state) {
+    // random /24 - /32 blocks within 10.0.0.0/12: many of them overlap or touch each other across
+    // the boundaries of the chunks; the last round adds a range which reaches the last address
+    const size_t length = 300000;
+    const MergeOptions parallel = {.threads = 3, .engine = MERGE_ENGINE_RADIX};
+
+    for (unsigned round = 0; round < 2; round++) {
+        ipRangeList *sequential_input = getIpRangeList(length);
+        ipRangeList *parallel_input = getIpRangeList(length);
+
+        for (size_t i = 0; i < length; i++) {
+            const uint32_t size = 1u << (rand() % 9);
+            const uint32_t min_ip = (0x0A000000 | ((uint32_t)rand() & 0xFFFFF)) & ~(size - 1);
+            appendIpRange(sequential_input, &(ipRange){.min_ip = {min_ip}, .max_ip = {min_ip + size - 1}});
+        }
+        if (round) {
+            sequential_input->cidrs[length / 2] = (ipRange){.min_ip = {0x0A080000}, .max_ip = {0xFFFFFFFF}};
+        }
+        appendIpRanges(parallel_input, sequential_input->cidrs, sequential_input->length);
+
+        ipRangeList *expected = merge_cidr(sequential_input, NULL);
+        ipRangeList *merged = merge_cidr(parallel_input, &parallel);
+
+        assert_int_equal(merged->length, expected->length);
+        assert_memory_equal(merged->cidrs, expected->cidrs, expected->length * sizeof(ipRange));
+        if (round) {
+            assert_int_equal(merged->cidrs[merged->length - 1].max_ip.s_addr, 0xFFFFFFFF);
+        }
+
+        freeIpRangeList(merged);
+        freeIpRangeList(expected);
+        freeIpRangeList(parallel_input);
+        freeIpRangeList(sequential_input);
+    }
+}
+
+void test_merge_cidr_of_merged_ranges(void **state) {
+    // merging the output of the previous run must give the same output
+    ipRangeList *range_list = getIpRangeList(0);
+    for (uint32_t i = 0; i < 1000; i++) {
+        const uint32_t min_ip = 0x0A000000 + i * 0x1000;
+        appendIpRange(range_list, &(ipRange){.min_ip = {min_ip}, .max_ip = {min_ip + (i % 7) * 0x100 + 0xFF}});
+    }
+
+    ipRangeList *merged = merge_cidr(range_list, NULL);
+    ipRangeList *remerged = merge_cidr(merged, NULL);
+
+    assert_int_equal(merged->length, 1000);
+    assert_int_equal(remerged->length, merged->length);
+    assert_memory_equal(remerged->cidrs, merged->cidrs, merged->length * sizeof(ipRange));
+
+    freeIpRangeList(remerged);
+    freeIpRangeList(merged);
+    freeIpRangeList(range_list);
+}
+
+void test_merge_cidr_with_hosts(void **state) {
+    ipRangeList *range_list = getIpRangeList(0);
+    // 10.0.0.0/30 made of hosts (with a duplicate), joined to 10.0.0.4/30 and then to the host 10.0.0.8
+    const uint32_t hosts[] = {0x0A000003, 0x0A000008, 0x0A000001, 0x0A000000, 0x0A000002, 0x0A000001,
+                              0xC0A80001, 0xFFFFFFFF, 0x0A000010, 0x0A000020};
+    appendIpHosts(range_list, hosts, sizeof(hosts) / sizeof(hosts[0]));
+    appendIpRange(range_list, &(ipRange){.min_ip = {0x0A000004}, .max_ip = {0x0A000007}});
+    // covers the host 10.0.0.16
+    appendIpRange(range_list, &(ipRange){.min_ip = {0x0A000010}, .max_ip = {0x0A00001F}});
+
+    ipRangeList *merged = merge_cidr(range_list, NULL);
+
+    const ipRange expected[] = {
+        {.min_ip = {0x0A000000}, .max_ip = {0x0A000008}},
+        {.min_ip = {0x0A000010}, .max_ip = {0x0A000020}},
+        {.min_ip = {0xC0A80001}, .max_ip = {0xC0A80001}},
+        {.min_ip = {0xFFFFFFFF}, .max_ip = {0xFFFFFFFF}},
+    };
+    assert_int_equal(merged->length, sizeof(expected) / sizeof(expected[0]));
+    assert_memory_equal(merged->cidrs, expected, sizeof(expected));
+
+    freeIpRangeList(merged);
+    freeIpRangeList(range_list);
+}
+
+void test_merge_cidr_engines_match_radix(void **state) {
+    // ranges from single addresses up to several /16 pages, so the pages are empty, partial,
+    // and full; the hosts and the edges of the address space are added on top of them
+    const size_t length = 100000;
+    const MergeOptions radix = {.engine = MERGE_ENGINE_RADIX};
+    const MergeOptions qsort_engine = {.engine = MERGE_ENGINE_QSORT};
+    const MergeOptions bitmap = {.engine = MERGE_ENGINE_BITMAP};
+
+    ipRangeList *range_list = getIpRangeList(length);
+    for (size_t i = 0; i < length; i++) {
+        const uint32_t size = 1u << (rand() % 19);
+        const uint32_t min_ip = ((uint32_t)rand() << 12 ^ (uint32_t)rand()) & ~(size - 1);
+        appendIpRange(range_list, &(ipRange){.min_ip = {min_ip}, .max_ip = {min_ip + size - 1}});
+    }
+    appendIpRange(range_list, &(ipRange){.min_ip = {0x00000000}, .max_ip = {0x00000000}});
+    appendIpRange(range_list, &(ipRange){.min_ip = {0xFFFF0001}, .max_ip = {0xFFFFFFFF}});
+    for (size_t i = 0; i < length; i++) {
+        appendIpHost(range_list, (uint32_t)rand() << 8 ^ (uint32_t)rand());
+    }
+    appendIpHost(range_list, 0x00000001);
+    appendIpHost(range_list, 0xFFFF0000);
+
+    ipRangeList *merged = merge_cidr(range_list, &bitmap);
+    ipRangeList *sorted = merge_cidr(range_list, &qsort_engine);
+    ipRangeList *expected = merge_cidr(range_list, &radix);
+
+    assert_int_equal(merged->length, expected->length);
+    assert_memory_equal(merged->cidrs, expected->cidrs, expected->length * sizeof(ipRange));
+    assert_int_equal(sorted->length, expected->length);
+    assert_memory_equal(sorted->cidrs, expected->cidrs, expected->length * sizeof(ipRange));
+    assert_int_equal(merged->cidrs[0].min_ip.s_addr, 0x00000000);
+    assert_int_equal(merged->cidrs[merged->length - 1].max_ip.s_addr, 0xFFFFFFFF);
+
+    freeIpRangeList(expected);
+    freeIpRangeList(sorted);
+    freeIpRangeList(merged);
+
+    // the whole address space is a single full page run
+    ipRangeList *everything = getIpRangeList(0);
+    appendIpRange(everything, &(ipRange){.min_ip = {0x00000000}, .max_ip = {0xFFFFFFFF}});
+    appendIpHost(everything, 0x0A000001);
+
+    merged = merge_cidr(everything, &bitmap);
+    assert_int_equal(merged->length, 1);
+    assert_int_equal(merged->cidrs[0].min_ip.s_addr, 0x00000000);
+    assert_int_equal(merged->cidrs[0].max_ip.s_addr, 0xFFFFFFFF);
+
+    freeIpRangeList(merged);
+    freeIpRangeList(everything);
+    freeIpRangeList(range_list);
+}
+
+void test_plan_merge_engine(void **state) {
+    const MergeOptions radix = {.engine = MERGE_ENGINE_RADIX};
+    ipRangeList *range_list = getIpRangeList(0);
+
+    // the tiny inputs are sorted with qsort(), unless the engine is given explicitly
+    for (uint32_t i = 0; i < MAX_QSORT_INPUT_SIZE; i++) {
+        appendIpHost(range_list, i * 0x10000);
+    }
+    assert_int_equal(plan_merge_engine(range_list, NULL), MERGE_ENGINE_QSORT);
+    assert_int_equal(plan_merge_engine(range_list, &radix), MERGE_ENGINE_RADIX);
+
+    // the entries scattered over the address space: almost every one of them needs its own page
+    for (uint32_t i = MAX_QSORT_INPUT_SIZE; i < 0x10000; i++) {
+        appendIpHost(range_list, i * 0x10000);
+    }
+    assert_int_equal(plan_merge_engine(range_list, NULL), MERGE_ENGINE_RADIX);
+    freeIpRangeList(range_list);
+
+    // the dense ones share a few pages
+    range_list = getIpRangeList(0);
+    for (uint32_t i = 0; i < 0x10000; i++) {
+        appendIpHost(range_list, 0x0A000000 | (i * 7 & 0xFFFF));
+        appendIpRange(range_list, &(ipRange){.min_ip = {0x0B000000 + i * 4}, .max_ip = {0x0B000000 + i * 4 + 1}});
+    }
+    assert_int_equal(plan_merge_engine(range_list, NULL), MERGE_ENGINE_BITMAP);
+    freeIpRangeList(range_list);
+}
+
+void test_merge_cidr_in_place(void **state) {
+    const MergeOptions ENGINES[] = {
+        {.engine = MERGE_ENGINE_QSORT},
+        {.engine = MERGE_ENGINE_RADIX},
+        {.engine = MERGE_ENGINE_RADIX, .threads = 3},
+        {.engine = MERGE_ENGINE_BITMAP},
+    };
+    const size_t length = 200000;
+
+    // 0: random ranges and hosts, including the edges of the address space,
+    // 1: the hosts only, 2: canonical ranges (nothing to merge) with hosts between them
+    for (unsigned kind = 0; kind < 3; kind++) {
+        ipRangeList *input = getIpRangeList(0);
+        for (size_t i = 0; kind != 1 && i < length; i++) {
+            const uint32_t size = 1u << (rand() % 12);
+            const uint32_t min_ip = kind == 0 ? ((uint32_t)rand() << 8 ^ (uint32_t)rand()) & ~(size - 1)
+                                              : (uint32_t)i << 12;
+            appendIpRange(input, &(ipRange){.min_ip = {min_ip}, .max_ip = {min_ip + size - 1}});
+        }
+        for (size_t i = 0; i < length; i++) {
+            appendIpHost(input, kind == 2 ? (uint32_t)i << 12 | 0xFFF : (uint32_t)rand() << 4 ^ (uint32_t)rand());
+        }
+        if (kind == 0) {
+            appendIpRange(input, &(ipRange){.min_ip = {0xFFFFFF00}, .max_ip = {0xFFFFFFFF}});
+            appendIpHost(input, 0x00000000);
+            appendIpHost(input, 0xFFFFFEFF);
+        }
+
+        for (size_t e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); e++) {
+            ipRangeList *merged = getIpRangeList(0);
+            appendIpRanges(merged, input->cidrs, input->length);
+            appendIpHosts(merged, input->hosts, input->host_count);
+
+            ipRangeList *expected = merge_cidr(input, &ENGINES[e]);
+            merge_cidr_in_place(merged, &ENGINES[e]);
+
+            assert_int_equal(merged->host_count, 0);
+            assert_int_equal(merged->length, expected->length);
+            assert_memory_equal(merged->cidrs, expected->cidrs, expected->length * sizeof(ipRange));
+
+            freeIpRangeList(expected);
+            freeIpRangeList(merged);
+        }
+
+        freeIpRangeList(input);
+    }
+}
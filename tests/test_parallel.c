@@ -0,0 +1,79 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "parallel.h"
+
+
+typedef struct {
+    size_t runs;
+    uint64_t sum;
+} CountingTask;
+
+
+static void run_counting_task(void *argument) {
+    CountingTask *task = argument;
+    // a bit of work, so the idle threads have a chance to steal the tasks
+    for (uint64_t i = 0; i < 1000; i++) {
+        task->sum += i;
+    }
+    task->runs++;
+}
+
+
+static size_t count_incomplete_tasks(const CountingTask *tasks, const size_t count, const size_t rounds) {
+    size_t incomplete = 0;
+    for (size_t i = 0; i < count; i++) {
+        incomplete += tasks[i].runs != rounds || tasks[i].sum != rounds * 999 * 1000 / 2;
+    }
+    return incomplete;
+}
+
+
+void test_thread_pool_runs_every_task_once(void **state) {
+    // more tasks than a deque holds, so some of them are executed by the submitting thread
+    const size_t COUNTS[] = {1, 2, 7, 3000};
+    const size_t rounds = 3;
+
+    assert_true(get_cpu_count() >= 1);
+    assert_true(start_thread_pool(4, false) >= 1);
+
+    for (size_t c = 0; c < sizeof(COUNTS) / sizeof(COUNTS[0]); c++) {
+        CountingTask *tasks = calloc(COUNTS[c], sizeof(CountingTask));
+        assert_non_null(tasks);
+
+        for (size_t round = 0; round < rounds; round++) {
+            run_in_parallel(run_counting_task, tasks, sizeof(CountingTask), COUNTS[c]);
+        }
+        assert_int_equal(count_incomplete_tasks(tasks, COUNTS[c], rounds), 0);
+
+        free(tasks);
+    }
+
+    stop_thread_pool();
+
+    // without the pool, every task gets its own thread again
+    CountingTask tasks[3] = {{0, 0}, {0, 0}, {0, 0}};
+    run_in_parallel(run_counting_task, tasks, sizeof(CountingTask), 3);
+    assert_int_equal(count_incomplete_tasks(tasks, 3, 1), 0);
+}
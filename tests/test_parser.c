@@ -0,0 +1,168 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "parser.h"
+#include "ipRange.h"
+
+
+void test_parse_content_handles_tokens_split_between_chunks(void **state) {
+    const char *content = "10.0.0.1 192.168.1.0/24\n172.16.0.0/12";
+    ipRangeList *range_list = getIpRangeList(1);
+
+    CidrParser parser;
+    init_parser(&parser);
+    // the worst case: every chunk contains a single symbol
+    for (size_t i = 0; i < strlen(content); i++) {
+        parse_content(&parser, content + i, 1, range_list);
+    }
+    assert_int_equal(range_list->length + range_list->host_count, 2);
+    assert_int_equal(finish_parser(&parser, range_list), 1);
+
+    // the hosts are stored apart from the ranges
+    assert_int_equal(range_list->host_count, 1);
+    assert_int_equal(range_list->hosts[0], 0x0A000001);
+    assert_int_equal(range_list->length, 2);
+    assert_int_equal(range_list->cidrs[0].min_ip.s_addr, 0xC0A80100);
+    assert_int_equal(range_list->cidrs[0].max_ip.s_addr, 0xC0A801FF);
+    assert_int_equal(range_list->cidrs[1].min_ip.s_addr, 0xAC100000);
+    assert_int_equal(range_list->cidrs[1].max_ip.s_addr, 0xAC1FFFFF);
+
+    freeIpRangeList(range_list);
+}
+
+void test_parse_content_skips_invalid_tokens(void **state) {
+    const char *content = "1.2.3.4x a1.2.3.4 1.2.3 1.2.3.4.5 1.2.3.4/ 1.2.3.4/024 1234.1.1.1 "
+                          "256.1.1.1 01.2.3.4 1.2.3.4/33 10.1.2.3/8 0.0.0.0/0\t255.255.255.255";
+    ipRangeList *range_list = getIpRangeList(1);
+
+    CidrParser parser;
+    init_parser(&parser);
+    assert_int_equal(parse_content(&parser, content, strlen(content), range_list), 2);
+    assert_int_equal(finish_parser(&parser, range_list), 1);
+
+    assert_int_equal(range_list->length, 2);
+    assert_int_equal(range_list->cidrs[0].min_ip.s_addr, 0x0A000000);
+    assert_int_equal(range_list->cidrs[0].max_ip.s_addr, 0x0AFFFFFF);
+    assert_int_equal(range_list->cidrs[1].min_ip.s_addr, 0);
+    assert_int_equal(range_list->cidrs[1].max_ip.s_addr, 0xFFFFFFFF);
+    assert_int_equal(range_list->host_count, 1);
+    assert_int_equal(range_list->hosts[0], 0xFFFFFFFF);
+
+    freeIpRangeList(range_list);
+}
+
+
+void test_parse_content_reports_bad_octet(void **state) {
+    ipRangeList *range_list = getIpRangeList(1);
+    CidrParser parser;
+    init_parser(&parser);
+
+    // the octet is reported as it's written, not as the address it would make
+    assert_int_equal(parse_content(&parser, "1.002.3.4 ", 10, range_list), 0);
+    assert_int_equal(parser.bad_octet_position, 2);
+    assert_int_equal(parser.bad_octet_length, 3);
+    assert_int_equal(parser.bad_octet, 2);
+    assert_true(parser.leading_zero);
+
+    // the first invalid octet is reported
+    assert_int_equal(parse_content(&parser, "1.2.300.04/8 ", 13, range_list), 0);
+    assert_int_equal(parser.bad_octet_position, 3);
+    assert_int_equal(parser.bad_octet_length, 3);
+    assert_int_equal(parser.bad_octet, 300);
+    assert_false(parser.leading_zero);
+
+    assert_int_equal(parse_content(&parser, "0.10.100.0 ", 11, range_list), 1);
+    assert_int_equal(parser.bad_octet_position, 0);
+
+    freeIpRangeList(range_list);
+}
+
+
+void test_parse_content_matches_state_machine(void **state) {
+    // the well-formed tokens and the ones only the state machine can tell apart from them
+    const char *TOKENS[] = {
+        "10.0.0.1", "192.168.1.0/24", "255.255.255.255/32", "0.0.0.0/0", "1.2.3.4/01", "1.2.3.4/33",
+        "256.1.1.1", "01.2.3.4", "1.2.3.4/", "1.2.3", "1.2.3.4.5", "1.2.3.4/8/8", "1/2.3.4.5", "1.2.3.4x",
+        "1..2.3", "1234.1.1.1", "1.2.3.4/123", "x", "1.2.3.4/24.0.0.0/8", "99.99.99.99.99.99.99.99.99.99.99.99",
+    };
+    const char *SEPARATORS[] = {" ", "\n", "\t", "  ", "\r\n"};
+    const size_t token_count = sizeof(TOKENS) / sizeof(TOKENS[0]);
+    const size_t separator_count = sizeof(SEPARATORS) / sizeof(SEPARATORS[0]);
+
+    char content[32 * 1024];
+    size_t length = 0;
+    while (length < sizeof(content) - 64) {
+        length += (size_t)sprintf(content + length, "%s%s", TOKENS[rand() % token_count],
+                                  SEPARATORS[rand() % separator_count]);
+    }
+
+    // the state machine alone, since the portable scanner doesn't classify blocks
+    ipRangeList *expected = getIpRangeList(1);
+    CidrParser parser;
+    init_parser(&parser);
+    parser.scanner = get_scalar_scanner();
+    parse_content(&parser, content, length, expected);
+    finish_parser(&parser, expected);
+
+    // the chunks split the tokens as well as the blocks at any offset
+    const size_t CHUNK_SIZES[] = {length, 4096, 1000, 65, 63};
+    for (size_t c = 0; c < sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]); c++) {
+        ipRangeList *range_list = getIpRangeList(1);
+        init_parser(&parser);
+        for (size_t offset = 0; offset < length; offset += CHUNK_SIZES[c]) {
+            parse_content(&parser, content + offset, length - offset < CHUNK_SIZES[c] ? length - offset : CHUNK_SIZES[c],
+                          range_list);
+        }
+        finish_parser(&parser, range_list);
+
+        assert_int_equal(range_list->length, expected->length);
+        assert_memory_equal(range_list->cidrs, expected->cidrs, expected->length * sizeof(ipRange));
+        assert_int_equal(range_list->host_count, expected->host_count);
+        assert_memory_equal(range_list->hosts, expected->hosts, expected->host_count * sizeof(uint32_t));
+        freeIpRangeList(range_list);
+    }
+
+    freeIpRangeList(expected);
+}
+
+
+void test_parse_content_checks_token_order(void **state) {
+    ipRangeList *range_list = getIpRangeList(1);
+    CidrParser parser;
+    init_parser(&parser);
+    parser.check_order = true;
+
+    // the hosts are stored apart from the ranges, but the order is the order of the tokens
+    const char *sorted = "10.0.0.0/24 10.0.0.5 10.0.0.9 10.0.1.0/24 ";
+    parse_content(&parser, sorted, strlen(sorted), range_list);
+    assert_false(parser.out_of_order);
+
+    const char *unsorted = "10.0.1.0/24\n10.0.0.5\n";
+    init_parser(&parser);
+    parser.check_order = true;
+    parse_content(&parser, unsorted, strlen(unsorted), range_list);
+    assert_true(parser.out_of_order);
+
+    freeIpRangeList(range_list);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "parallel.h"
+#include "queue.h"
+
+
+#define QUEUE_TEST_ITEMS 100000
+
+
+typedef struct {
+    SpscQueue *queue;
+    bool is_producer;
+    size_t out_of_order;  // the items the consumer got out of order
+} QueueTestTask;
+
+
+static void run_queue_test_task(void *argument) {
+    QueueTestTask *task = argument;
+    if (task->is_producer) {
+        for (uintptr_t i = 1; i <= QUEUE_TEST_ITEMS; i++) {
+            push_spsc_queue(task->queue, (void *)i);
+        }
+        push_spsc_queue(task->queue, NULL);
+        return;
+    }
+
+    uintptr_t expected = 1;
+    void *item;
+    while ( (item = pop_spsc_queue(task->queue)) ) {
+        task->out_of_order += (uintptr_t)item != expected;
+        expected++;
+    }
+    task->out_of_order += expected != QUEUE_TEST_ITEMS + 1;
+}
+
+
+void test_spsc_queue_keeps_order(void **state) {
+    SpscQueue queue;
+    init_spsc_queue(&queue, 4);
+
+    // a single thread: the queue is bounded
+    void *item = NULL;
+    for (uintptr_t i = 1; i <= 4; i++) {
+        assert_true(try_push_spsc_queue(&queue, (void *)i));
+    }
+    assert_false(try_push_spsc_queue(&queue, NULL));
+    assert_true(try_pop_spsc_queue(&queue, &item));
+    assert_int_equal((uintptr_t)item, 1);
+    for (uintptr_t i = 2; i <= 4; i++) {
+        assert_true(try_pop_spsc_queue(&queue, &item));
+    }
+    assert_false(try_pop_spsc_queue(&queue, &item));
+
+    // the producer and the consumer in their own threads, the small queue makes them wait for each other
+    QueueTestTask tasks[2] = {
+        {.queue = &queue, .is_producer = true, .out_of_order = 0},
+        {.queue = &queue, .is_producer = false, .out_of_order = 0},
+    };
+    assert_true(run_concurrently(run_queue_test_task, tasks, sizeof(QueueTestTask), 2));
+    assert_int_equal(tasks[1].out_of_order, 0);
+
+    free_spsc_queue(&queue);
+}
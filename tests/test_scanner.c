@@ -0,0 +1,81 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "scanner.h"
+
+
+void test_scanner_matches_scalar_implementation(void **state) {
+    // a mix of whitespaces, CIDR symbols and bytes which are close to the whitespaces
+    const char ALPHABET[] = " \t\n\v\f\r\x08\x0E\x1F!0123456789./ax\x80\xFF";
+    const size_t length = 3 * SCAN_BLOCK_SIZE + 17;
+    char content[3 * SCAN_BLOCK_SIZE + 17];
+
+    const Scanner *scanner = get_scanner();
+    const Scanner *scalar = get_scalar_scanner();
+
+    for (unsigned round = 0; round < 64; round++) {
+        // the longer rounds give the vectorized scanner long runs without any match
+        const size_t run = round % 2 ? 1 : length;
+        for (size_t i = 0; i < length; i++) {
+            content[i] = (i % run == 0) ? ALPHABET[rand() % (sizeof(ALPHABET) - 1)] : (round % 4 ? ' ' : 'x');
+        }
+
+        for (size_t position = 0; position <= length; position++) {
+            assert_int_equal(
+                scanner->scan(content, position, length, FIND_SPACE),
+                scalar->scan(content, position, length, FIND_SPACE)
+            );
+            assert_int_equal(
+                scanner->scan(content, position, length, FIND_NON_SPACE),
+                scalar->scan(content, position, length, FIND_NON_SPACE)
+            );
+        }
+    }
+}
+
+
+void test_scanner_classifies_blocks(void **state) {
+    // the portable scanner has nothing to classify blocks with
+    const Scanner *scanner = get_scanner();
+    if (!scanner->classify) {
+        return;
+    }
+
+    const char ALPHABET[] = " \t\n\v\f\r\x08\x0E\x1F!-0123456789./:ax\x80\xFF";
+    char block[SCAN_BLOCK_SIZE];
+
+    for (unsigned round = 0; round < 256; round++) {
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++) {
+            block[i] = ALPHABET[rand() % (sizeof(ALPHABET) - 1)];
+        }
+
+        ByteClasses classes;
+        scanner->classify(block, &classes);
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++) {
+            const char symbol = block[i];
+            assert_int_equal(classes.spaces >> i & 1, is_space(symbol));
+            assert_int_equal(classes.symbols >> i & 1, (symbol >= '0' && symbol <= '9') || symbol == '.' || symbol == '/');
+            assert_int_equal(classes.dots >> i & 1, symbol == '.');
+            assert_int_equal(classes.slashes >> i & 1, symbol == '/');
+        }
+    }
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "sort.h"
+
+
+static uint32_t random_address(void) {
+    return (uint32_t)rand() << 16 ^ (uint32_t)rand();
+}
+
+
+void test_sort_ip_ranges_matches_qsort(void **state) {
+    const size_t LENGTHS[] = {0, 1, 2, SMALL_SORT_THRESHOLD - 1, SMALL_SORT_THRESHOLD, 1000, 100000};
+    const size_t max_length = 100000;
+
+    ipRange *ranges = malloc(max_length * sizeof(ipRange));
+    ipRange *expected = malloc(max_length * sizeof(ipRange));
+    assert_non_null(ranges);
+    assert_non_null(expected);
+
+    for (size_t l = 0; l < sizeof(LENGTHS) / sizeof(LENGTHS[0]); l++) {
+        const size_t length = LENGTHS[l];
+
+        // 0: random keys, 1: equal min_ip (only the secondary key differs),
+        // 2: keys which differ in the lowest bits only (most of the passes are skipped)
+        for (unsigned kind = 0; kind < 3; kind++) {
+            for (size_t i = 0; i < length; i++) {
+                const uint32_t min_ip = kind == 0 ? random_address()
+                                      : kind == 1 ? 0x0A000000
+                                      : 0x0A000000 | (random_address() & 0xFF);
+                const uint32_t max_ip = kind == 2 ? min_ip : min_ip | (random_address() & 0xFFFF);
+                ranges[i] = (ipRange){.min_ip = {min_ip}, .max_ip = {max_ip}};
+            }
+            if (length) {
+                memcpy(expected, ranges, length * sizeof(ipRange));
+            }
+
+            qsort(expected, length, sizeof(ipRange), compare_ip_ranges);
+            sort_ip_ranges(ranges, length);
+
+            for (size_t i = 0; i < length; i++) {
+                assert_int_equal(ranges[i].min_ip.s_addr, expected[i].min_ip.s_addr);
+                assert_int_equal(ranges[i].max_ip.s_addr, expected[i].max_ip.s_addr);
+            }
+        }
+    }
+
+    free(expected);
+    free(ranges);
+}
+
+
+void test_sort_ip_ranges_in_parallel_matches_sequential_sort(void **state) {
+    const size_t length = 4 * MIN_PARALLEL_SORT_SIZE + 3;
+
+    ipRange *ranges = malloc(length * sizeof(ipRange));
+    ipRange *expected = malloc(length * sizeof(ipRange));
+    assert_non_null(ranges);
+    assert_non_null(expected);
+
+    // 0: random keys, 1: keys sharing the highest 16 bits, 2: equal min_ip
+    for (unsigned kind = 0; kind < 3; kind++) {
+        for (size_t i = 0; i < length; i++) {
+            const uint32_t min_ip = kind == 0 ? random_address()
+                                  : kind == 1 ? 0xC0A80000 | (random_address() & 0xFFFF)
+                                  : 0xC0A80000;
+            ranges[i] = (ipRange){.min_ip = {min_ip}, .max_ip = {min_ip | (random_address() & 0xFF)}};
+        }
+        memcpy(expected, ranges, length * sizeof(ipRange));
+
+        sort_ip_ranges(expected, length);
+        sort_ip_ranges_in_parallel(ranges, length, 3);
+
+        assert_memory_equal(ranges, expected, length * sizeof(ipRange));
+    }
+
+    free(expected);
+    free(ranges);
+}
+
+
+void test_scan_ip_range_order(void **state) {
+    const ipRange canonical[] = {
+        {.min_ip = {0x0A000000}, .max_ip = {0x0A0000FF}},
+        {.min_ip = {0x0A000200}, .max_ip = {0x0A0002FF}},
+        {.min_ip = {0xFF000000}, .max_ip = {0xFFFFFFFF}},
+    };
+    const ipRange adjacent[] = {
+        {.min_ip = {0x0A000000}, .max_ip = {0x0A0000FF}},
+        {.min_ip = {0x0A000100}, .max_ip = {0x0A0001FF}},
+    };
+    const ipRange two_runs[] = {
+        {.min_ip = {0x0A000000}, .max_ip = {0x0A0000FF}},
+        {.min_ip = {0x0A000200}, .max_ip = {0x0A0002FF}},
+        {.min_ip = {0x0A000100}, .max_ip = {0x0A0001FF}},
+    };
+
+    RangeOrder order = scan_ip_range_order(canonical, 0, MAX_NATURAL_RUNS);
+    assert_int_equal(order.runs, 0);
+    assert_true(order.canonical);
+
+    order = scan_ip_range_order(canonical, 3, MAX_NATURAL_RUNS);
+    assert_int_equal(order.runs, 1);
+    assert_true(order.canonical);
+
+    order = scan_ip_range_order(adjacent, 2, MAX_NATURAL_RUNS);
+    assert_int_equal(order.runs, 1);
+    assert_false(order.canonical);
+
+    order = scan_ip_range_order(two_runs, 3, MAX_NATURAL_RUNS);
+    assert_int_equal(order.runs, 2);
+    assert_false(order.canonical);
+
+    // the scan stops as soon as the limit is exceeded
+    order = scan_ip_range_order(two_runs, 3, 1);
+    assert_int_equal(order.runs, 2);
+}
+
+
+void test_merge_sorted_runs_matches_sort(void **state) {
+    const size_t length = 10000;
+
+    ipRange *ranges = malloc(length * sizeof(ipRange));
+    ipRange *expected = malloc(length * sizeof(ipRange));
+    assert_non_null(ranges);
+    assert_non_null(expected);
+
+    for (size_t runs = 1; runs <= MAX_NATURAL_RUNS + 1; runs++) {
+        for (size_t i = 0; i < length; i++) {
+            const uint32_t min_ip = random_address() & 0xFFFFFF00;
+            ranges[i] = (ipRange){.min_ip = {min_ip}, .max_ip = {min_ip | (random_address() & 0xFF)}};
+        }
+        // uneven runs, each of them sorted on its own
+        for (size_t run = 0, start = 0; run < runs; run++) {
+            const size_t end = run + 1 == runs ? length : start + (size_t)rand() % (length - start);
+            sort_ip_ranges(ranges + start, end - start);
+            start = end;
+        }
+        memcpy(expected, ranges, length * sizeof(ipRange));
+
+        sort_ip_ranges(expected, length);
+        merge_sorted_runs(ranges, length);
+
+        assert_memory_equal(ranges, expected, length * sizeof(ipRange));
+    }
+
+    free(expected);
+    free(ranges);
+}
+
+
+void test_sort_ip_hosts_matches_qsort(void **state) {
+    const size_t LENGTHS[] = {0, 1, SMALL_SORT_THRESHOLD - 1, SMALL_SORT_THRESHOLD, 100000};
+    const size_t max_length = 100000;
+
+    uint32_t *hosts = malloc(max_length * sizeof(uint32_t));
+    uint32_t *expected = malloc(max_length * sizeof(uint32_t));
+    assert_non_null(hosts);
+    assert_non_null(expected);
+
+    for (size_t l = 0; l < sizeof(LENGTHS) / sizeof(LENGTHS[0]); l++) {
+        const size_t length = LENGTHS[l];
+        for (size_t i = 0; i < length; i++) {
+            // half of the rounds differ in the lowest bits only, so most of the passes are skipped
+            hosts[i] = l % 2 ? random_address() : 0x0A000000 | (random_address() & 0x3FF);
+        }
+        if (length) {
+            memcpy(expected, hosts, length * sizeof(uint32_t));
+        }
+
+        qsort(expected, length, sizeof(uint32_t), compare_ip_hosts);
+        sort_ip_hosts(hosts, length);
+
+        for (size_t i = 0; i < length; i++) {
+            assert_int_equal(hosts[i], expected[i]);
+        }
+
+        // the sorted hosts stay as they are, while a single one out of order is still put in place
+        sort_ip_hosts(hosts, length);
+        if (length > 1) {
+            hosts[length - 1] = 0;
+            expected[length - 1] = 0;
+            qsort(expected, length, sizeof(uint32_t), compare_ip_hosts);
+            sort_ip_hosts(hosts, length);
+        }
+        for (size_t i = 0; i < length; i++) {
+            assert_int_equal(hosts[i], expected[i]);
+        }
+    }
+
+    free(expected);
+    free(hosts);
+}
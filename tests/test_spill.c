@@ -0,0 +1,186 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "kway.h"
+#include "merge.h"
+#include "spill.h"
+
+
+void test_spilled_runs_keep_ranges(void **state) {
+    // the ranges which need the longest varints, including the edges of the address space
+    ipRangeList *list = getIpRangeList(0);
+    appendIpRange(list, &(ipRange){.min_ip = {0x00000000}, .max_ip = {0x00000000}});
+    appendIpRange(list, &(ipRange){.min_ip = {0x0000007F}, .max_ip = {0x00000080}});
+    for (uint32_t i = 1; i < 100000; i++) {
+        appendIpRange(list, &(ipRange){.min_ip = {i * 0x8000}, .max_ip = {i * 0x8000 + (i % 300)}});
+    }
+    appendIpRange(list, &(ipRange){.min_ip = {0xFFFFFFF0}, .max_ip = {0xFFFFFFFF}});
+
+    ipRangeList *empty = getIpRangeList(0);
+    SpillRuns runs = {0};
+    spill_ip_ranges(&runs, list);
+    spill_ip_ranges(&runs, empty);
+    assert_int_equal(runs.count, 2);
+
+    // the smallest buffer makes the varints split between reads
+    open_spilled_runs(&runs, 7);
+    ipRange range;
+    for (size_t i = 0; i < list->length; i++) {
+        assert_true(next_spilled_range(&runs.runs[0], &range));
+        assert_int_equal(range.min_ip.s_addr, list->cidrs[i].min_ip.s_addr);
+        assert_int_equal(range.max_ip.s_addr, list->cidrs[i].max_ip.s_addr);
+    }
+    assert_false(next_spilled_range(&runs.runs[0], &range));
+    assert_false(next_spilled_range(&runs.runs[1], &range));
+
+    free_spilled_runs(&runs);
+    assert_int_equal(runs.count, 0);
+    freeIpRangeList(empty);
+    freeIpRangeList(list);
+}
+
+
+// writes either the list or the merged streams into the buffer; goes through `tmpfile()`
+// rather than `fmemopen()`, which is not available on Windows
+static size_t write_to_buffer(const ipRangeList *list, const RangeStream *streams, const size_t count,
+                              char *buffer, const size_t size) {
+    FILE *stream = tmpfile();
+    if (!stream) {
+        return SIZE_MAX;
+    }
+    Writer *writer = open_stream_writer(stream);
+    const size_t cidr_count = list ? write_ip_ranges(list, writer) : merge_range_streams(streams, count, writer);
+    close_writer(writer);
+
+    rewind(stream);
+    const size_t length = fread(buffer, 1, size - 1, stream);
+    buffer[length] = '\0';
+    fclose(stream);
+    return cidr_count;
+}
+
+
+void test_merge_range_streams_matches_merge_cidr(void **state) {
+    // several sorted streams overlapping and touching each other, one of them is empty
+    const size_t stream_count = 5;
+    const size_t length = 20000;
+    const size_t buffer_size = 4 * 1024 * 1024;
+
+    ipRangeList *lists[5];
+    ipRangeList *all = getIpRangeList(0);
+    for (size_t s = 0; s < stream_count; s++) {
+        lists[s] = getIpRangeList(0);
+        for (size_t i = 0; s > 0 && i < length; i++) {
+            const uint32_t size = 1u << (rand() % 10);
+            const uint32_t min_ip = ((uint32_t)rand() << 9 ^ (uint32_t)rand()) & ~(size - 1);
+            appendIpRange(lists[s], &(ipRange){.min_ip = {min_ip}, .max_ip = {min_ip + size - 1}});
+        }
+        if (s == stream_count - 1) {
+            appendIpRange(lists[s], &(ipRange){.min_ip = {0xFFFFFF00}, .max_ip = {0xFFFFFFFF}});
+        }
+        appendIpRanges(all, lists[s]->cidrs, lists[s]->length);
+        merge_cidr_in_place(lists[s], NULL);
+    }
+
+    RangeStream streams[5];
+    ListCursor cursors[5];
+    for (size_t s = 0; s < stream_count; s++) {
+        cursors[s] = (ListCursor){.list = lists[s], .position = 0};
+        streams[s] = (RangeStream){.next = next_list_range, .source = &cursors[s]};
+    }
+
+    char *merged = calloc(buffer_size, 1);
+    char *expected = calloc(buffer_size, 1);
+    assert_non_null(merged);
+    assert_non_null(expected);
+
+    merge_cidr_in_place(all, NULL);
+    const size_t expected_count = write_to_buffer(all, NULL, 0, expected, buffer_size);
+    assert_int_equal(write_to_buffer(NULL, streams, stream_count, merged, buffer_size), expected_count);
+    assert_string_equal(merged, expected);
+
+    // no streams at all
+    assert_int_equal(write_to_buffer(NULL, streams, 0, merged, buffer_size), 0);
+
+    free(expected);
+    free(merged);
+    freeIpRangeList(all);
+    for (size_t s = 0; s < stream_count; s++) {
+        freeIpRangeList(lists[s]);
+    }
+}
+
+
+void test_spilled_runs_are_compacted(void **state) {
+    // enough runs for the runs of the first level to fill the fan-in and be merged into the second one
+    const size_t run_count = MAX_SPILL_FAN_IN * MAX_SPILL_FAN_IN / 2 + 100;
+    const size_t length = 40;
+    const size_t buffer_size = 4 * 1024 * 1024;
+
+    // the runs overlap each other, so merging them changes the ranges
+    SpillRuns runs = {0};
+    ipRangeList *all = getIpRangeList(0);
+    for (size_t r = 0; r < run_count; r++) {
+        ipRangeList *list = getIpRangeList(0);
+        for (size_t i = 0; i < length; i++) {
+            const uint32_t min_ip = ((uint32_t)rand() << 9 ^ (uint32_t)rand()) & 0xFFFFFF00;
+            appendIpRange(list, &(ipRange){.min_ip = {min_ip}, .max_ip = {min_ip + (uint32_t)(rand() % 1024)}});
+        }
+        merge_cidr_in_place(list, NULL);
+        appendIpRanges(all, list->cidrs, list->length);
+        spill_ip_ranges(&runs, list);
+        freeIpRangeList(list);
+
+        assert_true(runs.count <= MAX_SPILL_FAN_IN);
+    }
+    assert_true(runs.count < run_count);
+
+    // the older runs are merged more times, and nothing is merged more times than there are levels
+    for (size_t i = 1; i < runs.count; i++) {
+        assert_true(runs.runs[i - 1].level >= runs.runs[i].level);
+    }
+    assert_int_equal(runs.runs[0].level, 2);
+
+    open_spilled_runs(&runs, MIN_SPILL_BUFFER_SIZE);
+    RangeStream streams[MAX_SPILL_FAN_IN];
+    for (size_t i = 0; i < runs.count; i++) {
+        streams[i] = (RangeStream){.next = next_spilled_range, .source = &runs.runs[i]};
+    }
+
+    char *merged = calloc(buffer_size, 1);
+    char *expected = calloc(buffer_size, 1);
+    assert_non_null(merged);
+    assert_non_null(expected);
+
+    merge_cidr_in_place(all, NULL);
+    const size_t expected_count = write_to_buffer(all, NULL, 0, expected, buffer_size);
+    assert_int_equal(write_to_buffer(NULL, streams, runs.count, merged, buffer_size), expected_count);
+    assert_string_equal(merged, expected);
+
+    free(expected);
+    free(merged);
+    free_spilled_runs(&runs);
+    freeIpRangeList(all);
+}
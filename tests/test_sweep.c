@@ -0,0 +1,69 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "sort.h"
+#include "sweep.h"
+
+
+void test_sweeper_matches_scalar_implementation(void **state) {
+    const size_t max_length = 4 * SWEEP_BLOCK_SIZE * SWEEP_BLOCK_SIZE + 3;
+
+    ipRange *ranges = malloc(max_length * sizeof(ipRange));
+    ipRange *expected = malloc(max_length * sizeof(ipRange));
+    ipRange *merged = malloc(max_length * sizeof(ipRange));
+    assert_non_null(ranges);
+    assert_non_null(expected);
+    assert_non_null(merged);
+
+    const Sweeper *sweeper = get_sweeper();
+    const Sweeper *scalar = get_scalar_sweeper();
+
+    for (unsigned round = 0; round < 256; round++) {
+        const size_t length = (size_t)rand() % max_length;
+        // the narrower the address space, the more ranges overlap or touch each other;
+        // some rounds start at the first address and reach the last one
+        const uint32_t space = 0xFFFFFFFFu >> (24 + round % 8);
+        const uint32_t base = round % 3 == 0 ? 0 : 0xFFFFFFFF - space;
+
+        for (size_t i = 0; i < length; i++) {
+            const uint32_t min_ip = base + (uint32_t)rand() % space;
+            const uint32_t size = (uint32_t)rand() % 4;
+            const uint32_t max_ip = min_ip + size < min_ip ? 0xFFFFFFFF : min_ip + size;
+            ranges[i] = (ipRange){.min_ip = {min_ip}, .max_ip = {max_ip}};
+        }
+        sort_ip_ranges(ranges, length);
+
+        const size_t expected_count = scalar->sweep(ranges, length, expected);
+        assert_int_equal(sweeper->sweep(ranges, length, merged), expected_count);
+        assert_memory_equal(merged, expected, expected_count * sizeof(ipRange));
+
+        // the ranges may be merged in place
+        assert_int_equal(sweeper->sweep(ranges, length, ranges), expected_count);
+        assert_memory_equal(ranges, expected, expected_count * sizeof(ipRange));
+    }
+
+    free(merged);
+    free(expected);
+    free(ranges);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2025 Yurii Havenchuk.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "writer.h"
+
+
+#define TEST_OUTPUT_FILE "merge-ip-test-output.txt"
+
+
+static void read_file(const char *filename, char *content, const size_t size) {
+    FILE *file = fopen(filename, "rb");
+    assert_non_null(file);
+    const size_t length = fread(content, 1, size - 1, file);
+    content[length] = '\0';
+    fclose(file);
+}
+
+
+void test_file_writer_replaces_output_on_close(void **state) {
+    char content[64];
+
+    FILE *file = fopen(TEST_OUTPUT_FILE, "wb");
+    assert_non_null(file);
+    fputs("10.0.0.0/8\n", file);
+    fclose(file);
+
+    Writer *writer = open_file_writer(TEST_OUTPUT_FILE);
+    write_cidr(writer, 0x00000000, 0);
+    write_cidr(writer, 0xC0A80001, 32);
+    write_cidr(writer, 0xFFFFFFFF, 32);
+    flush_writer(writer);
+
+    // the readers of the output never see a partially written result
+    read_file(TEST_OUTPUT_FILE, content, sizeof(content));
+    assert_string_equal(content, "10.0.0.0/8\n");
+
+    close_writer(writer);
+
+    read_file(TEST_OUTPUT_FILE, content, sizeof(content));
+    assert_string_equal(content, "0.0.0.0/0\n192.168.0.1/32\n255.255.255.255/32\n");
+
+    remove(TEST_OUTPUT_FILE);
+}